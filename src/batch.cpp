@@ -0,0 +1,368 @@
+#include "batch.h"
+#include "engine_adapter.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <vector>
+
+namespace sharkwave {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Line {
+        size_t number;
+        std::string text;
+    };
+
+    struct Result {
+        size_t line = 0;
+        bool skipped = false;       // Blank or comment
+        std::string error;
+        std::string id;
+        Decision decision{};
+        double micros = 0.0;
+    };
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+        return s;
+    }
+
+    template <typename T>
+    bool parseNumber(std::string_view text, T& out) {
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+        return ec == std::errc() && end == text.data() + text.size();
+    }
+
+    // Checks shared by both input forms; fills in the defaults
+    bool finishSpot(Spot& spot, bool villainGiven, bool villainStackGiven, std::string& error) {
+        if (spot.holeCards.count != 2) {
+            error = "need exactly two hole cards";
+            return false;
+        }
+        if (spot.board.count != 0 && (spot.board.count < 3 || spot.board.count > 5)) {
+            error = "board must have 0, 3, 4 or 5 cards";
+            return false;
+        }
+        if (spot.holeCards.mask() & spot.board.mask()) {
+            error = "hole cards repeat a board card";
+            return false;
+        }
+        if (spot.pot < 0 || spot.toCall < 0 || spot.heroStack <= 0) {
+            error = "pot and to_call can't be negative, and stack must be positive";
+            return false;
+        }
+        if (!villainGiven) spot.villain = spot.position == Position::BB ? Position::BTN : Position::BB;
+        if (spot.villain == spot.position) {
+            error = "villain sits in hero's seat";
+            return false;
+        }
+        if (!villainStackGiven) spot.villainStack = spot.heroStack;
+        return true;
+    }
+
+    std::optional<Spot> parseText(std::string_view line, std::string& error) {
+        std::vector<std::string_view> fields;
+        while (!line.empty()) {
+            size_t end = 0;
+            while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end]))) ++end;
+            fields.push_back(line.substr(0, end));
+            line = trim(line.substr(end));
+        }
+        if (fields.size() != 6 && fields.size() != 7) {
+            error = "expected: position hand board pot to_call stack [villain_stack]";
+            return std::nullopt;
+        }
+
+        Spot spot;
+        std::optional<Position> pos = GameSession::positionFromString(fields[0]);
+        if (!pos) {
+            error = std::format("unknown position '{}'", fields[0]);
+            return std::nullopt;
+        }
+        spot.position = *pos;
+        if (!parseCards(fields[1], spot.holeCards) || !parseCards(fields[2], spot.board)) {
+            error = "bad cards";
+            return std::nullopt;
+        }
+        if (!parseNumber(fields[3], spot.pot) || !parseNumber(fields[4], spot.toCall) ||
+            !parseNumber(fields[5], spot.heroStack) ||
+            (fields.size() == 7 && !parseNumber(fields[6], spot.villainStack))) {
+            error = "bad number";
+            return std::nullopt;
+        }
+        if (!finishSpot(spot, false, fields.size() == 7, error)) return std::nullopt;
+        return spot;
+    }
+
+    // A flat object of string and integer values, which is all a spot needs
+    std::optional<Spot> parseJson(std::string_view line, std::string& error) {
+        Spot spot;
+        bool hasPosition = false, hasHand = false, hasPot = false, hasStack = false;
+        bool hasVillain = false, hasVillainStack = false;
+
+        size_t i = 1;
+        auto skipSpace = [&] {
+            while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+        };
+        auto readString = [&](std::string& out) {
+            if (i >= line.size() || line[i] != '"') return false;
+            for (++i; i < line.size() && line[i] != '"'; ++i) {
+                if (line[i] == '\\' && i + 1 < line.size()) ++i;
+                out += line[i];
+            }
+            if (i >= line.size()) return false;
+            ++i;
+            return true;
+        };
+
+        skipSpace();
+        while (i < line.size() && line[i] != '}') {
+            std::string key;
+            if (!readString(key)) {
+                error = "expected a quoted key";
+                return std::nullopt;
+            }
+            skipSpace();
+            if (i >= line.size() || line[i] != ':') {
+                error = std::format("expected ':' after \"{}\"", key);
+                return std::nullopt;
+            }
+            ++i;
+            skipSpace();
+
+            std::string value;
+            bool isString = i < line.size() && line[i] == '"';
+            if (isString) {
+                if (!readString(value)) {
+                    error = "unterminated string";
+                    return std::nullopt;
+                }
+            } else {
+                size_t start = i;
+                while (i < line.size() && line[i] != ',' && line[i] != '}' &&
+                       !std::isspace(static_cast<unsigned char>(line[i]))) {
+                    ++i;
+                }
+                value = line.substr(start, i - start);
+            }
+
+            bool ok = true;
+            if (key == "id") {
+                spot.id = value;
+            } else if (key == "position" || key == "villain") {
+                std::optional<Position> pos = GameSession::positionFromString(value);
+                ok = pos.has_value();
+                if (ok) (key == "position" ? spot.position : spot.villain) = *pos;
+                (key == "position" ? hasPosition : hasVillain) = ok;
+            } else if (key == "hand") {
+                ok = hasHand = parseCards(value, spot.holeCards);
+            } else if (key == "board") {
+                ok = parseCards(value, spot.board);
+            } else if (key == "pot") {
+                ok = hasPot = parseNumber(value, spot.pot);
+            } else if (key == "to_call") {
+                ok = parseNumber(value, spot.toCall);
+            } else if (key == "stack") {
+                ok = hasStack = parseNumber(value, spot.heroStack);
+            } else if (key == "villain_stack") {
+                ok = hasVillainStack = parseNumber(value, spot.villainStack);
+            } else if (key == "sb") {
+                ok = parseNumber(value, spot.sb);
+            } else if (key == "bb") {
+                ok = parseNumber(value, spot.bb);
+            }
+            if (!ok) {
+                error = std::format("bad value for \"{}\"", key);
+                return std::nullopt;
+            }
+
+            skipSpace();
+            if (i < line.size() && line[i] == ',') {
+                ++i;
+                skipSpace();
+            }
+        }
+        if (i >= line.size()) {
+            error = "missing '}'";
+            return std::nullopt;
+        }
+        if (!hasPosition || !hasHand || !hasPot || !hasStack) {
+            error = "position, hand, pot and stack are required";
+            return std::nullopt;
+        }
+        if (!finishSpot(spot, hasVillain, hasVillainStack, error)) return std::nullopt;
+        return spot;
+    }
+
+    Street streetFor(const CardSet& board) {
+        switch (board.count) {
+            case 0:  return Street::Preflop;
+            case 3:  return Street::Flop;
+            case 4:  return Street::Turn;
+            default: return Street::River;
+        }
+    }
+
+    std::string_view actionName(Action action) {
+        switch (action) {
+            case Action::Fold:  return "fold";
+            case Action::Check: return "check";
+            case Action::Call:  return "call";
+            case Action::Bet:   return "bet";
+            case Action::Raise: return "raise";
+        }
+        return "?";
+    }
+
+    std::string jsonEscape(std::string_view text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    std::string csvQuote(std::string_view text) {
+        std::string out = "\"";
+        for (char c : text) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    void writeResult(std::ostream& out, BatchFormat format, const Result& r) {
+        const Decision& d = r.decision;
+        std::string reason = d.reason.empty() ? std::string() : d.reason.text();
+        if (format == BatchFormat::Json) {
+            out << std::format("{{\"line\": {}, \"id\": \"{}\", \"action\": \"{}\", \"amount\": {}, "
+                               "\"equity\": {:.4f}, \"ci95\": {:.4f}, \"samples\": {}, "
+                               "\"micros\": {:.1f}, \"reason\": \"{}\"}}\n",
+                               r.line, jsonEscape(r.id), actionName(d.action), d.amount,
+                               d.equity.value, d.equity.ci95, d.equity.samples, r.micros,
+                               jsonEscape(reason));
+        } else {
+            out << std::format("{},{},{},{},{:.4f},{:.4f},{},{:.1f},{}\n",
+                               r.line, csvQuote(r.id), actionName(d.action), d.amount,
+                               d.equity.value, d.equity.ci95, d.equity.samples, r.micros,
+                               csvQuote(reason));
+        }
+    }
+}
+
+BatchRunner::BatchRunner(BatchConfig config)
+    : config_(config)
+{
+}
+
+std::optional<Spot> BatchRunner::parseSpot(std::string_view line, std::string& error) {
+    error.clear();
+    line = trim(line);
+    if (line.empty() || line.front() == '#') return std::nullopt;
+    return line.front() == '{' ? parseJson(line, error) : parseText(line, error);
+}
+
+void BatchRunner::writeHeader(std::ostream& out, BatchFormat format) {
+    if (format == BatchFormat::Csv) {
+        out << "line,id,action,amount,equity,ci95,samples,micros,reason\n";
+    }
+}
+
+BatchSummary BatchRunner::run(std::istream& in, std::ostream& out, BatchFormat format,
+                              std::ostream* errors) {
+    auto start = Clock::now();
+    ThreadPool pool(config_.threads);
+
+    // One engine per task slot; a chunk is split into exactly this many
+    // slices, so no two tasks ever share one
+    const size_t workers = std::max<size_t>(pool.size(), 1);
+    std::vector<std::unique_ptr<EngineAdapter>> adapters;
+    for (size_t w = 0; w < workers; ++w) {
+        adapters.push_back(std::make_unique<EngineAdapter>(config_.sb, config_.bb,
+                                                           config_.equityIterations, config_.seed));
+    }
+
+    size_t lineNumber = 0;
+    auto readChunk = [&](std::vector<Line>& chunk) {
+        chunk.clear();
+        std::string text;
+        while (chunk.size() < config_.chunkSpots && std::getline(in, text)) {
+            chunk.push_back({++lineNumber, std::move(text)});
+        }
+    };
+
+    auto decide = [&](EngineAdapter& adapter, const Line& line, Result& result) {
+        result = Result{};
+        result.line = line.number;
+        std::optional<Spot> spot = parseSpot(line.text, result.error);
+        if (!spot) {
+            result.skipped = result.error.empty();
+            return;
+        }
+        result.id = std::move(spot->id);
+
+        auto begin = Clock::now();
+        adapter.session().setBlinds(spot->sb > 0 ? spot->sb : config_.sb,
+                                    spot->bb > 0 ? spot->bb : config_.bb);
+        adapter.engine().seed(splitmix64(config_.seed ^ line.number));
+        adapter.beginHand(spot->position, spot->holeCards, spot->villain);
+        result.decision = adapter.decide(streetFor(spot->board), spot->board, spot->pot,
+                                         spot->toCall, spot->toCall, spot->heroStack,
+                                         spot->villainStack);
+        result.micros = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+    };
+
+    BatchSummary summary;
+    auto write = [&](const std::vector<Result>& results) {
+        for (const Result& r : results) {
+            if (r.skipped) continue;
+            if (!r.error.empty()) {
+                summary.errors++;
+                if (errors) *errors << std::format("line {}: {}\n", r.line, r.error);
+                continue;
+            }
+            summary.spots++;
+            writeResult(out, format, r);
+        }
+        out.flush();
+    };
+
+    // Decide one chunk while reading the next and writing the last
+    std::vector<Line> chunk, next;
+    std::vector<Result> results, previous;
+    readChunk(chunk);
+    while (!chunk.empty()) {
+        results.resize(chunk.size());
+        size_t slice = (chunk.size() + workers - 1) / workers;
+        for (size_t w = 0; w < workers; ++w) {
+            size_t begin = w * slice;
+            size_t end = std::min(chunk.size(), begin + slice);
+            if (begin >= end) break;
+            pool.submit([&, w, begin, end] {
+                for (size_t i = begin; i < end; ++i) decide(*adapters[w], chunk[i], results[i]);
+            });
+        }
+
+        write(previous);
+        readChunk(next);
+        pool.wait();
+
+        std::swap(chunk, next);
+        std::swap(results, previous);
+    }
+    write(previous);
+
+    summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return summary;
+}
+
+} // namespace sharkwave
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "card.h"
+#include "decision_engine.h"
+#include "game_session.h"
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace sharkwave {
+
+// One heads-up spot to decide, as read from a batch file
+struct Spot {
+    std::string id;                     // Echoed back; empty if not given
+    Position position = Position::BTN;
+    Position villain = Position::BB;
+    CardSet holeCards;
+    CardSet board;                      // 0, 3, 4 or 5 cards; sets the street
+    int64_t pot = 0;
+    int64_t toCall = 0;
+    int64_t heroStack = 0;
+    int64_t villainStack = 0;
+    int sb = 0;                         // 0 = the batch default
+    int bb = 0;
+};
+
+enum class BatchFormat {
+    Csv,
+    Json        // One object per line
+};
+
+struct BatchConfig {
+    size_t threads = 0;         // 0 = hardware concurrency
+    int equityIterations = 500;
+    uint64_t seed = 1;          // Each spot's sampler is seeded from this and its line
+    size_t chunkSpots = 4096;   // Spots read, decided and written per round
+    int sb = 5;
+    int bb = 10;
+};
+
+struct BatchSummary {
+    size_t spots = 0;
+    size_t errors = 0;
+    double seconds = 0.0;
+};
+
+// Decides a stream of spots on a worker pool. Every worker owns its own
+// GameSession and DecisionEngine (an EngineAdapter), built once, so a spot
+// costs one decision and no setup. Results come out in input order, a
+// chunk at a time, while the next chunk is still being read, so any size
+// of input runs in bounded memory. Seeding by line makes the output the
+// same for any thread count.
+class BatchRunner {
+public:
+    explicit BatchRunner(BatchConfig config);
+
+    // Bad lines are reported to `errors` (if given) and skipped
+    BatchSummary run(std::istream& in, std::ostream& out, BatchFormat format,
+                     std::ostream* errors = nullptr);
+
+    // A spot is either a JSON object on one line,
+    //   {"id": "s1", "position": "BTN", "hand": "AhKd", "board": "Qs7c2d",
+    //    "pot": 30, "to_call": 10, "stack": 990, "villain_stack": 990}
+    // (optional: id, board, to_call, villain_stack, villain, sb, bb), or the
+    // compact text form
+    //   BTN AhKd Qs7c2d 30 10 990 [villain_stack]
+    // with "-" for an empty board. Blank lines and lines starting with '#'
+    // give std::nullopt and no error.
+    static std::optional<Spot> parseSpot(std::string_view line, std::string& error);
+
+    static void writeHeader(std::ostream& out, BatchFormat format);
+
+private:
+    BatchConfig config_;
+};
+
+} // namespace sharkwave
@@ -0,0 +1,90 @@
+#include "board_texture.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace sharkwave {
+
+namespace {
+    constexpr uint32_t kRankBits = 0x1FFF;
+
+    // Ranks with the ace copied below the deuce, so A-2-3-4-5 is a run too
+    constexpr uint32_t withLowAce(uint32_t ranks) {
+        return (ranks << 1) | ((ranks >> 12) & 1);
+    }
+
+    constexpr bool hasStraight(uint32_t ranks) {
+        uint32_t r = withLowAce(ranks);
+        return (r & (r >> 1) & (r >> 2) & (r >> 3) & (r >> 4)) != 0;
+    }
+
+    struct RankFeatures {
+        uint8_t connectedness;
+        uint8_t highTier;
+        uint8_t straightHands;
+        uint8_t straightRanks;
+    };
+
+    constexpr RankFeatures rankFeatures(uint32_t ranks) {
+        RankFeatures f{};
+        uint32_t low = withLowAce(ranks);
+        for (int start = 0; start <= 9; ++start) {
+            int count = std::popcount((low >> start) & 0x1Fu);
+            if (count > f.connectedness) f.connectedness = static_cast<uint8_t>(count);
+        }
+
+        int high = ranks ? std::bit_width(ranks) - 1 : 0;     // 0 = deuce
+        f.highTier = high == 12 ? 3 : high == 11 ? 2 : high >= 8 ? 1 : 0;
+
+        for (int a = 0; a < 13; ++a) {
+            uint32_t withA = ranks | (1u << a);
+            if (hasStraight(withA)) f.straightRanks++;
+            for (int b = a + 1; b < 13; ++b) {
+                if (hasStraight(withA | (1u << b))) f.straightHands++;
+            }
+        }
+        return f;
+    }
+
+    // Rank features of every set of board ranks
+    constexpr auto kRankTable = [] {
+        std::array<RankFeatures, kRankBits + 1> table{};
+        for (uint32_t ranks = 0; ranks <= kRankBits; ++ranks) table[ranks] = rankFeatures(ranks);
+        return table;
+    }();
+}
+
+BoardTexture describeBoard(CardMask board) {
+    BoardTexture t;
+    if (std::popcount(board) < 3) return t;
+
+    uint32_t s0 = static_cast<uint32_t>(board) & kRankBits;
+    uint32_t s1 = static_cast<uint32_t>(board >> 13) & kRankBits;
+    uint32_t s2 = static_cast<uint32_t>(board >> 26) & kRankBits;
+    uint32_t s3 = static_cast<uint32_t>(board >> 39) & kRankBits;
+    uint32_t ranks = s0 | s1 | s2 | s3;
+
+    int maxSuit = std::max({std::popcount(s0), std::popcount(s1), std::popcount(s2), std::popcount(s3)});
+    t.suits = static_cast<SuitTexture>(std::min(maxSuit, 4) - 1);
+
+    // A rank held in three suits is trips; otherwise every extra card is a pair
+    uint32_t trips = (s0 & s1 & (s2 | s3)) | (s2 & s3 & (s0 | s1));
+    int extra = std::popcount(board) - std::popcount(ranks);
+    t.pairing = trips ? Pairing::Trips : static_cast<Pairing>(std::min(extra, 2));
+
+    const RankFeatures& f = kRankTable[ranks];
+    t.connectedness = f.connectedness;
+    t.highTier = f.highTier;
+    t.straightHands = f.straightHands;
+    t.straightRanks = f.straightRanks;
+
+    if (t.suits >= SuitTexture::Monotone) t.type = TextureClass::Monotone;
+    else if (t.flushDraw() && t.straightDraw()) t.type = TextureClass::Dynamic;
+    else if (t.straightDraw()) t.type = TextureClass::Connected;
+    else if (t.flushDraw()) t.type = TextureClass::TwoTone;
+    else if (t.pairing != Pairing::Unpaired) t.type = TextureClass::Paired;
+    else t.type = t.highTier >= 2 ? TextureClass::DryHigh : TextureClass::DryLow;
+    return t;
+}
+
+} // namespace sharkwave
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "card.h"
+#include <cstdint>
+
+namespace sharkwave {
+
+// Most cards of any one suit: 1, 2, 3, 4 or more
+enum class SuitTexture : uint8_t {
+    Rainbow,
+    TwoTone,        // A flush draw is possible
+    Monotone,       // Three of a suit: a flush is possible
+    FourFlush       // One card of the suit makes a flush
+};
+
+enum class Pairing : uint8_t {
+    Unpaired,
+    Paired,
+    TwoPair,
+    Trips           // Also full houses and quads
+};
+
+// What kind of board it is, for c-bet and fold-equity rules; each class is
+// a step wetter than the one before
+enum class TextureClass : uint8_t {
+    DryHigh,        // Ace or king high, rainbow, nothing connected: A82r
+    DryLow,         // Rainbow and disconnected, queen high or lower: 952r
+    Paired,         // Paired, no flush or straight draws: 77-3r
+    TwoTone,        // A flush draw but no straight draws: K84 two-tone
+    Connected,      // Straight draws but no flush draw: T98r
+    Dynamic,        // Flush and straight draws: JT8 two-tone
+    Monotone        // A flush is already possible
+};
+
+// Everything the engine reads about a board, packed into a word
+struct BoardTexture {
+    TextureClass type = TextureClass::DryLow;
+    SuitTexture suits = SuitTexture::Rainbow;
+    Pairing pairing = Pairing::Unpaired;
+    uint8_t connectedness = 0;  // Most ranks inside one five-rank straight window (aces play low too)
+    uint8_t highTier = 0;       // 0: nine high or lower, 1: ten to queen, 2: king, 3: ace
+    uint8_t straightHands = 0;  // Of the 78 unpaired two-rank holdings, how many have a straight
+    uint8_t straightRanks = 0;  // Ranks that make a straight with any other card
+
+    bool flushDraw() const { return suits >= SuitTexture::TwoTone; }
+    bool straightDraw() const { return connectedness >= 3; }
+
+    // 0 dry, 1 wet, 2 very wet: the three levels the engine's rules tune
+    // thresholds for
+    int wetness() const {
+        return type <= TextureClass::Paired ? 0 : type <= TextureClass::Connected ? 1 : 2;
+    }
+};
+
+static_assert(sizeof(BoardTexture) <= 8);
+
+// O(1): suits and pairing come from a few popcounts on the mask, and the
+// rank features from a compile-time table over all 8192 sets of board
+// ranks (which with them is every canonical board). Fewer than three cards
+// count as a dry, low board.
+BoardTexture describeBoard(CardMask board);
+
+} // namespace sharkwave
@@ -1,8 +1,38 @@
 #include "card.h"
+#include <cctype>
 #include <format>
+#include <optional>
 
 namespace sharkwave {
 
+namespace {
+    std::optional<Card> parseCard(std::string_view text) {
+        if (text.size() != 2) return std::nullopt;
+        constexpr std::string_view kRanks = "23456789TJQKA";
+        constexpr std::string_view kSuits = "cdhs";
+        size_t rank = kRanks.find(static_cast<char>(std::toupper(static_cast<unsigned char>(text[0]))));
+        size_t suit = kSuits.find(static_cast<char>(std::tolower(static_cast<unsigned char>(text[1]))));
+        if (rank == std::string_view::npos || suit == std::string_view::npos) return std::nullopt;
+        return Card(static_cast<Rank>(rank + 2), static_cast<Suit>(suit));
+    }
+}
+
+bool parseCards(std::string_view text, CardSet& out) {
+    out.clear();
+    if (text == "-") return true;
+    std::string compact;
+    for (char c : text) {
+        if (!std::isspace(static_cast<unsigned char>(c))) compact += c;
+    }
+    if (compact.size() % 2 != 0 || compact.size() / 2 > CardSet::MAX_CARDS) return false;
+    for (size_t i = 0; i < compact.size(); i += 2) {
+        std::optional<Card> card = parseCard(std::string_view(compact).substr(i, 2));
+        if (!card || out.contains(*card)) return false;
+        out.add(*card);
+    }
+    return true;
+}
+
 std::string Card::toString() const {
     return std::string{} + rankChar() + suitChar();
 }
@@ -62,6 +92,14 @@ void CardSet::remove(Card card) {
     }
 }
 
+CardMask CardSet::mask() const {
+    CardMask m = 0;
+    for (size_t i = 0; i < count; ++i) {
+        m |= cardBit(cards[i]);
+    }
+    return m;
+}
+
 bool CardSet::contains(Card card) const {
     for (size_t i = 0; i < count; ++i) {
         if (cards[i] == card) {
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <array>
 
 namespace sharkwave {
@@ -58,6 +59,22 @@ private:
     Suit suit_;
 };
 
+// Bit index of a card in a CardMask: suit-major, so each suit's ranks form
+// a contiguous 13-bit field (bit 0 of the field = Two)
+using CardMask = uint64_t;
+
+constexpr int cardIndex(Card c) {
+    return static_cast<int>(c.suit()) * 13 + (static_cast<int>(c.rank()) - 2);
+}
+
+constexpr Card cardFromIndex(int index) {
+    return Card(static_cast<Rank>(index % 13 + 2), static_cast<Suit>(index / 13));
+}
+
+constexpr CardMask cardBit(Card c) {
+    return CardMask{1} << cardIndex(c);
+}
+
 class CardSet {
 public:
     static constexpr size_t MAX_CARDS = 7;
@@ -69,11 +86,16 @@ public:
     bool contains(Card card) const;
     size_t size() const { return count; }
     bool isEmpty() const { return count == 0; }
+    CardMask mask() const;
 
     Card cards[MAX_CARDS];
     size_t count = 0;
 };
 
+// "AhKd", "Qs7c2d", "Qs 7c 2d" or "-" for none; any case. False on a bad
+// or repeated card, or more than MAX_CARDS.
+bool parseCards(std::string_view text, CardSet& out);
+
 constexpr Suit allSuits[] = {Suit::Clubs, Suit::Diamonds, Suit::Hearts, Suit::Spades};
 constexpr Rank allRanks[] = {
     Rank::Two, Rank::Three, Rank::Four, Rank::Five, Rank::Six,
@@ -0,0 +1,82 @@
+#include "checkpoint.h"
+#include <bit>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+namespace sharkwave {
+
+namespace {
+    constexpr std::string_view kHeader = "sharkwave-checkpoint 1";
+}
+
+void Checkpoint::setInt(std::string_view key, int64_t value) {
+    values_.insert_or_assign(std::string(key), static_cast<uint64_t>(value));
+}
+
+void Checkpoint::setUint(std::string_view key, uint64_t value) {
+    values_.insert_or_assign(std::string(key), value);
+}
+
+void Checkpoint::setDouble(std::string_view key, double value) {
+    values_.insert_or_assign(std::string(key), std::bit_cast<uint64_t>(value));
+}
+
+bool Checkpoint::has(std::string_view key) const {
+    return values_.find(key) != values_.end();
+}
+
+int64_t Checkpoint::getInt(std::string_view key, int64_t fallback) const {
+    auto it = values_.find(key);
+    return it != values_.end() ? static_cast<int64_t>(it->second) : fallback;
+}
+
+uint64_t Checkpoint::getUint(std::string_view key, uint64_t fallback) const {
+    auto it = values_.find(key);
+    return it != values_.end() ? it->second : fallback;
+}
+
+double Checkpoint::getDouble(std::string_view key, double fallback) const {
+    auto it = values_.find(key);
+    return it != values_.end() ? std::bit_cast<double>(it->second) : fallback;
+}
+
+bool Checkpoint::save(const std::string& path) const {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) return false;
+        out << kHeader << "\n";
+        for (const auto& [key, value] : values_) {
+            out << std::format("{} {:016x}\n", key, value);
+        }
+        out.flush();
+        if (!out) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+std::optional<Checkpoint> Checkpoint::load(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line) || line != kHeader) {
+        return std::nullopt;
+    }
+
+    Checkpoint checkpoint;
+    while (std::getline(in, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos) return std::nullopt;
+        try {
+            checkpoint.values_[line.substr(0, space)] = std::stoull(line.substr(space + 1), nullptr, 16);
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    return checkpoint;
+}
+
+} // namespace sharkwave
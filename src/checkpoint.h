@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sharkwave {
+
+// Flat key/value snapshot of a long run. Stored as text so it survives
+// rebuilds; doubles are kept as their raw bits so a resumed run continues
+// bit-for-bit rather than from a rounded copy.
+class Checkpoint {
+public:
+    void setInt(std::string_view key, int64_t value);
+    void setUint(std::string_view key, uint64_t value);
+    void setDouble(std::string_view key, double value);
+
+    bool has(std::string_view key) const;
+    int64_t getInt(std::string_view key, int64_t fallback = 0) const;
+    uint64_t getUint(std::string_view key, uint64_t fallback = 0) const;
+    double getDouble(std::string_view key, double fallback = 0.0) const;
+
+    // Writes a temporary file next to `path` and renames it into place, so a
+    // crash mid-write leaves the previous checkpoint intact
+    bool save(const std::string& path) const;
+    static std::optional<Checkpoint> load(const std::string& path);
+
+private:
+    std::map<std::string, uint64_t, std::less<>> values_;   // Raw 64-bit payloads
+};
+
+} // namespace sharkwave
@@ -1,408 +1,601 @@
 #include "decision_engine.h"
 #include "gto_charts.h"
+#include "preflop_strategy.h"
+#include "river_solver.h"
 #include <format>
 #include <algorithm>
+#include <bit>
 #include <cmath>
 #include <array>
+#include <random>
 
 namespace sharkwave {
 
 namespace {
+    // Anytime equity: samples per refinement step, and when to stop early
+    constexpr int kEquityBatch = 64;
+    constexpr int kMinAnytimeSamples = 256;
+    constexpr int kMaxAnytimeSamples = 100000;
+    constexpr double kTargetEquityCi = 0.005;
+
+    // Under a deadline the river solve runs only as many iterations as fit,
+    // and a solve cut off before this many is worse than the rules
+    constexpr int kMinAnytimeSolveIterations = 10;
+
+    // Order of action after the flop: the small blind first, the button last
+    constexpr int postflopOrder(Position pos) { return (static_cast<int>(pos) + 2) % 6; }
+
+    // Observations the spot-based fold equity prior is worth against an
+    // opponent's recorded folds
+    constexpr double kFoldPriorWeight = 20.0;
+
     // Local helper functions (not in hand_evaluator namespace)
     constexpr int rankToInt(Rank r) { return static_cast<int>(r); }
 
-    std::array<int, 15> countRanks(const Card* cards, size_t count) {
-        std::array<int, 15> counts{};
-        for (size_t i = 0; i < count; ++i) {
-            counts[rankToInt(cards[i].rank())]++;
-        }
-        return counts;
-    }
-
-    std::array<int, 4> countSuits(const Card* cards, size_t count) {
-        std::array<int, 4> counts{};
-        for (size_t i = 0; i < count; ++i) {
-            counts[static_cast<int>(cards[i].suit())]++;
-        }
-        return counts;
-    }
+    constexpr uint32_t kRankBits = 0x1FFF;
+
+    // One suit's ranks from a CardMask, bit (rank - 2)
+    constexpr uint32_t suitRanks(CardMask cards, int suit) {
+        return static_cast<uint32_t>(cards >> (13 * suit)) & kRankBits;
+    }
+
+    constexpr uint32_t rankUnion(CardMask cards) {
+        return suitRanks(cards, 0) | suitRanks(cards, 1) | suitRanks(cards, 2) | suitRanks(cards, 3);
+    }
+}
+
+std::string Reason::text() const {
+    std::string pct = std::format("{:.1f}%", equity * 100.0);
+    int n = outs;
+
+    switch (code) {
+        case ReasonCode::None: return "";
+        case ReasonCode::UnknownStreet: return "Unknown street";
+        case ReasonCode::OpenTooWeak: return "Too weak to open from this position";
+        case ReasonCode::OpenBestHand: return "Best hand. Raising for value and isolation.";
+        case ReasonCode::OpenRaise: return "Raising for value and initiative";
+        case ReasonCode::OpenAllIn: return "All-in for value with premium hand";
+        case ReasonCode::OpenNotInRange: return "Hand not in opening range";
+        case ReasonCode::OpenMixRaise: return std::format("Chart opens this hand {}% of the time", n);
+        case ReasonCode::OpenMixFold: return std::format("Chart folds this hand {}% of the time", n);
+        case ReasonCode::VsRaiseFold: return "Not in the range that continues against this raise";
+        case ReasonCode::VsRaiseCall: return "In the calling range against this raise";
+        case ReasonCode::VsRaise3bet: return "3-bet for value";
+        case ReasonCode::VsRaiseAllIn: return "Shove over the raise";
+        case ReasonCode::VsRaiseCallAllIn: return "In the range that calls this all-in";
+        case ReasonCode::VsRaiseMixFold: return std::format("Chart folds this hand {}% of the time", n);
+        case ReasonCode::VsRaiseMixCall: return std::format("Chart calls with this hand {}% of the time", n);
+        case ReasonCode::VsRaiseMix3bet: return std::format("Chart 3-bets this hand {}% of the time", n);
+        case ReasonCode::Vs3betFold: return "Not in the range that continues against this 3-bet";
+        case ReasonCode::Vs3betCall: return "In the calling range against this 3-bet";
+        case ReasonCode::Vs3bet4bet: return "4-bet for value";
+        case ReasonCode::Vs3betAllIn: return "Shove over the 3-bet";
+        case ReasonCode::Vs3betCallAllIn: return "In the range that calls this all-in";
+        case ReasonCode::Vs3betMixFold: return std::format("Chart folds this hand {}% of the time", n);
+        case ReasonCode::Vs3betMixCall: return std::format("Chart calls with this hand {}% of the time", n);
+        case ReasonCode::Vs3betMix4bet: return std::format("Chart 4-bets this hand {}% of the time", n);
+        case ReasonCode::Vs4betAllInPremium: return "All-in with premiums";
+        case ReasonCode::Vs4betAllInQueens: return "All-in with QQ+";
+        case ReasonCode::Vs4betFold: return "Fold to 4-bet without premiums";
+        case ReasonCode::FlopRaiseStrong:
+            return std::format("Strong hand ({} equity). Raise for value", pct);
+        case ReasonCode::FlopCallMadeHand:
+            return std::format("Good made hand ({} equity). Call for value", pct);
+        case ReasonCode::FlopCallFlushDraw:
+            return std::format("Flush draw ({} equity). Call with good odds", pct);
+        case ReasonCode::FlopCallStrongDraw:
+            return std::format("Strong draw ({} outs, {} equity). Call.", n, pct);
+        case ReasonCode::FlopBluffCatch:
+            return std::format("Bluff catch ({} equity) with good pot odds", pct);
+        case ReasonCode::FlopFoldWeak:
+            return std::format("Weak hand ({} equity). Fold to bet", pct);
+        case ReasonCode::FlopCallMarginal:
+            return std::format("Marginal hand ({} equity). Call to see turn", pct);
+        case ReasonCode::FlopValueBet:
+            return std::format("Value bet with strong hand ({} equity)", pct);
+        case ReasonCode::FlopSemiBluffDry:
+            return std::format("Semi-bluff with {} outs ({} equity). Good fold equity on dry board.", n, pct);
+        case ReasonCode::FlopSemiBluffWet:
+            return std::format("Semi-bluff with {} outs ({} equity) on wet board", n, pct);
+        case ReasonCode::FlopCbetDry:
+            return std::format("C-bet on dry board ({} equity). Good fold equity.", pct);
+        case ReasonCode::FlopCbetWet:
+            return std::format("C-bet on wet board ({} equity) with showdown value", pct);
+        case ReasonCode::FlopCbetValue:
+            return std::format("Value c-bet ({} equity) with decent hand", pct);
+        case ReasonCode::FlopCheckWet:
+            return std::format("Check on wet board ({} equity). Pot control with marginal hand.", pct);
+        case ReasonCode::FlopCheckWeak:
+            return std::format("Check with weak hand ({} equity). Control pot size", pct);
+        case ReasonCode::TurnRaiseMonster:
+            return std::format("Monster ({} equity). Raise for value", pct);
+        case ReasonCode::TurnCallStrong:
+            return std::format("Strong hand ({} equity). Call down", pct);
+        case ReasonCode::TurnCallTwoPair:
+            return std::format("Value call with two pair+ ({} equity)", pct);
+        case ReasonCode::TurnFoldTwoPair:
+            return std::format("Pot too large, fold ({} equity)", pct);
+        case ReasonCode::TurnCallDraw:
+            return std::format("Call with {} outs ({} equity) and good odds", n, pct);
+        case ReasonCode::TurnBluffCatch:
+            return std::format("Bluff catch ({} equity) in big pot", pct);
+        case ReasonCode::TurnFoldWeak:
+            return std::format("Weak hand ({} equity). Fold", pct);
+        case ReasonCode::TurnCallShowdown:
+            return std::format("Showdown value call ({} equity)", pct);
+        case ReasonCode::TurnValueBet:
+            return std::format("Value bet with very strong hand ({} equity)", pct);
+        case ReasonCode::TurnBarrel:
+            return std::format("Turn barrel for value ({} equity)", pct);
+        case ReasonCode::TurnBluff:
+            return std::format("Bluff on dry turn ({} equity) with equity", pct);
+        case ReasonCode::TurnCheckPair:
+            return std::format("Check back with one pair ({} equity) for pot control", pct);
+        case ReasonCode::TurnCheckMarginal: return "Check with marginal hand";
+        case ReasonCode::RiverCallStraight:
+            return std::format("Call with straight ({} equity). Nutted.", pct);
+        case ReasonCode::RiverCallFlush:
+            return std::format("Call with flush ({} equity). Nutted.", pct);
+        case ReasonCode::RiverCallSet:
+            return std::format("Call with set+ ({} equity). Likely good.", pct);
+        case ReasonCode::RiverCallTwoPair:
+            return std::format("Call with two pair ({} equity). Good enough.", pct);
+        case ReasonCode::RiverFoldTwoPair:
+            return std::format("Two pair ({} equity) but facing big bet. Fold.", pct);
+        case ReasonCode::RiverBluffCatch:
+            return std::format("Bluff catch ({} equity) in massive pot", pct);
+        case ReasonCode::RiverFoldWeak:
+            return std::format("Weak hand ({} equity). Fold to bet", pct);
+        case ReasonCode::RiverValueNutted:
+            return std::format("Big value bet with nutted hand ({} equity)", pct);
+        case ReasonCode::RiverValueSet:
+            return std::format("Value bet with set ({} equity)", pct);
+        case ReasonCode::RiverValueTwoPair:
+            return std::format("Value bet with two pair ({} equity)", pct);
+        case ReasonCode::RiverValueTopPairGreat:
+            return std::format("Value bet top pair great kicker ({} equity)", pct);
+        case ReasonCode::RiverValueTopPairGood:
+            return std::format("Medium value bet top pair good kicker ({} equity)", pct);
+        case ReasonCode::RiverThinValue:
+            return std::format("Thin value bet ({} equity)", pct);
+        case ReasonCode::RiverCheckPair:
+            return std::format("Check with marginal pair ({} equity). Showdown value.", pct);
+        case ReasonCode::RiverBluff: return "Bluff with missed draw on dry board. Represent something.";
+        case ReasonCode::RiverCheckShowdown:
+            return std::format("Check at showdown ({} equity). Can't value bet weak hands", pct);
+        case ReasonCode::RiverSolverMix:
+            return std::format("River solver takes this line {}% of the time ({} equity)", n, pct);
+    }
+    return "";
 }
 
 DecisionEngine::DecisionEngine(GameSession& session)
     : session_(session)
+    , equityIterations_(500)
+    , rng_(std::random_device{}())
+    , rangeTracking_(true)
+    , riverSolveIterations_(0)
+    , solverPool_(nullptr)
 {
 }
 
 Decision DecisionEngine::makeDecision() {
-    switch (session_.street()) {
-        case Street::Preflop:  return decidePreflop();
-        case Street::Flop:     return decideFlop();
-        case Street::Turn:     return decideTurn();
-        case Street::River:    return decideRiver();
-        default:               return Decision::fold("Unknown street");
-    }
-}
-
-Decision DecisionEngine::decidePreflop() {
-    (void)bigBlindsRemaining(); // Cache for potential use
-    (void)getPosition(); // Cache for potential use
-
-    // Unopened pot (we're first to act or everyone folded to us)
-    // Simplified: assume unopened for now
-    return decidePreflopUnopened();
-}
-
-Decision DecisionEngine::decidePreflopUnopened() {
-    int bb = bigBlindsRemaining();
-    Position pos = getPosition();
-    HandCategory category = categorizeHoleCards();
-    (void)category; // May be used later
-
-    // Get GTO action from charts
-    GtoDecision gto = GtoCharts::getAction(pos, session_.heroCards(), bb, false);
+    samplingDeadline_.reset();
+    return decideStreet();
+}
+
+Decision DecisionEngine::makeDecision(Clock::time_point deadline) {
+    // Leave part of the budget for the rules that run after the equity
+    // estimate. With nothing left the sampling deadline is already past and
+    // equity comes from a single batch.
+    Clock::duration left = std::max<Clock::duration>(deadline - Clock::now(), Clock::duration::zero());
+    Clock::duration reserve = std::min<Clock::duration>(left / 4, std::chrono::microseconds(50));
+    samplingDeadline_ = deadline - reserve;
+    Decision decision = decideStreet();
+    samplingDeadline_.reset();
+    return decision;
+}
+
+Decision DecisionEngine::decideStreet() {
+    lastEquity_ = {};
+    HandContext ctx = buildContext();
+    Decision decision = [&] {
+        switch (ctx.street) {
+            case Street::Preflop:  return decidePreflop(ctx);
+            case Street::Flop:     return decideFlop(ctx);
+            case Street::Turn:     return decideTurn(ctx);
+            case Street::River:    return decideRiver(ctx);
+            default:               return Decision::fold(ReasonCode::UnknownStreet);
+        }
+    }();
+    decision.equity = lastEquity_;
+    return decision;
+}
+
+DecisionEngine::HandContext DecisionEngine::buildContext() {
+    ranges_.update(session_);
+
+    HandContext ctx;
+    ctx.street = session_.street();
+    ctx.position = getPosition();
+    ctx.heroCards = session_.heroCards();
+    ctx.board = session_.board();
+    CardMask hole = ctx.heroCards.mask();
+    CardMask board = ctx.board.mask();
+    ctx.combined = hole | board;
+
+    ctx.pot = session_.pot();
+    ctx.toCall = session_.toCall();
+    ctx.heroStack = session_.heroStack();
+    ctx.bigBlinds = bigBlindsRemaining();
+    ctx.spr = session_.spr();
+    ctx.potOdds = session_.potOdds();
+
+    if (ctx.street == Street::Preflop) {
+        ctx.category = categorizeHoleCards(ctx.heroCards);
+    } else if (ctx.street <= Street::River) {
+        ctx.hand = HandEvaluator::evaluate(ctx.combined);
+        ctx.outs = HandEvaluator::countOuts(hole, board);
+        ctx.flushDraw = HandEvaluator::hasFlushDraw(hole, board);
+        ctx.texture = describeBoard(board);
+        ctx.equity = estimateEquity();
+    }
+    return ctx;
+}
+
+Decision DecisionEngine::decidePreflop(const HandContext& ctx) {
+    // Blinds aren't logged, so the first bet or raise is the open
+    int raises = 0;
+    for (const ActionRecord& record : session_.actions().onStreet(Street::Preflop)) {
+        if (record.aggressive()) ++raises;
+    }
+    bool heroRaised = session_.actions().lastAggressive(Street::Preflop, ctx.position) != nullptr;
+
+    if (raises == 0) return decidePreflopUnopened(ctx);
+    if (raises == 1 && !heroRaised) return decidePreflopVsRaise(ctx);
+    if (raises == 2) return decidePreflopVs3bet(ctx);
+    return decidePreflopVs4bet(ctx);
+}
+
+Decision DecisionEngine::decidePreflopUnopened(const HandContext& ctx) {
+    // Get GTO action from charts, mixing where the chart does
+    GtoDecision gto = GtoCharts::getAction(ctx.position, ctx.heroCards, ctx.bigBlinds, false, rng_,
+                                           session_.playerCount());
+    int percent = static_cast<int>(std::lround(gto.frequency * 100.0 / 255.0));
+    bool mixed = gto.frequency < 255;
 
     switch (gto.action) {
         case GtoAction::Fold:
-            return Decision::fold("Too weak to open from this position");
+            if (mixed) return Decision::fold({ReasonCode::OpenMixFold, 0.0, percent});
+            return Decision::fold(ReasonCode::OpenTooWeak);
 
         case GtoAction::Call:
             // Opening can't be a call, but chart might return this for vs-raise
-            return Decision::raise(getOpenRaiseSize(),
-                "Best hand. Raising for value and isolation.");
+            return Decision::raise(getOpenRaiseSize(ctx),
+                ReasonCode::OpenBestHand);
 
         case GtoAction::Raise:
-            return Decision::raise(getOpenRaiseSize(),
-                "Raising for value and initiative");
+            if (mixed) return Decision::raise(getOpenRaiseSize(ctx), {ReasonCode::OpenMixRaise, 0.0, percent});
+            return Decision::raise(getOpenRaiseSize(ctx),
+                ReasonCode::OpenRaise);
 
         case GtoAction::AllIn:
-            return Decision::raise(session_.heroStack(),
-                "All-in for value with premium hand");
+            return Decision::raise(ctx.heroStack,
+                ReasonCode::OpenAllIn);
 
         default:
-            return Decision::fold("Hand not in opening range");
+            return Decision::fold(ReasonCode::OpenNotInRange);
     }
 }
 
-Decision DecisionEngine::decidePreflopVsRaise() {
-    // This would be called when facing a raise before us
-    // For MVP, simplified logic
-    HandCategory category = categorizeHoleCards();
-    int64_t raiseAmt = session_.toCall();
+Decision DecisionEngine::decidePreflopVsRaise(const HandContext& ctx) {
+    // Under 25bb the charts take the raise for a shove and answer from
+    // their call ranges
+    GtoDecision gto = GtoCharts::getAction(ctx.position, ctx.heroCards, ctx.bigBlinds, true, rng_,
+                                           session_.playerCount());
+    int percent = static_cast<int>(std::lround(gto.frequency * 100.0 / 255.0));
+    bool mixed = gto.frequency < 255;
 
-    switch (category) {
-        case HandCategory::Premium:
-            return Decision::raise(get3betSize(), "Premium hand. 3-bet for value");
+    // Nothing left to raise into an all-in: whatever the chart plays, calls
+    bool allIn = facingAllIn(ctx);
+    int64_t callAmt = std::min(ctx.toCall, ctx.heroStack);
 
-        case HandCategory::Strong:
-            if (bigBlindsRemaining() > 100) {
-                return Decision::call(raiseAmt, "Strong hand. Call in position");
-            }
-            return Decision::raise(get3betSize(), "Strong hand. 3-bet or ship");
+    switch (gto.action) {
+        case GtoAction::Fold:
+            if (mixed) return Decision::fold({ReasonCode::VsRaiseMixFold, 0.0, percent});
+            return Decision::fold(ReasonCode::VsRaiseFold);
 
-        case HandCategory::Medium:
-            if (raiseAmt <= session_.pot() * 0.3) {
-                return Decision::call(raiseAmt, "Medium hand. Good pot odds to call");
-            }
-            return Decision::fold("Medium hand. Fold to large raise");
+        case GtoAction::Call:
+            if (mixed) return Decision::call(callAmt, {ReasonCode::VsRaiseMixCall, 0.0, percent});
+            return Decision::call(callAmt, ReasonCode::VsRaiseCall);
+
+        case GtoAction::Raise:
+            if (allIn) return Decision::call(callAmt, ReasonCode::VsRaiseCallAllIn);
+            if (mixed) return Decision::raise(get3betSize(ctx), {ReasonCode::VsRaiseMix3bet, 0.0, percent});
+            return Decision::raise(get3betSize(ctx), ReasonCode::VsRaise3bet);
+
+        case GtoAction::AllIn:
+            if (allIn) return Decision::call(callAmt, ReasonCode::VsRaiseCallAllIn);
+            return Decision::raise(ctx.heroStack, ReasonCode::VsRaiseAllIn);
 
         default:
-            return Decision::fold("Weak hand. Fold to aggression");
+            return Decision::fold(ReasonCode::VsRaiseFold);
     }
 }
 
-Decision DecisionEngine::decidePreflopVs3bet() {
-    HandCategory category = categorizeHoleCards();
+Decision DecisionEngine::decidePreflopVs3bet(const HandContext& ctx) {
+    GtoDecision gto = GtoCharts::getAction(ctx.position, ctx.heroCards, ctx.bigBlinds, PreflopSpot::Vs3bet,
+                                           rng_, session_.playerCount());
+    int percent = static_cast<int>(std::lround(gto.frequency * 100.0 / 255.0));
+    bool mixed = gto.frequency < 255;
 
-    switch (category) {
-        case HandCategory::Premium:
-        case HandCategory::Strong:
-            if (bigBlindsRemaining() < 50) {
-                return Decision::raise(session_.heroStack(), "All-in with strong hand");
-            }
-            return Decision::raise(get4betSize(), "4-bet for value");
+    bool allIn = facingAllIn(ctx);
+    int64_t callAmt = std::min(ctx.toCall, ctx.heroStack);
 
-        case HandCategory::Medium:
-            if (session_.potOdds() < 0.3) {
-                return Decision::call(session_.toCall(), "Call with decent pot odds");
-            }
-            return Decision::fold("Fold medium hand to 3-bet");
+    switch (gto.action) {
+        case GtoAction::Fold:
+            if (mixed) return Decision::fold({ReasonCode::Vs3betMixFold, 0.0, percent});
+            return Decision::fold(ReasonCode::Vs3betFold);
 
-        default:
-            return Decision::fold("Fold weak hand to 3-bet");
-    }
-}
+        case GtoAction::Call:
+            if (mixed) return Decision::call(callAmt, {ReasonCode::Vs3betMixCall, 0.0, percent});
+            return Decision::call(callAmt, ReasonCode::Vs3betCall);
 
-Decision DecisionEngine::decidePreflopVs4bet() {
-    HandCategory category = categorizeHoleCards();
+        case GtoAction::Raise:
+            if (allIn) return Decision::call(callAmt, ReasonCode::Vs3betCallAllIn);
+            if (mixed) return Decision::raise(get4betSize(ctx), {ReasonCode::Vs3betMix4bet, 0.0, percent});
+            return Decision::raise(get4betSize(ctx), ReasonCode::Vs3bet4bet);
 
-    if (category == HandCategory::Premium) {
-        return Decision::raise(session_.heroStack(), "All-in with premiums");
-    }
+        case GtoAction::AllIn:
+            if (allIn) return Decision::call(callAmt, ReasonCode::Vs3betCallAllIn);
+            return Decision::raise(ctx.heroStack, ReasonCode::Vs3betAllIn);
 
-    if (category == HandCategory::Strong && isPair(session_.heroCards().cards[0], session_.heroCards().cards[1])) {
-        return Decision::raise(session_.heroStack(), "All-in with QQ+");
+        default:
+            return Decision::fold(ReasonCode::Vs3betFold);
     }
-
-    return Decision::fold("Fold to 4-bet without premiums");
 }
 
-Decision DecisionEngine::decideFlop() {
-    // Combine hole cards and board for evaluation
-    CardSet fullHand;
-    for (size_t i = 0; i < session_.heroCards().count; ++i) {
-        fullHand.add(session_.heroCards().cards[i]);
+Decision DecisionEngine::decidePreflopVs4bet(const HandContext& ctx) {
+    if (ctx.category == HandCategory::Premium) {
+        return Decision::raise(ctx.heroStack, ReasonCode::Vs4betAllInPremium);
     }
-    for (size_t i = 0; i < session_.board().count; ++i) {
-        fullHand.add(session_.board().cards[i]);
+
+    if (ctx.category == HandCategory::Strong && isPair(ctx.heroCards.cards[0], ctx.heroCards.cards[1])) {
+        return Decision::raise(ctx.heroStack, ReasonCode::Vs4betAllInQueens);
     }
 
-    HandResult hand = HandEvaluator::evaluate(fullHand);
-    double equity = HandEvaluator::calculateEquity(session_.heroCards(), session_.board(), 500);
-    double potOdds = session_.potOdds();
+    return Decision::fold(ReasonCode::Vs4betFold);
+}
 
-    // Format equity percentage for display
-    std::string equityStr = std::format("{:.1f}%", equity * 100.0);
+Decision DecisionEngine::decideFlop(const HandContext& ctx) {
+    const HandResult& hand = ctx.hand;
+    double equity = ctx.equity;
+    double potOdds = ctx.potOdds;
 
     // Check if we're facing a bet
-    if (session_.toCall() > 0) {
-        int64_t callAmt = session_.toCall();
+    if (ctx.toCall > 0) {
+        int64_t callAmt = ctx.toCall;
 
         // We have a made hand
         if (hand.rank >= HandRank::TwoPair) {
             if (hand.rank >= HandRank::Straight || equity > 0.8) {
-                return Decision::raise(callAmt * 2, std::format("Strong hand ({} equity). Raise for value", equityStr));
+                return Decision::raise(callAmt * 2, {ReasonCode::FlopRaiseStrong, equity});
             }
-            return Decision::call(callAmt, std::format("Good made hand ({} equity). Call for value", equityStr));
+            return Decision::call(callAmt, {ReasonCode::FlopCallMadeHand, equity});
         }
 
         // We have a draw
-        int outs = HandEvaluator::countOuts(session_.heroCards(), session_.board());
+        int outs = ctx.outs;
         if (outs >= 8) { // Strong draw
             if (equity > potOdds || equity > 0.35) {
-                if (HandEvaluator::hasFlushDraw(session_.heroCards(), session_.board())) {
-                    return Decision::call(callAmt, std::format("Flush draw ({} equity). Call with good odds", equityStr));
+                if (ctx.flushDraw) {
+                    return Decision::call(callAmt, {ReasonCode::FlopCallFlushDraw, equity});
                 }
-                return Decision::call(callAmt, std::format("Strong draw ({} outs, {} equity). Call.", outs, equityStr));
+                return Decision::call(callAmt, {ReasonCode::FlopCallStrongDraw, equity, outs});
             }
         }
 
         // Weak hand - check fold equity
-        if (equity < 0.25) {
+        if (equity < params_.flopFoldEquity) {
             // Maybe bluff catch if pot odds good
             if (potOdds < 0.2) {
-                return Decision::call(callAmt, std::format("Bluff catch ({} equity) with good pot odds", equityStr));
+                return Decision::call(callAmt, {ReasonCode::FlopBluffCatch, equity});
             }
-            return Decision::fold(std::format("Weak hand ({} equity). Fold to bet", equityStr));
+            return Decision::fold({ReasonCode::FlopFoldWeak, equity});
         }
 
         // Marginal hand
-        return Decision::call(callAmt, std::format("Marginal hand ({} equity). Call to see turn", equityStr));
+        return Decision::call(callAmt, {ReasonCode::FlopCallMarginal, equity});
     }
 
     // We're first to act or checked to
-    BoardTexture texture = analyzeBoardTexture();
+    BoardTexture texture = ctx.texture;
 
     // Value betting
-    if (equity > 0.7 && hand.rank >= HandRank::OnePair) {
-        int64_t betSize = getValueBetSize();
-        return Decision::bet(betSize, std::format("Value bet with strong hand ({} equity)", equityStr));
+    if (equity > params_.flopValueEquity && hand.rank >= HandRank::OnePair) {
+        int64_t betSize = getValueBetSize(ctx);
+        return Decision::bet(betSize, {ReasonCode::FlopValueBet, equity});
     }
 
     // Adjust c-bet frequency based on board texture
     bool shouldCBet = false;
 
-    if (texture == BoardTexture::Dry) {
+    if (texture.wetness() == 0) {
         // Dry boards: c-bet more often, opponents missed more
-        shouldCBet = (equity > 0.35);
-    } else if (texture == BoardTexture::Wet) {
+        shouldCBet = (equity > params_.cbetEquityDry);
+    } else if (texture.wetness() == 1) {
         // Wet boards: c-bet less often, opponents have more draws/connected hands
-        shouldCBet = (equity > 0.45 || (equity > 0.4 && hand.rank >= HandRank::OnePair));
+        shouldCBet = (equity > params_.cbetEquityWet ||
+                      (equity > params_.cbetEquityWet - 0.05 && hand.rank >= HandRank::OnePair));
     } else { // VeryWet
         // Very wet boards: c-bet for value or with draws
-        shouldCBet = (equity > 0.55 && hand.rank >= HandRank::OnePair);
+        shouldCBet = (equity > params_.cbetEquityVeryWet && hand.rank >= HandRank::OnePair);
     }
 
     // Semi-bluff with draws - more aggressive on all board textures
-    int outs = HandEvaluator::countOuts(session_.heroCards(), session_.board());
+    int outs = ctx.outs;
     if (outs >= 8) {
-        if (texture == BoardTexture::Dry) {
-            int64_t betSize = getCBetSize();
-            return Decision::bet(betSize, std::format("Semi-bluff with {} outs ({} equity). Good fold equity on dry board.", outs, equityStr));
+        if (texture.wetness() == 0) {
+            int64_t betSize = getCBetSize(ctx);
+            return Decision::bet(betSize, {ReasonCode::FlopSemiBluffDry, equity, outs});
         }
         // On wet boards, still semi-bluff with strong draws
         if (outs >= 10) {
-            int64_t betSize = getCBetSize();
-            return Decision::bet(betSize, std::format("Semi-bluff with {} outs ({} equity) on wet board", outs, equityStr));
+            int64_t betSize = getCBetSize(ctx);
+            return Decision::bet(betSize, {ReasonCode::FlopSemiBluffWet, equity, outs});
         }
     }
 
     // Continuation bet with board texture consideration
     if (shouldCBet) {
-        int64_t betSize = getCBetSize();
-        if (texture == BoardTexture::Dry) {
-            return Decision::bet(betSize, std::format("C-bet on dry board ({} equity). Good fold equity.", equityStr));
+        int64_t betSize = getCBetSize(ctx);
+        if (texture.wetness() == 0) {
+            return Decision::bet(betSize, {ReasonCode::FlopCbetDry, equity});
         }
-        if (texture == BoardTexture::Wet || texture == BoardTexture::VeryWet) {
-            return Decision::bet(betSize, std::format("C-bet on wet board ({} equity) with showdown value", equityStr));
+        if (texture.wetness() > 0) {
+            return Decision::bet(betSize, {ReasonCode::FlopCbetWet, equity});
         }
-        return Decision::bet(betSize, std::format("Value c-bet ({} equity) with decent hand", equityStr));
+        return Decision::bet(betSize, {ReasonCode::FlopCbetValue, equity});
     }
 
     // Check with weak hand - more checking on wet boards
-    if (texture == BoardTexture::Wet || texture == BoardTexture::VeryWet) {
-        return Decision::check(std::format("Check on wet board ({} equity). Pot control with marginal hand.", equityStr));
+    if (texture.wetness() > 0) {
+        return Decision::check({ReasonCode::FlopCheckWet, equity});
     }
-    return Decision::check(std::format("Check with weak hand ({} equity). Control pot size", equityStr));
+    return Decision::check({ReasonCode::FlopCheckWeak, equity});
 }
 
-Decision DecisionEngine::decideTurn() {
-    // Combine hole cards and board for evaluation
-    CardSet fullHand;
-    for (size_t i = 0; i < session_.heroCards().count; ++i) {
-        fullHand.add(session_.heroCards().cards[i]);
-    }
-    for (size_t i = 0; i < session_.board().count; ++i) {
-        fullHand.add(session_.board().cards[i]);
-    }
-
-    HandResult hand = HandEvaluator::evaluate(fullHand);
-    double equity = HandEvaluator::calculateEquity(session_.heroCards(), session_.board(), 500);
-    double potOdds = session_.potOdds();
+Decision DecisionEngine::decideTurn(const HandContext& ctx) {
+    const HandResult& hand = ctx.hand;
+    double equity = ctx.equity;
+    double potOdds = ctx.potOdds;
 
-    std::string equityStr = std::format("{:.1f}%", equity * 100.0);
-
-    if (session_.toCall() > 0) {
-        int64_t callAmt = session_.toCall();
+    if (ctx.toCall > 0) {
+        int64_t callAmt = ctx.toCall;
 
         // Strong made hand
         if (hand.rank >= HandRank::ThreeOfAKind || equity > 0.8) {
             if (equity > 0.9) {
-                return Decision::raise(callAmt * 2, std::format("Monster ({} equity). Raise for value", equityStr));
+                return Decision::raise(callAmt * 2, {ReasonCode::TurnRaiseMonster, equity});
             }
-            return Decision::call(callAmt, std::format("Strong hand ({} equity). Call down", equityStr));
+            return Decision::call(callAmt, {ReasonCode::TurnCallStrong, equity});
         }
 
         // Two pair or better
         if (hand.rank >= HandRank::TwoPair) {
             if (potOdds < 0.35) {
-                return Decision::call(callAmt, std::format("Value call with two pair+ ({} equity)", equityStr));
+                return Decision::call(callAmt, {ReasonCode::TurnCallTwoPair, equity});
             }
-            return Decision::fold(std::format("Pot too large, fold ({} equity)", equityStr));
+            return Decision::fold({ReasonCode::TurnFoldTwoPair, equity});
         }
 
         // Draws
-        int outs = HandEvaluator::countOuts(session_.heroCards(), session_.board());
+        int outs = ctx.outs;
         if (outs >= 6) {
             double needed = potOdds;
             double approxEquity = outs / 47.0;
             if (approxEquity > needed * 0.8) {
-                return Decision::call(callAmt, std::format("Call with {} outs ({} equity) and good odds", outs, equityStr));
+                return Decision::call(callAmt, {ReasonCode::TurnCallDraw, equity, outs});
             }
         }
 
         // Weak hands
-        if (equity < 0.3) {
+        if (equity < params_.turnFoldEquity) {
             if (potOdds < 0.15) {
-                return Decision::call(callAmt, std::format("Bluff catch ({} equity) in big pot", equityStr));
+                return Decision::call(callAmt, {ReasonCode::TurnBluffCatch, equity});
             }
-            return Decision::fold(std::format("Weak hand ({} equity). Fold", equityStr));
+            return Decision::fold({ReasonCode::TurnFoldWeak, equity});
         }
 
-        return Decision::call(callAmt, std::format("Showdown value call ({} equity)", equityStr));
+        return Decision::call(callAmt, {ReasonCode::TurnCallShowdown, equity});
     }
 
     // First to act or checked to
-    BoardTexture texture = analyzeBoardTexture();
+    BoardTexture texture = ctx.texture;
 
     // Very strong hands - always value bet
-    if (equity > 0.75) {
-        int64_t betSize = getValueBetSize();
-        return Decision::bet(betSize, std::format("Value bet with very strong hand ({} equity)", equityStr));
+    if (equity > params_.turnValueEquity) {
+        int64_t betSize = getValueBetSize(ctx);
+        return Decision::bet(betSize, {ReasonCode::TurnValueBet, equity});
     }
 
     // Turn barrel logic - consider board texture
     bool shouldBarrel = false;
 
-    if (texture == BoardTexture::Dry) {
+    if (texture.wetness() == 0) {
         // Dry turn: barrel with top pair or better
-        shouldBarrel = (equity > 0.5 && hand.rank >= HandRank::OnePair);
-    } else if (texture == BoardTexture::Wet) {
+        shouldBarrel = (equity > params_.barrelEquityDry && hand.rank >= HandRank::OnePair);
+    } else if (texture.wetness() == 1) {
         // Wet turn: barrel with good hands
-        shouldBarrel = (equity > 0.6 && hand.rank >= HandRank::OnePair);
+        shouldBarrel = (equity > params_.barrelEquityWet && hand.rank >= HandRank::OnePair);
     } else { // VeryWet
         // Very wet turn: only for value with strong hands
-        shouldBarrel = (equity > 0.65 && hand.rank >= HandRank::OnePair);
+        shouldBarrel = (equity > params_.barrelEquityVeryWet && hand.rank >= HandRank::OnePair);
     }
 
     if (shouldBarrel) {
-        int64_t betSize = getValueBetSize();
-        return Decision::bet(betSize, std::format("Turn barrel for value ({} equity)", equityStr));
+        int64_t betSize = getValueBetSize(ctx);
+        return Decision::bet(betSize, {ReasonCode::TurnBarrel, equity});
     }
 
     // Second barrel as bluff on dry boards with good equity
-    if (texture == BoardTexture::Dry && equity > 0.4 && session_.spr() > 4) {
-        int64_t betSize = getBluffSize();
-        return Decision::bet(betSize, std::format("Bluff on dry turn ({} equity) with equity", equityStr));
+    if (texture.wetness() == 0 && equity > 0.4 && ctx.spr > 4 && shouldBluff()) {
+        int64_t betSize = getBluffSize(ctx);
+        return Decision::bet(betSize, {ReasonCode::TurnBluff, equity});
     }
 
     // Check behind with marginal hands
     if (hand.rank == HandRank::OnePair) {
-        return Decision::check(std::format("Check back with one pair ({} equity) for pot control", equityStr));
+        return Decision::check({ReasonCode::TurnCheckPair, equity});
     }
 
-    return Decision::check("Check with marginal hand");
+    return Decision::check(ReasonCode::TurnCheckMarginal);
 }
 
-Decision DecisionEngine::decideRiver() {
-    // Combine hole cards and board for evaluation
-    CardSet fullHand;
-    for (size_t i = 0; i < session_.heroCards().count; ++i) {
-        fullHand.add(session_.heroCards().cards[i]);
-    }
-    for (size_t i = 0; i < session_.board().count; ++i) {
-        fullHand.add(session_.board().cards[i]);
+Decision DecisionEngine::decideRiver(const HandContext& ctx) {
+    if (riverSolveIterations_ > 0) {
+        if (std::optional<Decision> solved = solveRiver(ctx)) return *solved;
     }
 
-    HandResult hand = HandEvaluator::evaluate(fullHand);
-    double equity = HandEvaluator::calculateEquity(session_.heroCards(), session_.board(), 500);
-    std::string equityStr = std::format("{:.1f}%", equity * 100.0);
-    double potOdds = session_.potOdds();
-    int64_t pot = session_.pot();
+    const HandResult& hand = ctx.hand;
+    double equity = ctx.equity;
+    double potOdds = ctx.potOdds;
+    int64_t pot = ctx.pot;
 
     // Check board texture for sizing decisions
-    BoardTexture texture = analyzeBoardTexture();
-    bool isWetBoard = (texture == BoardTexture::Wet || texture == BoardTexture::VeryWet);
+    BoardTexture texture = ctx.texture;
+    bool isWetBoard = (texture.wetness() > 0);
 
-    if (session_.toCall() > 0) {
-        int64_t callAmt = session_.toCall();
+    if (ctx.toCall > 0) {
+        int64_t callAmt = ctx.toCall;
 
         // Strong value hands - nutted hands call almost always
         if (hand.rank >= HandRank::Straight) {
-            return Decision::call(callAmt, std::format("Call with straight ({} equity). Nutted.", equityStr));
+            return Decision::call(callAmt, {ReasonCode::RiverCallStraight, equity});
         }
 
         if (hand.rank >= HandRank::Flush) {
-            return Decision::call(callAmt, std::format("Call with flush ({} equity). Nutted.", equityStr));
+            return Decision::call(callAmt, {ReasonCode::RiverCallFlush, equity});
         }
 
         if (hand.rank >= HandRank::ThreeOfAKind) {
-            return Decision::call(callAmt, std::format("Call with set+ ({} equity). Likely good.", equityStr));
+            return Decision::call(callAmt, {ReasonCode::RiverCallSet, equity});
         }
 
         if (hand.rank >= HandRank::TwoPair) {
             // Need better pot odds for two pair
             if (potOdds < 0.4) {
-                return Decision::call(callAmt, std::format("Call with two pair ({} equity). Good enough.", equityStr));
+                return Decision::call(callAmt, {ReasonCode::RiverCallTwoPair, equity});
             }
-            return Decision::fold(std::format("Two pair ({} equity) but facing big bet. Fold.", equityStr));
+            return Decision::fold({ReasonCode::RiverFoldTwoPair, equity});
         }
 
         // One pair or worse - hero call or fold
         if (potOdds < 0.25) {
-            return Decision::call(callAmt, std::format("Bluff catch ({} equity) in massive pot", equityStr));
+            return Decision::call(callAmt, {ReasonCode::RiverBluffCatch, equity});
         }
 
-        return Decision::fold(std::format("Weak hand ({} equity). Fold to bet", equityStr));
+        return Decision::fold({ReasonCode::RiverFoldWeak, equity});
     }
 
     // First to act or checked to - smart value bet sizing based on hand strength
@@ -412,66 +605,146 @@ Decision DecisionEngine::decideRiver() {
         // On dry boards, can go bigger
         double sizeMult = isWetBoard ? 0.75 : 0.85;
         int64_t betSize = static_cast<int64_t>(pot * sizeMult);
-        if (betSize > session_.heroStack()) betSize = session_.heroStack();
-        return Decision::bet(betSize, std::format("Big value bet with nutted hand ({} equity)", equityStr));
+        if (betSize > ctx.heroStack) betSize = ctx.heroStack;
+        return Decision::bet(betSize, {ReasonCode::RiverValueNutted, equity});
     }
 
     // Sets - strong value
     if (hand.rank >= HandRank::ThreeOfAKind) {
         double sizeMult = isWetBoard ? 0.66 : 0.75;
         int64_t betSize = static_cast<int64_t>(pot * sizeMult);
-        return Decision::bet(betSize, std::format("Value bet with set ({} equity)", equityStr));
+        return Decision::bet(betSize, {ReasonCode::RiverValueSet, equity});
     }
 
     // Two pair - medium value sizing
     if (hand.rank >= HandRank::TwoPair) {
         double sizeMult = isWetBoard ? 0.50 : 0.66;
         int64_t betSize = static_cast<int64_t>(pot * sizeMult);
-        return Decision::bet(betSize, std::format("Value bet with two pair ({} equity)", equityStr));
+        return Decision::bet(betSize, {ReasonCode::RiverValueTwoPair, equity});
     }
 
     // Top pair - size based on kicker strength and board
     if (hand.rank == HandRank::OnePair) {
         // Check if it's top pair with good kicker or not
-        std::string handDesc = HandEvaluator::describeHand(session_.heroCards(), session_.board());
+        Kicker kicker = pairKicker(ctx);
 
-        if (handDesc.find("great kicker") != std::string::npos) {
+        if (kicker == Kicker::Great) {
             // Top pair great kicker - can value bet larger
             double sizeMult = isWetBoard ? 0.40 : 0.50;
             int64_t betSize = static_cast<int64_t>(pot * sizeMult);
-            return Decision::bet(betSize, std::format("Value bet top pair great kicker ({} equity)", equityStr));
+            return Decision::bet(betSize, {ReasonCode::RiverValueTopPairGreat, equity});
         }
-        if (handDesc.find("good kicker") != std::string::npos) {
+        if (kicker == Kicker::Good) {
             // Top pair good kicker - medium value bet
             double sizeMult = isWetBoard ? 0.33 : 0.40;
             int64_t betSize = static_cast<int64_t>(pot * sizeMult);
-            return Decision::bet(betSize, std::format("Medium value bet top pair good kicker ({} equity)", equityStr));
+            return Decision::bet(betSize, {ReasonCode::RiverValueTopPairGood, equity});
         }
         // Weak kicker or middle pair - very thin value or check
-        if (equity > 0.55) {
+        if (equity > params_.riverThinValueEquity) {
             int64_t betSize = static_cast<int64_t>(pot * 0.25);
-            return Decision::bet(betSize, std::format("Thin value bet ({} equity)", equityStr));
+            return Decision::bet(betSize, {ReasonCode::RiverThinValue, equity});
         }
-        return Decision::check(std::format("Check with marginal pair ({} equity). Showdown value.", equityStr));
+        return Decision::check({ReasonCode::RiverCheckPair, equity});
     }
 
     // Bluff with missed draw on favorable boards
-    if (hand.rank <= HandRank::HighCard && session_.spr() > 2) {
+    if (hand.rank <= HandRank::HighCard && ctx.spr > 2) {
         // Only bluff on dry boards where our story makes sense
-        if (texture == BoardTexture::Dry) {
+        if (texture.wetness() == 0 && shouldBluff()) {
             int64_t betSize = static_cast<int64_t>(pot * 0.50);
-            return Decision::bet(betSize, "Bluff with missed draw on dry board. Represent something.");
+            return Decision::bet(betSize, ReasonCode::RiverBluff);
         }
     }
 
-    return Decision::check(std::format("Check at showdown ({} equity). Can't value bet weak hands", equityStr));
+    return Decision::check({ReasonCode::RiverCheckShowdown, equity});
+}
+
+std::optional<Decision> DecisionEngine::solveRiver(const HandContext& ctx) {
+    std::optional<Position> villain = ranges_.mainOpponent();
+    if (!villain) return std::nullopt;
+
+    // Chips each side has put in on the river so far: hero's last bet, if
+    // any, and whatever hero now faces on top of it
+    double heroIn = 0.0;
+    if (const ActionRecord* bet = session_.actions().lastAggressive(Street::River, ctx.position)) {
+        heroIn = static_cast<double>(bet->amount());
+    }
+    double villainIn = heroIn + static_cast<double>(ctx.toCall);
+
+    RiverSpot spot;
+    spot.board = ctx.board.mask();
+    spot.pot = static_cast<double>(ctx.pot) - heroIn - villainIn;
+    spot.stack = static_cast<double>(session_.effectiveStack()) + heroIn;
+    if (spot.pot <= 0.0 || spot.stack <= 0.0) return std::nullopt;
+
+    // Who acts last against this villain, not against the table
+    const bool heroIp = postflopOrder(ctx.position) > postflopOrder(*villain);
+    const int heroSide = heroIp ? RiverSolver::kIp : RiverSolver::kOop;
+    spot.oop = heroIp ? ranges_.range(*villain) : ranges_.range(ctx.position);
+    spot.ip = heroIp ? ranges_.range(ctx.position) : ranges_.range(*villain);
+
+    // Hero's own hand may have been all but ruled out by the tracker; it
+    // still has to be in the range for the solve to say how to play it
+    int combo = comboIndex(cardIndex(ctx.heroCards.cards[0]), cardIndex(ctx.heroCards.cards[1]));
+    Range& heroRange = heroIp ? spot.ip : spot.oop;
+    heroRange[combo] = std::max(heroRange[combo], 0.01f);
+
+    // An anytime decision solves until its sampling deadline instead, which
+    // the equity estimate has usually used up by now
+    if (samplingDeadline_ && Clock::now() >= *samplingDeadline_) return std::nullopt;
+    RiverSolver solver(spot);
+    if (!samplingDeadline_) {
+        solver.solve(riverSolveIterations_, solverPool_);
+    } else {
+        while (solver.iterations() < riverSolveIterations_ && Clock::now() < *samplingDeadline_) {
+            solver.solve(1, solverPool_);
+        }
+        if (solver.iterations() < std::min(riverSolveIterations_, kMinAnytimeSolveIterations)) return std::nullopt;
+    }
+
+    // Walk the tree to hero's spot, mapping bets onto the nearest size
+    const int root = RiverSolver::kRoot;
+    int node;
+    if (heroIn > 0.0) {
+        // Hero bet and was raised
+        node = solver.follow(heroIp ? solver.follow(root, Action::Check, 0.0) : root, Action::Bet, heroIn);
+        node = solver.follow(node, Action::Raise, villainIn);
+    } else if (ctx.toCall > 0) {
+        node = solver.follow(heroIp ? root : solver.follow(root, Action::Check, 0.0), Action::Bet, villainIn);
+    } else {
+        node = heroIp ? solver.follow(root, Action::Check, 0.0) : root;
+    }
+    if (node < 0 || solver.actor(node) != heroSide) return std::nullopt;
+
+    std::vector<double> mix = solver.strategy(node, combo);
+    std::span<const RiverSolver::Edge> edges = solver.edges(node);
+    double pick = rng_.uniform();
+    size_t chosen = 0;
+    while (chosen + 1 < edges.size() && pick >= mix[chosen]) pick -= mix[chosen++];
+
+    const RiverSolver::Edge& edge = edges[chosen];
+    Reason why{ReasonCode::RiverSolverMix, ctx.equity, static_cast<int>(std::lround(mix[chosen] * 100))};
+    int64_t amount = std::min(static_cast<int64_t>(std::lround(edge.amount)), ctx.heroStack + static_cast<int64_t>(heroIn));
+    switch (edge.action) {
+        case Action::Fold:  return Decision::fold(why);
+        case Action::Check: return Decision::check(why);
+        case Action::Call:  return Decision::call(ctx.toCall, why);
+        case Action::Bet:   return Decision::bet(amount, why);
+        case Action::Raise: return Decision::raise(amount, why);
+    }
+    return std::nullopt;
 }
 
 double DecisionEngine::calculateEV(Action action, int64_t amount) {
+    return calculateEV(buildContext(), action, amount);
+}
+
+double DecisionEngine::calculateEV(const HandContext& ctx, Action action, int64_t amount) {
     // Simplified EV calculation
     // Full version would consider ranges and frequencies
-    double equity = getHandStrength();
-    int64_t pot = session_.pot();
+    double equity = ctx.street == Street::Preflop ? estimateEquity() : ctx.equity;
+    int64_t pot = ctx.pot;
 
     switch (action) {
         case Action::Fold:
@@ -481,8 +754,7 @@ double DecisionEngine::calculateEV(Action action, int64_t amount) {
             return pot * equity;
 
         case Action::Call: {
-            double potOdds = session_.potOdds();
-            if (equity > potOdds) {
+            if (equity > ctx.potOdds) {
                 return (pot + amount) * equity - amount;
             }
             return -amount;
@@ -490,9 +762,9 @@ double DecisionEngine::calculateEV(Action action, int64_t amount) {
 
         case Action::Bet:
         case Action::Raise: {
-            double foldEquity = getFoldEquity();
+            double fe = foldEquity(ctx.texture, ctx.street);
             double evWhenCalled = (pot + amount * 2) * equity - amount;
-            return foldEquity * pot + (1.0 - foldEquity) * evWhenCalled;
+            return fe * pot + (1.0 - fe) * evWhenCalled;
         }
 
         default:
@@ -500,76 +772,158 @@ double DecisionEngine::calculateEV(Action action, int64_t amount) {
     }
 }
 
+double DecisionEngine::estimateEquity() {
+    CardMask hole = session_.heroCards().mask();
+    CardMask board = session_.board().mask();
+    std::optional<Position> villain = ranges_.narrowing() ? ranges_.mainOpponent() : std::nullopt;
+    EquitySampler sampler = villain ? EquitySampler(hole, board, ranges_.range(*villain))
+                                    : EquitySampler(hole, board);
+
+    if (!samplingDeadline_) {
+        sampler.sample(equityIterations_, rng_);
+    } else {
+        // The first batch is the floor, deadline or not
+        do {
+            sampler.sample(kEquityBatch, rng_);
+        } while (!sampler.exact() && sampler.samples() < kMaxAnytimeSamples &&
+                 (sampler.samples() < kMinAnytimeSamples || 1.96 * sampler.standardError() > kTargetEquityCi) &&
+                 Clock::now() < *samplingDeadline_);
+    }
+
+    lastEquity_ = {sampler.equity(), sampler.exact() ? 0 : sampler.samples(), 1.96 * sampler.standardError()};
+    return lastEquity_.value;
+}
+
+bool DecisionEngine::shouldBluff() {
+    return params_.bluffFrequency >= 1.0 || rng_.uniform() < params_.bluffFrequency;
+}
+
 double DecisionEngine::getHandStrength() {
-    return HandEvaluator::calculateEquity(session_.heroCards(), session_.board(), 500);
+    return estimateEquity();
 }
 
 double DecisionEngine::getFoldEquity() {
-    // Simplified - real implementation would use opponent models
-    BoardTexture texture = analyzeBoardTexture();
-    double baseFE = 0.3;
+    ranges_.update(session_);
+    return foldEquity(describeBoard(session_.board().mask()), session_.street());
+}
 
-    if (texture == BoardTexture::Dry) baseFE += 0.2;
-    if (texture == BoardTexture::VeryWet) baseFE -= 0.1;
+double DecisionEngine::foldEquity(BoardTexture texture, Street street) {
+    // Prior from the spot alone: bets get through most on high dry boards
+    // (the caller rarely connected) and least where draws are everywhere
+    double baseFE = 0.3;
+    switch (texture.type) {
+        case TextureClass::DryHigh:  baseFE += 0.25; break;
+        case TextureClass::DryLow:
+        case TextureClass::Paired:   baseFE += 0.2; break;
+        case TextureClass::Dynamic:
+        case TextureClass::Monotone: baseFE -= 0.1; break;
+        default: break;
+    }
     if (isInPosition()) baseFE += 0.1;
+    baseFE = std::clamp(baseFE, 0.1, 0.6);
+
+    // Blend in how often this opponent has actually folded to bets (to
+    // c-bets when this would be one); the prior counts as kFoldPriorWeight
+    // observations, so a few hands can't swing it far
+    const PlayerStats* villain = villainStats();
+    if (!villain) return baseFE;
+
+    bool cbet = street == Street::Flop && heroRaisedLastPreflop() && (*villain)[Stat::FacedCbets] > 0;
+    double folds = cbet ? (*villain)[Stat::FoldsToCbet] : (*villain)[Stat::FoldsToBet];
+    double chances = cbet ? (*villain)[Stat::FacedCbets] : (*villain)[Stat::FacedBets];
+    return std::clamp((baseFE * kFoldPriorWeight + folds) / (kFoldPriorWeight + chances), 0.05, 0.9);
+}
+
+const PlayerStats* DecisionEngine::villainStats() const {
+    const OpponentStats* stats = session_.opponentStats();
+    std::optional<Position> villain = ranges_.mainOpponent();
+    if (!stats || !villain) return nullptr;
+
+    uint32_t player = session_.playerAt(*villain);
+    return player == OpponentStats::kNoPlayer ? nullptr : &(*stats)[player];
+}
+
+bool DecisionEngine::heroRaisedLastPreflop() const {
+    const ActionRecord* raise = session_.actions().lastAggressive(Street::Preflop);
+    return raise && raise->position() == session_.heroPosition();
+}
 
-    return std::clamp(baseFE, 0.1, 0.6);
+bool DecisionEngine::facingAllIn(const HandContext& ctx) const {
+    if (ctx.toCall >= ctx.heroStack) return true;
+    const ActionRecord* raise = session_.actions().lastAggressive(Street::Preflop);
+    return raise && session_.table().status[static_cast<int>(raise->position())] == SeatStatus::AllIn;
 }
 
-int64_t DecisionEngine::getOpenRaiseSize() {
-    (void)bigBlindsRemaining(); // Cache for potential use
-    Position pos = getPosition();
+int64_t DecisionEngine::getOpenRaiseSize(const HandContext& ctx) {
+    Position pos = ctx.position;
 
     int64_t bb = session_.bb();
 
     // Standard open sizes by position
     if (pos == Position::BTN || pos == Position::CO) {
-        return std::min(static_cast<int64_t>(bb * 2.5), session_.heroStack());
+        return std::min(static_cast<int64_t>(bb * 2.5), ctx.heroStack);
     }
     if (pos == Position::SB) {
-        return std::min(static_cast<int64_t>(bb * 2.0), session_.heroStack());
+        return std::min(static_cast<int64_t>(bb * 2.0), ctx.heroStack);
     }
-    return std::min(static_cast<int64_t>(bb * 2.5), session_.heroStack());
+    return std::min(static_cast<int64_t>(bb * 2.5), ctx.heroStack);
 }
 
-int64_t DecisionEngine::get3betSize() {
-    int64_t pot = session_.pot();
-    int64_t size = static_cast<int64_t>(pot * 2.5);
-    return std::min(size, session_.heroStack());
+int64_t DecisionEngine::get3betSize(const HandContext& ctx) {
+    int64_t size = static_cast<int64_t>(ctx.pot * 2.5);
+    return std::min(size, ctx.heroStack);
 }
 
-int64_t DecisionEngine::get4betSize() {
-    int64_t pot = session_.pot() + session_.toCall() * 2;
+int64_t DecisionEngine::get4betSize(const HandContext& ctx) {
+    int64_t pot = ctx.pot + ctx.toCall * 2;
     int64_t size = static_cast<int64_t>(pot * 2.2);
-    return std::min(size, session_.heroStack());
+    return std::min(size, ctx.heroStack);
 }
 
-int64_t DecisionEngine::getCBetSize() {
-    int64_t pot = session_.pot();
-    return static_cast<int64_t>(pot * 0.33);
+int64_t DecisionEngine::getCBetSize(const HandContext& ctx) {
+    return static_cast<int64_t>(ctx.pot * 0.33);
 }
 
-int64_t DecisionEngine::getValueBetSize() {
-    int64_t pot = session_.pot();
-    double spr = session_.spr();
+int64_t DecisionEngine::getValueBetSize(const HandContext& ctx) {
+    int64_t pot = ctx.pot;
+    double spr = ctx.spr;
 
     if (spr < 2) return pot; // Small pot, shove
     if (spr < 4) return static_cast<int64_t>(pot * 0.75);
     return static_cast<int64_t>(pot * 0.5);
 }
 
-int64_t DecisionEngine::getBluffSize() {
-    int64_t pot = session_.pot();
-    return static_cast<int64_t>(pot * 0.5); // Smaller bluffs
+int64_t DecisionEngine::getBluffSize(const HandContext& ctx) {
+    return static_cast<int64_t>(ctx.pot * 0.5); // Smaller bluffs
 }
 
 // Helper methods
 
-DecisionEngine::HandCategory DecisionEngine::categorizeHoleCards() {
-    if (session_.heroCards().count < 2) return HandCategory::Weak;
+DecisionEngine::Kicker DecisionEngine::pairKicker(const HandContext& ctx) {
+    if (ctx.hand.rank != HandRank::OnePair) return Kicker::None;
 
-    Card c1 = session_.heroCards().cards[0];
-    Card c2 = session_.heroCards().cards[1];
+    uint32_t holeRanks = rankUnion(ctx.heroCards.mask());
+    uint32_t boardRanks = rankUnion(ctx.board.mask());
+    uint32_t paired = holeRanks & boardRanks;
+    // Pocket pairs and pairs on the board have no kicker of their own
+    if (std::popcount(holeRanks) != 2 || std::popcount(paired) != 1) return Kicker::None;
+
+    uint32_t topBoard = std::bit_floor(boardRanks);
+    int kicker = std::countr_zero(holeRanks & ~paired) + 2;
+
+    if (paired == topBoard) {
+        if (kicker >= 10) return Kicker::Great;
+        if (kicker >= 7) return Kicker::Good;
+        return Kicker::Weak;
+    }
+    return kicker >= 10 ? Kicker::Good : Kicker::Weak;
+}
+
+DecisionEngine::HandCategory DecisionEngine::categorizeHoleCards(const CardSet& heroCards) {
+    if (heroCards.count < 2) return HandCategory::Weak;
+
+    Card c1 = heroCards.cards[0];
+    Card c2 = heroCards.cards[1];
 
     // Pairs
     if (isPair(c1, c2)) {
@@ -618,58 +972,6 @@ int DecisionEngine::highCardValue(Card c1, Card c2) {
     return std::max(v1, v2) * 2 + std::min(v1, v2) / 2;
 }
 
-DecisionEngine::BoardTexture DecisionEngine::analyzeBoardTexture() {
-    if (session_.board().count < 3) return BoardTexture::Dry;
-
-    bool flushPossible = hasFlushDrawOnBoard();
-    bool straightPossible = hasStraightDrawOnBoard();
-    bool paired = false;
-
-    // Check for pairs on board
-    auto counts = countRanks(session_.board().cards, session_.board().count);
-    for (int c : counts) {
-        if (c > 1) paired = true;
-    }
-
-    if (flushPossible && straightPossible) return BoardTexture::VeryWet;
-    if (flushPossible || straightPossible || paired) return BoardTexture::Wet;
-    return BoardTexture::Dry;
-}
-
-bool DecisionEngine::isDryBoard() {
-    return analyzeBoardTexture() == BoardTexture::Dry;
-}
-
-bool DecisionEngine::hasFlushDrawOnBoard() {
-    if (session_.board().count < 3) return false;
-
-    auto suitCounts = countSuits(session_.board().cards, session_.board().count);
-    for (int c : suitCounts) {
-        if (c >= 2) return true; // 2 or more of same suit = flush draw possible
-    }
-    return false;
-}
-
-bool DecisionEngine::hasStraightDrawOnBoard() {
-    if (session_.board().count < 3) return false;
-
-    std::array<bool, 15> hasRank{};
-    for (size_t i = 0; i < session_.board().count; ++i) {
-        hasRank[rankToInt(session_.board().cards[i].rank())] = true;
-    }
-
-    // Check for 3 cards within 4-rank range
-    for (int start = 10; start >= 1; --start) {
-        int count = 0;
-        for (int i = 0; i < 5; ++i) {
-            if (hasRank[start + i]) count++;
-        }
-        if (count >= 3) return true;
-    }
-
-    return false;
-}
-
 bool DecisionEngine::isInPosition() {
     Position heroPos = getPosition();
     // Simplified: assume we're in position if we're BTN and villains are in blinds
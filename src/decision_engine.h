@@ -1,69 +1,238 @@
 #pragma once
 
+#include "board_texture.h"
 #include "game_session.h"
 #include "hand_evaluator.h"
+#include "opponent_stats.h"
+#include "range_tracker.h"
+#include "rng.h"
+#include <chrono>
+#include <optional>
 #include <string>
 
 namespace sharkwave {
 
+class ThreadPool;
+
+// The equity estimate a decision was based on, and how precise it was
+struct EquityEstimate {
+    double value = 0.0;
+    int samples = 0;        // 0 when no estimate was needed or it came from a table
+    double ci95 = 0.0;      // Half-width of the 95% confidence interval
+};
+
+// Why the engine chose an action. Each code names one rule's explanation;
+// the numbers it quotes travel alongside, and text() renders it only when
+// something is going to display it.
+enum class ReasonCode : uint8_t {
+    None,
+    UnknownStreet,
+
+    // Preflop, unopened
+    OpenTooWeak,
+    OpenBestHand,
+    OpenRaise,
+    OpenAllIn,
+    OpenNotInRange,
+    OpenMixRaise,       // outs carries how often the chart opens the hand, in percent
+    OpenMixFold,        // outs carries how often the chart folds the hand, in percent
+
+    // Preflop, facing a raise / 3-bet / 4-bet
+    VsRaiseFold,
+    VsRaiseCall,
+    VsRaise3bet,
+    VsRaiseAllIn,
+    VsRaiseCallAllIn,
+    VsRaiseMixFold,     // outs carries how often the chart folds the hand, in percent
+    VsRaiseMixCall,     // outs carries how often the chart calls with the hand, in percent
+    VsRaiseMix3bet,     // outs carries how often the chart 3-bets the hand, in percent
+    Vs3betFold,
+    Vs3betCall,
+    Vs3bet4bet,
+    Vs3betAllIn,
+    Vs3betCallAllIn,
+    Vs3betMixFold,      // outs carries how often the chart folds the hand, in percent
+    Vs3betMixCall,      // outs carries how often the chart calls with the hand, in percent
+    Vs3betMix4bet,      // outs carries how often the chart 4-bets the hand, in percent
+    Vs4betAllInPremium,
+    Vs4betAllInQueens,
+    Vs4betFold,
+
+    // Flop
+    FlopRaiseStrong,
+    FlopCallMadeHand,
+    FlopCallFlushDraw,
+    FlopCallStrongDraw,
+    FlopBluffCatch,
+    FlopFoldWeak,
+    FlopCallMarginal,
+    FlopValueBet,
+    FlopSemiBluffDry,
+    FlopSemiBluffWet,
+    FlopCbetDry,
+    FlopCbetWet,
+    FlopCbetValue,
+    FlopCheckWet,
+    FlopCheckWeak,
+
+    // Turn
+    TurnRaiseMonster,
+    TurnCallStrong,
+    TurnCallTwoPair,
+    TurnFoldTwoPair,
+    TurnCallDraw,
+    TurnBluffCatch,
+    TurnFoldWeak,
+    TurnCallShowdown,
+    TurnValueBet,
+    TurnBarrel,
+    TurnBluff,
+    TurnCheckPair,
+    TurnCheckMarginal,
+
+    // River
+    RiverCallStraight,
+    RiverCallFlush,
+    RiverCallSet,
+    RiverCallTwoPair,
+    RiverFoldTwoPair,
+    RiverBluffCatch,
+    RiverFoldWeak,
+    RiverValueNutted,
+    RiverValueSet,
+    RiverValueTwoPair,
+    RiverValueTopPairGreat,
+    RiverValueTopPairGood,
+    RiverThinValue,
+    RiverCheckPair,
+    RiverBluff,
+    RiverCheckShowdown,
+    RiverSolverMix      // outs carries how often the solver takes the action, in percent
+};
+
+struct Reason {
+    ReasonCode code;
+    uint8_t outs;
+    double equity;
+
+    constexpr Reason(ReasonCode code = ReasonCode::None, double equity = 0.0, int outs = 0)
+        : code(code), outs(static_cast<uint8_t>(outs)), equity(equity) {}
+
+    bool empty() const { return code == ReasonCode::None; }
+    std::string text() const;
+};
+static_assert(sizeof(Reason) == 16);
+
 struct Decision {
     Action action;
     int64_t amount;        // 0 for fold/check/call, bet/raise amount
-    std::string reason;
+    Reason reason;
+    EquityEstimate equity{};
 
-    static Decision fold(std::string why) {
-        return {Action::Fold, 0, std::move(why)};
+    static Decision fold(Reason why) {
+        return {Action::Fold, 0, why};
     }
 
-    static Decision check(std::string why) {
-        return {Action::Check, 0, std::move(why)};
+    static Decision check(Reason why) {
+        return {Action::Check, 0, why};
     }
 
-    static Decision call(int64_t amt, std::string why) {
-        return {Action::Call, amt, std::move(why)};
+    static Decision call(int64_t amt, Reason why) {
+        return {Action::Call, amt, why};
     }
 
-    static Decision bet(int64_t amt, std::string why) {
-        return {Action::Bet, amt, std::move(why)};
+    static Decision bet(int64_t amt, Reason why) {
+        return {Action::Bet, amt, why};
     }
 
-    static Decision raise(int64_t amt, std::string why) {
-        return {Action::Raise, amt, std::move(why)};
+    static Decision raise(int64_t amt, Reason why) {
+        return {Action::Raise, amt, why};
     }
 };
 
+// Equity thresholds and frequencies behind the postflop heuristics. The
+// defaults are the engine's hand-picked values; the tuner searches around them.
+struct StrategyParams {
+    double flopValueEquity = 0.70;      // Bet a pair+ for value above this
+    double cbetEquityDry = 0.35;
+    double cbetEquityWet = 0.45;
+    double cbetEquityVeryWet = 0.55;
+    double flopFoldEquity = 0.25;       // Facing a bet, fold below this unless priced in
+    double turnValueEquity = 0.75;
+    double barrelEquityDry = 0.50;
+    double barrelEquityWet = 0.60;
+    double barrelEquityVeryWet = 0.65;
+    double turnFoldEquity = 0.30;
+    double riverThinValueEquity = 0.55; // Thin-value bet a weak pair above this
+    double bluffFrequency = 1.0;        // Share of bluff spots (dry turn/river) actually bluffed
+};
+
 class DecisionEngine {
 public:
+    using Clock = std::chrono::steady_clock;
+
     DecisionEngine(GameSession& session);
     Decision makeDecision();
 
-    // Preflop decisions
-    Decision decidePreflop();
-    Decision decidePreflopUnopened();
-    Decision decidePreflopVsRaise();
-    Decision decidePreflopVs3bet();
-    Decision decidePreflopVs4bet();
+    // Anytime variant: refines equity in small batches until the deadline (or
+    // until it is precise enough to stop mattering), then decides with the
+    // best estimate so far. decision.equity reports the precision reached.
+    Decision makeDecision(Clock::time_point deadline);
+    Decision makeDecision(std::chrono::microseconds budget) { return makeDecision(Clock::now() + budget); }
 
-    // Postflop decisions
-    Decision decideFlop();
-    Decision decideTurn();
-    Decision decideRiver();
+    // Monte Carlo samples behind every equity estimate (default 500).
+    // Simulators lower this to trade precision for hands per second.
+    void setEquityIterations(int iterations) { equityIterations_ = iterations; }
+    int equityIterations() const { return equityIterations_; }
+
+    // Play river spots from a CFR+ solve over both players' tracked ranges
+    // instead of the rule-based sizes. 0 iterations (the default) keeps the
+    // rules; about 100 solve a typical spot in under 100 ms on one core.
+    // Under a makeDecision() deadline the solve stops when time runs out,
+    // and the rules decide if it got too few iterations in.
+    void setRiverSolver(int iterations, ThreadPool* pool = nullptr) {
+        riverSolveIterations_ = iterations;
+        solverPool_ = pool;
+        ranges_.setNarrowing(rangeTracking_ || iterations > 0);
+    }
+
+    // Narrow every player's range by their actions and estimate equity
+    // against the main opponent's (the default). Off, equity is against a
+    // random hand and a decision costs about half as much, which is what
+    // simulators want. The river solver needs ranges, so it keeps them on.
+    void setRangeTracking(bool on) {
+        rangeTracking_ = on;
+        ranges_.setNarrowing(on || riverSolveIterations_ > 0);
+    }
+    bool rangeTracking() const { return ranges_.narrowing(); }
+
+    // Reseed the equity sampler for reproducible runs
+    void seed(uint64_t seed) { rng_.reseed(seed); }
+
+    void setParams(const StrategyParams& params) { params_ = params; }
+    const StrategyParams& params() const { return params_; }
+
+    // What each opponent is likely holding, given the actions the session
+    // has recorded; equity is estimated against the main opponent's range
+    const RangeTracker& ranges() const { return ranges_; }
 
     // Calculation helpers
     double calculateEV(Action action, int64_t amount);
     double getHandStrength();
     double getFoldEquity();
 
-    // Sizing helpers
-    int64_t getOpenRaiseSize();
-    int64_t get3betSize();
-    int64_t get4betSize();
-    int64_t getCBetSize();
-    int64_t getValueBetSize();
-    int64_t getBluffSize();
-
 private:
     GameSession& session_;
+    int equityIterations_;
+    Rng rng_;
+    StrategyParams params_;
+    RangeTracker ranges_;
+    bool rangeTracking_;
+    int riverSolveIterations_;
+    ThreadPool* solverPool_;
+
+    std::optional<Clock::time_point> samplingDeadline_;    // Set only for anytime decisions
+    EquityEstimate lastEquity_;
 
     // Hand category (for preflop)
     enum class HandCategory {
@@ -74,25 +243,83 @@ private:
         Weak        // Everything else
     };
 
-    HandCategory categorizeHoleCards();
+    // Everything the rules read about the spot, gathered once per decision so
+    // no rule or sizing helper rescans the cards or re-queries the session
+    struct HandContext {
+        Street street = Street::Preflop;
+        Position position = Position::UTG;
+        CardSet heroCards;
+        CardSet board;
+        CardMask combined = 0;      // Hole cards | board
+
+        int64_t pot = 0;
+        int64_t toCall = 0;
+        int64_t heroStack = 0;
+        int bigBlinds = 0;          // Hero's stack in big blinds
+        double spr = 0.0;
+        double potOdds = 0.0;
+
+        // Preflop only
+        HandCategory category = HandCategory::Weak;
+
+        // Postflop only
+        HandResult hand{};
+        int outs = 0;
+        bool flushDraw = false;
+        BoardTexture texture{};
+        double equity = 0.0;
+    };
+
+    HandContext buildContext();
+    Decision decideStreet();
+    double estimateEquity();
+    bool shouldBluff();     // Draws against params_.bluffFrequency
+
+    // Preflop decisions
+    Decision decidePreflop(const HandContext& ctx);
+    Decision decidePreflopUnopened(const HandContext& ctx);
+    Decision decidePreflopVsRaise(const HandContext& ctx);
+    Decision decidePreflopVs3bet(const HandContext& ctx);
+    Decision decidePreflopVs4bet(const HandContext& ctx);
+
+    // Postflop decisions
+    Decision decideFlop(const HandContext& ctx);
+    Decision decideTurn(const HandContext& ctx);
+    Decision decideRiver(const HandContext& ctx);
+    std::optional<Decision> solveRiver(const HandContext& ctx);
+
+    double calculateEV(const HandContext& ctx, Action action, int64_t amount);
+    double foldEquity(BoardTexture texture, Street street);
+
+    // Long-run stats of the main opponent, when the session tracks them
+    const PlayerStats* villainStats() const;
+    bool heroRaisedLastPreflop() const;
+    bool facingAllIn(const HandContext& ctx) const;     // Hero can only call or fold
+
+    // Sizing helpers
+    int64_t getOpenRaiseSize(const HandContext& ctx);
+    int64_t get3betSize(const HandContext& ctx);
+    int64_t get4betSize(const HandContext& ctx);
+    int64_t getCBetSize(const HandContext& ctx);
+    int64_t getValueBetSize(const HandContext& ctx);
+    int64_t getBluffSize(const HandContext& ctx);
+
+    // Kicker quality of a one-pair hand made with a hole card
+    enum class Kicker {
+        None,       // Pocket pair, pair on board, or no pair
+        Weak,
+        Good,
+        Great       // Top pair only
+    };
+
+    static Kicker pairKicker(const HandContext& ctx);
+
+    HandCategory categorizeHoleCards(const CardSet& heroCards);
     bool isSuitedConnector(Card c1, Card c2);
     bool isPair(Card c1, Card c2);
     bool isSuited(Card c1, Card c2);
     int highCardValue(Card c1, Card c2);
 
-    // Board analysis
-    enum class BoardTexture {
-        Dry,        // No draws, disconnected
-        Wet,        // Flush draw possible
-        VeryWet,    // Multiple draws possible
-        Coordinated // Highly connected
-    };
-
-    BoardTexture analyzeBoardTexture();
-    bool isDryBoard();
-    bool hasFlushDrawOnBoard();
-    bool hasStraightDrawOnBoard();
-
     // Position helpers
     bool isInPosition();
     bool isOutOfPosition();
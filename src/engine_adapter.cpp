@@ -0,0 +1,46 @@
+#include "engine_adapter.h"
+
+namespace sharkwave {
+
+EngineAdapter::EngineAdapter(int sb, int bb, int equityIterations, uint64_t seed)
+    : villainId_(opponents_.add())
+    , engine_(session_)
+    , villain_(Position::BB)
+{
+    session_.setOpponentStats(&opponents_);
+    session_.setPlayerCount(2);
+    session_.setBlinds(sb, bb);
+    engine_.setEquityIterations(equityIterations);
+    engine_.seed(seed);
+}
+
+void EngineAdapter::beginHand(Position hero, const CardSet& holeCards, Position villain) {
+    session_.newHand();     // Clears the action log; chips are overwritten per decision
+    session_.setHeroPosition(hero);
+    session_.setHeroCards(holeCards.cards[0], holeCards.cards[1]);
+    session_.setBoard(CardSet{});
+
+    // effectiveStack() ignores empty seats, so clear everyone but the villain
+    for (int p = 0; p < 6; ++p) {
+        if (p != static_cast<int>(hero)) session_.setOpponentStack(static_cast<Position>(p), 0);
+        session_.seatPlayer(static_cast<Position>(p), OpponentStats::kNoPlayer);
+    }
+    session_.seatPlayer(villain, villainId_);
+    villain_ = villain;
+}
+
+void EngineAdapter::recordAction(Position pos, Street street, Action action, int64_t amount) {
+    if (session_.street() != street) session_.advanceTo(street);
+    session_.recordAction(pos, action, amount);
+}
+
+Decision EngineAdapter::decide(Street street, const CardSet& board, int64_t pot, int64_t currentBet,
+                               int64_t toCall, int64_t heroStack, int64_t villainStack) {
+    session_.setBoard(board);
+    session_.setBettingState(street, pot, currentBet, toCall);
+    session_.setHeroStack(heroStack);
+    session_.setOpponentStack(villain_, villainStack);
+    return engine_.makeDecision();
+}
+
+} // namespace sharkwave
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "decision_engine.h"
+#include "game_session.h"
+#include "opponent_stats.h"
+#include <cstdint>
+
+namespace sharkwave {
+
+// Puts the real DecisionEngine in a simulator's hero seat. The session and
+// engine are built once and live as long as the adapter; each decision only
+// overwrites the session's view of the spot (street, board, pot, amount to
+// call, stacks), so nothing is allocated or rebuilt per action.
+class EngineAdapter {
+public:
+    EngineAdapter(int sb, int bb, int equityIterations, uint64_t seed);
+
+    EngineAdapter(const EngineAdapter&) = delete;
+    EngineAdapter& operator=(const EngineAdapter&) = delete;
+
+    // Seat hero for a new hand; only `villain` is treated as still holding chips
+    void beginHand(Position hero, const CardSet& holeCards, Position villain);
+
+    // Log an action (hero's or the villain's) so the engine can read the
+    // villain's range from the betting
+    void recordAction(Position pos, Street street, Action action, int64_t amount);
+
+    // `currentBet` is the street's highest bet, `toCall` what hero still owes
+    Decision decide(Street street, const CardSet& board, int64_t pot, int64_t currentBet,
+                    int64_t toCall, int64_t heroStack, int64_t villainStack);
+
+    // The villain's VPIP/PFR/fold counts, carried from hand to hand
+    PlayerStats& villainStats() { return opponents_[villainId_]; }
+    const PlayerStats& villainStats() const { return opponents_[villainId_]; }
+
+    GameSession& session() { return session_; }
+    DecisionEngine& engine() { return engine_; }
+
+private:
+    OpponentStats opponents_;
+    OpponentStats::PlayerId villainId_;
+    GameSession session_;
+    DecisionEngine engine_;     // Holds a reference to session_, so declared after it
+    Position villain_;
+};
+
+} // namespace sharkwave
@@ -1,37 +1,336 @@
 #include "game_session.h"
+#include "opponent_stats.h"
+#include "rng.h"
 #include <format>
 #include <algorithm>
+#include <cctype>
+#include <limits>
 
 namespace sharkwave {
 
+namespace {
+    // Room for any ordinary hand, reserved once per session
+    constexpr size_t kActionLogReserve = 64;
+
+    constexpr int kSbSeat = static_cast<int>(Position::SB);
+    constexpr int kBbSeat = static_cast<int>(Position::BB);
+    constexpr int kButtonSeat = static_cast<int>(Position::BTN);
+
+    constexpr uint8_t seatBit(int seat) { return static_cast<uint8_t>(1u << seat); }
+
+    bool inHand(SeatStatus status) { return status == SeatStatus::Active || status == SeatStatus::AllIn; }
+
+    // Hash salts: one per field, per seat or pot where there are several
+    enum HashField : uint64_t {
+        kStackField = 0,
+        kCommittedField = kStackField + TableState::kSeats,
+        kStatusField = kCommittedField + TableState::kSeats,
+        kPotField = kStatusField + TableState::kSeats,
+        kEligibleField = kPotField + TableState::kSeats,
+        kNumPotsField = kEligibleField + TableState::kSeats,
+        kBetField,
+        kLastRaiseField,
+        kActedField,
+        kToActField,
+        kStreetField,
+        kHeroSeatField
+    };
+
+    uint64_t fieldKey(uint64_t field, int64_t value) {
+        return splitmix64(static_cast<uint64_t>(value) ^ (field << 56));
+    }
+
+    // Hero's cards and the board's are keyed apart
+    constexpr std::array<uint64_t, 104> kCardKeys = [] {
+        std::array<uint64_t, 104> keys{};
+        for (size_t i = 0; i < keys.size(); ++i) keys[i] = splitmix64(0x2B0A9D5E1F7C3364ULL + i);
+        return keys;
+    }();
+
+    uint64_t cardsHash(const CardSet& cards, int offset) {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < cards.count; ++i) hash ^= kCardKeys[offset + cardIndex(cards.cards[i])];
+        return hash;
+    }
+
+    constexpr int kHeroCardKeys = 0;
+    constexpr int kBoardCardKeys = 52;
+}
+
+void TableState::newHand(int64_t sb, int64_t bb) {
+    committed.fill(0);
+    pots.fill(0);
+    eligible.fill(0);
+    numPots = 1;
+    for (int s = 0; s < kSeats; ++s) {
+        status[s] = stack[s] > 0 ? SeatStatus::Active : SeatStatus::Empty;
+        if (stack[s] > 0) eligible[0] |= seatBit(s);
+    }
+    street = Street::Preflop;
+    currentBet = 0;
+    lastRaise = 0;
+    acted = 0;
+
+    // Posting isn't acting: the big blind still has the option
+    for (auto [seat, blind] : {std::pair{kSbSeat, sb}, std::pair{kBbSeat, bb}}) {
+        if (status[seat] != SeatStatus::Active) continue;
+        int64_t paid = std::min(blind, stack[seat]);
+        stack[seat] -= paid;
+        committed[seat] = paid;
+        if (stack[seat] == 0) status[seat] = SeatStatus::AllIn;
+    }
+    currentBet = bb;
+    lastRaise = bb;
+    toAct = static_cast<int8_t>(nextToAct(kBbSeat));
+}
+
+void TableState::apply(int seat, Action action, int64_t amount) {
+    int64_t paid = 0;
+    switch (action) {
+        case Action::Fold:
+            status[seat] = SeatStatus::Folded;
+            for (int p = 0; p < numPots; ++p) eligible[p] &= static_cast<uint8_t>(~seatBit(seat));
+            break;
+        case Action::Check:
+            break;
+        case Action::Call:
+            paid = std::max<int64_t>(toCall(seat), 0);
+            break;
+        case Action::Bet:
+            paid = std::clamp<int64_t>(amount, 0, stack[seat]);
+            break;
+        case Action::Raise:
+            paid = std::clamp<int64_t>(currentBet + amount - committed[seat], 0, stack[seat]);
+            break;
+    }
+
+    stack[seat] -= paid;
+    committed[seat] += paid;
+    if (paid > 0 && stack[seat] == 0 && status[seat] == SeatStatus::Active) status[seat] = SeatStatus::AllIn;
+
+    // A bet or raise reopens the action to everyone else
+    acted |= seatBit(seat);
+    if (committed[seat] > currentBet) {
+        lastRaise = std::max(lastRaise, committed[seat] - currentBet);
+        currentBet = committed[seat];
+        acted = seatBit(seat);
+    }
+    toAct = static_cast<int8_t>(nextToAct(seat));
+}
+
+void TableState::endStreet(Street next) {
+    // The part of the biggest bet nobody matched goes back
+    int top = 0;
+    for (int s = 1; s < kSeats; ++s) {
+        if (committed[s] > committed[top]) top = s;
+    }
+    int64_t matched = 0;
+    for (int s = 0; s < kSeats; ++s) {
+        if (s != top) matched = std::max(matched, committed[s]);
+    }
+    if (committed[top] > matched) {
+        stack[top] += committed[top] - matched;
+        committed[top] = matched;
+        if (status[top] == SeatStatus::AllIn) status[top] = SeatStatus::Active;
+    }
+
+    // Sweep the bets in layers, each as deep as the shortest all-in still
+    // above the last: a layer whose players match the open pot's joins it,
+    // and any other starts a side pot
+    int64_t level = 0;
+    while (true) {
+        int64_t cap = std::numeric_limits<int64_t>::max();
+        bool more = false;
+        for (int s = 0; s < kSeats; ++s) {
+            if (committed[s] <= level) continue;
+            more = true;
+            if (status[s] == SeatStatus::AllIn) cap = std::min(cap, committed[s]);
+        }
+        if (!more) break;
+
+        int64_t layer = 0;
+        uint8_t players = 0;
+        for (int s = 0; s < kSeats; ++s) {
+            if (committed[s] <= level) continue;
+            layer += std::min(committed[s], cap) - level;
+            if (inHand(status[s])) players |= seatBit(s);
+        }
+
+        int open = numPots - 1;
+        if (players != eligible[open] && pots[open] > 0 && numPots < kSeats) {
+            open = numPots++;
+            eligible[open] = players;
+        } else if (pots[open] == 0 && players != 0) {
+            eligible[open] = players;
+        }
+        pots[open] += layer;
+        level = cap;
+    }
+
+    committed.fill(0);
+    street = next;
+    currentBet = 0;
+    lastRaise = 0;
+    acted = 0;
+    toAct = static_cast<int8_t>(nextToAct(kButtonSeat));
+}
+
+int64_t TableState::pot() const {
+    int64_t total = 0;
+    for (int p = 0; p < numPots; ++p) total += pots[p];
+    for (int64_t chips : committed) total += chips;
+    return total;
+}
+
+int64_t TableState::winnable(int seat) const {
+    int64_t total = 0;
+    for (int p = 0; p < numPots; ++p) {
+        if (eligible[p] & seatBit(seat)) total += pots[p];
+    }
+    int64_t reach = committed[seat] + std::max<int64_t>(toCall(seat), 0);
+    for (int64_t chips : committed) total += std::min(chips, reach);
+    return total;
+}
+
+int64_t TableState::effectiveStack(int seat) const {
+    int64_t deepest = 0;
+    for (int s = 0; s < kSeats; ++s) {
+        if (s != seat && inHand(status[s])) deepest = std::max(deepest, stack[s]);
+    }
+    return std::min(stack[seat], deepest);
+}
+
+int TableState::liveSeats() const {
+    int live = 0;
+    for (SeatStatus s : status) live += inHand(s);
+    return live;
+}
+
+uint64_t TableState::seatHash(int seat) const {
+    return fieldKey(kStackField + seat, stack[seat]) ^ fieldKey(kCommittedField + seat, committed[seat]) ^
+           fieldKey(kStatusField + seat, static_cast<int64_t>(status[seat]));
+}
+
+uint64_t TableState::roundHash() const {
+    return fieldKey(kBetField, currentBet) ^ fieldKey(kLastRaiseField, lastRaise) ^
+           fieldKey(kActedField, acted) ^ fieldKey(kToActField, toAct) ^
+           fieldKey(kStreetField, static_cast<int64_t>(street));
+}
+
+uint64_t TableState::potsHash() const {
+    uint64_t hash = fieldKey(kNumPotsField, numPots);
+    for (int p = 0; p < numPots; ++p) {
+        hash ^= fieldKey(kPotField + p, pots[p]) ^ fieldKey(kEligibleField + p, eligible[p]);
+    }
+    return hash;
+}
+
+uint64_t TableState::hash() const {
+    uint64_t hash = roundHash() ^ potsHash();
+    for (int s = 0; s < kSeats; ++s) hash ^= seatHash(s);
+    return hash;
+}
+
+int TableState::nextToAct(int after) const {
+    if (liveSeats() < 2) return -1;
+    int active = 0;
+    for (SeatStatus s : status) active += s == SeatStatus::Active;
+    for (int step = 1; step <= kSeats; ++step) {
+        int s = (after + step) % kSeats;
+        if (status[s] != SeatStatus::Active) continue;
+        if (committed[s] < currentBet) return s;
+        // With nobody left to bet against, a player who owes nothing is done
+        if (!(acted & seatBit(s)) && active > 1) return s;
+    }
+    return -1;
+}
+
+ActionLog::ActionLog()
+    : streetFirst_{}
+    , street_(Street::Preflop)
+{
+    records_.reserve(kActionLogReserve);
+}
+
+void ActionLog::clear() {
+    records_.clear();
+    street_ = Street::Preflop;
+}
+
+void ActionLog::pop() {
+    records_.pop_back();
+    street_ = records_.empty() ? Street::Preflop : records_.back().street();
+}
+
+void ActionLog::push(const ActionRecord& record) {
+    // Streets skipped on the way (no action on them) begin and end here
+    for (int s = static_cast<int>(street_) + 1; s <= static_cast<int>(record.street()); ++s) {
+        streetFirst_[s] = static_cast<uint32_t>(records_.size());
+    }
+    if (record.street() > street_) street_ = record.street();
+    records_.push_back(record);
+}
+
+std::span<const ActionRecord> ActionLog::since(size_t first) const {
+    return std::span<const ActionRecord>(records_).subspan(std::min(first, records_.size()));
+}
+
+std::span<const ActionRecord> ActionLog::onStreet(Street street) const {
+    if (street > street_) return {};
+    size_t first = street == Street::Preflop ? 0 : streetFirst_[static_cast<int>(street)];
+    size_t last = street == street_ ? records_.size() : streetFirst_[static_cast<int>(street) + 1];
+    return std::span<const ActionRecord>(records_).subspan(first, last - first);
+}
+
+const ActionRecord* ActionLog::lastAggressive(Street street) const {
+    std::span<const ActionRecord> actions = onStreet(street);
+    for (size_t i = actions.size(); i-- > 0;) {
+        if (actions[i].aggressive()) return &actions[i];
+    }
+    return nullptr;
+}
+
+const ActionRecord* ActionLog::lastAggressive(Street street, Position pos) const {
+    std::span<const ActionRecord> actions = onStreet(street);
+    for (size_t i = actions.size(); i-- > 0;) {
+        if (actions[i].aggressive() && actions[i].position() == pos) return &actions[i];
+    }
+    return nullptr;
+}
+
 GameSession::GameSession()
     : playerCount_(6)
     , sb_(5)
     , bb_(10)
     , heroPosition_(Position::CO)
-    , heroStack_(1000)
-    , opponentStacks_{}
-    , pot_(0)
-    , currentBet_(0)
-    , toCall_(0)
-    , street_(Street::Preflop)
-    , actionCount_(0)
+    , hash_(0)
+    , handId_(0)
     , initialHeroStack_(1000)
+    , opponentStats_(nullptr)
     , sessionProfit_(0)
     , handsPlayed_(0)
     , handsWon_(0)
     , wonHand_(false)
 {
-    opponentStacks_.fill(1000);
+    seatEveryone(1000);
+    playerIds_.fill(OpponentStats::kNoPlayer);
+    undo_.reserve(kActionLogReserve);
+    tableChanged();
+}
+
+void GameSession::seatEveryone(int64_t stack) {
+    table_ = TableState{};
+    table_.stack.fill(stack);
+    table_.status.fill(SeatStatus::Active);
+    table_.eligible[0] = (1u << TableState::kSeats) - 1;
 }
 
 void GameSession::reset() {
     playerCount_ = 6;
     sb_ = 5;
     bb_ = 10;
-    heroStack_ = 1000;
     heroPosition_ = Position::CO;
-    opponentStacks_.fill(1000);
+    seatEveryone(1000);
     sessionProfit_ = 0;
     handsPlayed_ = 0;
     handsWon_ = 0;
@@ -41,33 +340,59 @@ void GameSession::reset() {
 void GameSession::newHand() {
     heroCards_.clear();
     board_.clear();
-    pot_ = sb_ + bb_; // Blinds posted
-    currentBet_ = bb_;
-    toCall_ = 0;
-    street_ = Street::Preflop;
-    actionCount_ = 0;
-    initialHeroStack_ = heroStack_;
+    actions_.clear();
+    handId_++;
+    initialHeroStack_ = heroStack();
     wonHand_ = false;
+    if (opponentStats_) opponentStats_->beginHand();
+    table_.newHand(sb_, bb_);
+    tableChanged();
+}
 
-    // Post blinds based on position
-    if (heroPosition_ == Position::SB) {
-        heroStack_ -= sb_;
-        pot_ += sb_;
-        toCall_ = bb_ - sb_;
-    } else if (heroPosition_ == Position::BB) {
-        heroStack_ -= bb_;
-        pot_ += bb_;
+void GameSession::setHeroStack(int64_t stack) {
+    int hero = heroSeat();
+    table_.stack[hero] = stack;
+    if (table_.status[hero] != SeatStatus::Folded) {
+        table_.status[hero] = stack > 0 ? SeatStatus::Active : SeatStatus::AllIn;
     }
+    tableChanged();
+}
+
+void GameSession::setHeroPosition(Position pos) {
+    // Blinds belong to the seat, not the player: each keeps their chips in
+    // total, with whatever the new seat has posted taken out of them
+    int from = heroSeat(), to = static_cast<int>(pos);
+    int64_t heroChips = table_.stack[from] + table_.committed[from];
+    int64_t otherChips = table_.stack[to] + table_.committed[to];
+    table_.stack[to] = std::max<int64_t>(heroChips - table_.committed[to], 0);
+    table_.stack[from] = std::max<int64_t>(otherChips - table_.committed[from], 0);
+    std::swap(table_.status[from], table_.status[to]);
+    heroPosition_ = pos;
+    tableChanged();
 }
 
 void GameSession::setHeroCards(Card c1, Card c2) {
+    hash_ ^= cardsHash(heroCards_, kHeroCardKeys);
     heroCards_.clear();
     heroCards_.add(c1);
     heroCards_.add(c2);
+    hash_ ^= cardsHash(heroCards_, kHeroCardKeys);
 }
 
 void GameSession::setOpponentStack(Position pos, int64_t stack) {
-    opponentStacks_[static_cast<int>(pos)] = stack;
+    int seat = static_cast<int>(pos);
+    uint8_t bit = static_cast<uint8_t>(1u << seat);
+    table_.stack[seat] = stack;
+    if (stack > 0 && table_.status[seat] != SeatStatus::Folded) {
+        if (table_.status[seat] == SeatStatus::Empty) {
+            for (int p = 0; p < table_.numPots; ++p) table_.eligible[p] |= bit;
+        }
+        table_.status[seat] = SeatStatus::Active;
+    } else if (stack == 0 && table_.status[seat] == SeatStatus::Active) {
+        table_.status[seat] = SeatStatus::Empty;
+        for (int p = 0; p < table_.numPots; ++p) table_.eligible[p] &= static_cast<uint8_t>(~bit);
+    }
+    tableChanged();
 }
 
 void GameSession::setFlop(Card c1, Card c2, Card c3) {
@@ -75,115 +400,130 @@ void GameSession::setFlop(Card c1, Card c2, Card c3) {
     board_.add(c1);
     board_.add(c2);
     board_.add(c3);
-    street_ = Street::Flop;
-    currentBet_ = 0;
-    toCall_ = 0;
+    table_.endStreet(Street::Flop);
+    tableChanged();
 }
 
 void GameSession::setTurn(Card c) {
     board_.add(c);
-    street_ = Street::Turn;
-    currentBet_ = 0;
-    toCall_ = 0;
+    table_.endStreet(Street::Turn);
+    tableChanged();
 }
 
 void GameSession::setRiver(Card c) {
     board_.add(c);
-    street_ = Street::River;
-    currentBet_ = 0;
-    toCall_ = 0;
+    table_.endStreet(Street::River);
+    tableChanged();
 }
 
-void GameSession::recordAction(Position pos, Action action, int64_t amount) {
-    if (actionCount_ < actionHistory_.size()) {
-        actionHistory_[actionCount_++] = {pos, action, amount};
+void GameSession::setBoard(const CardSet& board) {
+    hash_ ^= cardsHash(board_, kBoardCardKeys) ^ cardsHash(board, kBoardCardKeys);
+    board_ = board;
+}
+
+void GameSession::setBettingState(Street street, int64_t pot, int64_t currentBet, int64_t toCall) {
+    int hero = heroSeat();
+    table_.street = street;
+    table_.committed.fill(0);
+    table_.pots.fill(0);
+    table_.currentBet = std::max(currentBet, toCall);
+    table_.lastRaise = table_.currentBet;
+    table_.committed[hero] = table_.currentBet - toCall;
+    table_.pots[0] = std::max<int64_t>(pot - table_.committed[hero], 0);
+    table_.eligible.fill(0);
+    for (int s = 0; s < TableState::kSeats; ++s) {
+        if (table_.status[s] == SeatStatus::Active || table_.status[s] == SeatStatus::AllIn) {
+            table_.eligible[0] |= static_cast<uint8_t>(1u << s);
+        }
     }
+    table_.numPots = 1;
+    table_.acted = 0;
+    table_.toAct = static_cast<int8_t>(hero);
+    tableChanged();
 }
 
-void GameSession::processHeroAction(Action action, int64_t amount) {
-    recordAction(heroPosition_, action, amount);
+void GameSession::recordAction(Position pos, Action action, int64_t amount) {
+    if (opponentStats_) opponentStats_->record(pos, playerIds_[static_cast<int>(pos)], table_.street, action);
+    step(static_cast<int>(pos), action, amount);
+    undo_.clear();
+}
 
-    switch (action) {
-        case Action::Fold:
-            toCall_ = 0;
-            break;
+bool GameSession::apply(Action action, int64_t amount) {
+    if (table_.toAct < 0) return false;
+    undo_.push_back({table_, board_, hash_});
+    step(table_.toAct, action, amount);
 
-        case Action::Check:
-            // Nothing changes
-            break;
+    // Betting's closed with a showdown still to come: on to the next street
+    if (table_.toAct < 0 && table_.liveSeats() > 1 && table_.street < Street::Showdown) {
+        uint64_t before = table_.hash();
+        table_.endStreet(static_cast<Street>(static_cast<int>(table_.street) + 1));
+        hash_ ^= before ^ table_.hash();
+    }
+    return true;
+}
 
-        case Action::Call:
-            heroStack_ -= toCall_;
-            pot_ += toCall_;
-            toCall_ = 0;
-            break;
+void GameSession::undo() {
+    if (undo_.empty()) return;
+    table_ = undo_.back().table;
+    board_ = undo_.back().board;
+    hash_ = undo_.back().hash;
+    undo_.pop_back();
+    actions_.pop();
+}
 
-        case Action::Bet:
-            heroStack_ -= amount;
-            pot_ += amount;
-            currentBet_ = amount;
-            toCall_ = amount;
-            break;
+void GameSession::step(int seat, Action action, int64_t amount) {
+    actions_.push({static_cast<Position>(seat), action, table_.street, amount});
 
-        case Action::Raise:
-            int64_t totalAmount = toCall_ + amount;
-            heroStack_ -= totalAmount;
-            pot_ += totalAmount;
-            currentBet_ += amount;
-            toCall_ = currentBet_;
-            break;
-    }
+    // Only the seat and the round change, but for a fold, which also
+    // takes the seat out of the pots
+    uint64_t before = table_.seatHash(seat) ^ table_.roundHash();
+    if (action == Action::Fold) before ^= table_.potsHash();
+    table_.apply(seat, action, amount);
+    uint64_t after = table_.seatHash(seat) ^ table_.roundHash();
+    if (action == Action::Fold) after ^= table_.potsHash();
+    hash_ ^= before ^ after;
+}
+
+void GameSession::tableChanged() {
+    hash_ = table_.hash() ^ fieldKey(kHeroSeatField, heroSeat()) ^
+            cardsHash(heroCards_, kHeroCardKeys) ^ cardsHash(board_, kBoardCardKeys);
+    undo_.clear();
+}
+
+void GameSession::processHeroAction(Action action, int64_t amount) {
+    recordAction(heroPosition_, action, amount);
 }
 
 void GameSession::advanceTo(Street street) {
-    street_ = street;
-    currentBet_ = 0;
-    toCall_ = 0;
+    table_.endStreet(street);
+    tableChanged();
 }
 
 void GameSession::nextStreet() {
-    switch (street_) {
-        case Street::Preflop:
-            street_ = Street::Flop;
-            break;
-        case Street::Flop:
-            street_ = Street::Turn;
-            break;
-        case Street::Turn:
-            street_ = Street::River;
-            break;
-        case Street::River:
-            street_ = Street::Showdown;
-            break;
-        default:
-            break;
+    if (table_.street < Street::Showdown) {
+        table_.endStreet(static_cast<Street>(static_cast<int>(table_.street) + 1));
     }
-    currentBet_ = 0;
-    toCall_ = 0;
+    tableChanged();
 }
 
 int64_t GameSession::handProfit() const {
-    return heroStack_ - initialHeroStack_ + (wonHand_ ? pot_ : 0);
+    return heroStack() - initialHeroStack_ + (wonHand_ ? pot() : 0);
 }
 
 double GameSession::potOdds() const {
-    if (toCall_ == 0) return 0.0;
-    return static_cast<double>(toCall_) / static_cast<double>(pot_ + toCall_);
+    int64_t call = toCall();
+    if (call <= 0) return 0.0;
+    return static_cast<double>(call) / static_cast<double>(table_.winnable(heroSeat()) + call);
 }
 
 double GameSession::spr() const {
-    if (pot_ == 0) return 0.0;
-    return static_cast<double>(effectiveStack()) / static_cast<double>(pot_);
+    int64_t pot = table_.winnable(heroSeat());
+    if (pot == 0) return 0.0;
+    return static_cast<double>(effectiveStack()) / static_cast<double>(pot);
 }
 
 int64_t GameSession::effectiveStack() const {
-    int64_t minStack = heroStack_;
-    for (int64_t stack : opponentStacks_) {
-        if (stack > 0 && stack < minStack) {
-            minStack = stack;
-        }
-    }
-    return minStack;
+    return table_.effectiveStack(heroSeat());
 }
 
 std::string GameSession::positionToString(Position pos) {
@@ -198,6 +538,18 @@ std::string GameSession::positionToString(Position pos) {
     return "??";
 }
 
+std::optional<Position> GameSession::positionFromString(std::string_view text) {
+    std::string upper(text);
+    for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    if (upper == "UTG") return Position::UTG;
+    if (upper == "MP") return Position::MP;
+    if (upper == "CO") return Position::CO;
+    if (upper == "BTN" || upper == "BUTTON") return Position::BTN;
+    if (upper == "SB") return Position::SB;
+    if (upper == "BB") return Position::BB;
+    return std::nullopt;
+}
+
 std::string GameSession::actionToString(Action action) {
     switch (action) {
         case Action::Fold:  return "folds";
@@ -1,12 +1,19 @@
 #pragma once
 
 #include "card.h"
+#include <algorithm>
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <array>
+#include <vector>
 
 namespace sharkwave {
 
+class OpponentStats;
+
 enum class Position : uint8_t {
     UTG,        // Under the Gun
     MP,         // Middle Position
@@ -32,10 +39,129 @@ enum class Action : uint8_t {
     Raise
 };
 
-struct ActionRecord {
-    Position position;
-    Action action;
-    int64_t amount;     // 0 for fold/check, positive for call/bet/raise
+enum class SeatStatus : uint8_t {
+    Empty,      // Nobody there, or not dealt in
+    Active,
+    Folded,
+    AllIn
+};
+
+// The chips at a table, as arrays by seat (a Position's index), so the
+// whole betting state is a few cache lines that search and simulation can
+// copy freely. Chips bet on the current street sit in `committed` until the
+// street ends; then they're swept into the open pot, with a side pot for
+// every level an all-in player caps, and any uncalled bet goes back.
+struct TableState {
+    static constexpr int kSeats = 6;
+
+    std::array<int64_t, kSeats> stack{};        // Behind
+    std::array<int64_t, kSeats> committed{};    // This street
+    std::array<int64_t, kSeats> pots{};         // Main pot, then side pots; the last is open
+    std::array<uint8_t, kSeats> eligible{};     // Per pot, the seats that can win it, a bit each
+    std::array<SeatStatus, kSeats> status{};
+    int64_t currentBet = 0;     // Most committed by anyone this street
+    int64_t lastRaise = 0;      // Size of the street's last bet or raise: the minimum raise
+    uint8_t numPots = 1;
+    uint8_t acted = 0;          // Seats that have acted since the last bet or raise
+    int8_t toAct = -1;          // Seat to act, -1 once the street's betting is closed
+    Street street = Street::Preflop;
+
+    // Seats with chips are dealt in, the blinds posted and the first seat
+    // after the big blind put to act
+    void newHand(int64_t sb, int64_t bb);
+
+    // `amount` is the chips bet for a bet, and how much a raise adds on top
+    // of the current bet; anything over a stack puts that seat all-in
+    void apply(int seat, Action action, int64_t amount);
+
+    // Sweep the street's bets into the pots and start `next`, first to act
+    // the first seat after the button
+    void endStreet(Street next);
+
+    int64_t pot() const;        // Every chip in the middle
+    int64_t toCall(int seat) const {
+        return status[seat] == SeatStatus::Active ? std::min(currentBet - committed[seat], stack[seat]) : 0;
+    }
+
+    // The chips `seat` is playing for: the pots it's eligible for, and of
+    // this street's bets as much as it can match
+    int64_t winnable(int seat) const;
+
+    // Chips `seat` can still win or lose: its stack, capped by the largest
+    // stack behind among the other players still in
+    int64_t effectiveStack(int seat) const;
+
+    int liveSeats() const;      // Neither empty nor folded
+
+    // Zobrist-style hashes of the state, a part at a time so a change to a
+    // part can be swapped in and out of a running hash: chip counts have
+    // too many values for key tables, so each field's key is its value
+    // mixed with the field's own salt
+    uint64_t seatHash(int seat) const;
+    uint64_t roundHash() const;     // Street, bet, minimum raise, who has acted and who's next
+    uint64_t potsHash() const;
+    uint64_t hash() const;
+
+private:
+    int nextToAct(int after) const;
+};
+
+static_assert(sizeof(TableState) <= 256);
+
+// One action in a word: position, action and street a nibble each, and
+// the amount in the 52 bits above them
+class ActionRecord {
+public:
+    constexpr ActionRecord(Position position, Action action, Street street, int64_t amount)
+        : bits_(static_cast<uint64_t>(position) | static_cast<uint64_t>(action) << 4 |
+                static_cast<uint64_t>(street) << 8 | static_cast<uint64_t>(amount) << 12) {}
+
+    constexpr Position position() const { return static_cast<Position>(bits_ & 0xF); }
+    constexpr Action action() const { return static_cast<Action>((bits_ >> 4) & 0xF); }
+    constexpr Street street() const { return static_cast<Street>((bits_ >> 8) & 0xF); }
+    constexpr int64_t amount() const { return static_cast<int64_t>(bits_) >> 12; }   // 0 for fold/check
+
+    constexpr bool aggressive() const { return action() == Action::Bet || action() == Action::Raise; }
+
+private:
+    uint64_t bits_;
+};
+
+static_assert(sizeof(ActionRecord) == 8);
+
+// One hand's actions in order. The buffer is kept from hand to hand, so
+// once it has grown to the longest hand seen, recording never allocates;
+// nothing is ever dropped, and clear() is O(1). Actions come street by
+// street, so each street's are one run, found in O(1) by onStreet().
+class ActionLog {
+public:
+    ActionLog();
+
+    void clear();
+    void push(const ActionRecord& record);
+    void pop();     // Takes back the latest action
+
+    size_t size() const { return records_.size(); }
+    bool empty() const { return records_.empty(); }
+    const ActionRecord& operator[](size_t i) const { return records_[i]; }
+    const ActionRecord& back() const { return records_.back(); }
+    auto begin() const { return records_.begin(); }
+    auto end() const { return records_.end(); }
+
+    // Everything from the `first`th action on, for consumers that keep up
+    // with the log incrementally
+    std::span<const ActionRecord> since(size_t first) const;
+
+    std::span<const ActionRecord> onStreet(Street street) const;
+
+    // Last bet or raise on a street, by anyone or by one position
+    const ActionRecord* lastAggressive(Street street) const;
+    const ActionRecord* lastAggressive(Street street, Position pos) const;
+
+private:
+    std::vector<ActionRecord> records_;
+    std::array<uint32_t, 5> streetFirst_;   // Index of each street's first action, once it's begun
+    Street street_;                         // Street of the latest action
 };
 
 class GameSession {
@@ -46,30 +172,70 @@ public:
 
     // Game setup
     void setPlayerCount(int count) { playerCount_ = count; }
+    int playerCount() const { return playerCount_; }
     void setBlinds(int small, int big) { sb_ = small; bb_ = big; }
-    void setHeroStack(int64_t stack) { heroStack_ = stack; }
-    void setHeroPosition(Position pos) { heroPosition_ = pos; }
+    void setHeroStack(int64_t stack);
+    void setHeroPosition(Position pos);     // Moves hero's chips with them
     void setHeroCards(Card c1, Card c2);
-    void setOpponentStack(Position pos, int64_t stack);
+    void setOpponentStack(Position pos, int64_t stack);     // 0 empties the seat
 
     // Board
     void setFlop(Card c1, Card c2, Card c3);
     void setTurn(Card c);
     void setRiver(Card c);
+    void setBoard(const CardSet& board);
+
+    // Overwrite the live betting state in one step, for simulators that track
+    // chips themselves and only need the engine's view of the spot kept in
+    // sync. Everything but hero's own bet goes into one pot.
+    void setBettingState(Street street, int64_t pot, int64_t currentBet, int64_t toCall);
 
     // Game state
-    Street street() const { return street_; }
-    int64_t pot() const { return pot_; }
-    int64_t heroStack() const { return heroStack_; }
-    int64_t currentBet() const { return currentBet_; }
-    int64_t toCall() const { return toCall_; }
+    const TableState& table() const { return table_; }
+    Street street() const { return table_.street; }
+    int64_t pot() const { return table_.pot(); }
+    int64_t heroStack() const { return table_.stack[heroSeat()]; }
+    int64_t currentBet() const { return table_.currentBet; }
+    int64_t toCall() const { return table_.toCall(heroSeat()); }
     int sb() const { return sb_; }
     int bb() const { return bb_; }
     Position heroPosition() const { return heroPosition_; }
 
-    // Actions
+    // Actions (recorded against the current street, chips moved as in
+    // TableState::apply())
     void recordAction(Position pos, Action action, int64_t amount = 0);
     void processHeroAction(Action action, int64_t amount = 0);
+    const ActionLog& actions() const { return actions_; }
+
+    // Make and unmake moves for search: the seat to act takes `action`,
+    // the street moves on once its betting closes, and undo() takes the
+    // latest apply() back. Both are O(1) with no allocation once the undo
+    // stack has grown, so a lookahead steps through one session instead
+    // of copying it per node. Searched actions aren't counted in opponent
+    // stats. Deal chance cards with setBoard(): undo() puts back the board
+    // as it was when the move was applied, so cards dealt after a move go
+    // with it. Anything else that changes the chips leaves nothing to
+    // undo. apply() returns false, changing nothing, when nobody is left
+    // to act.
+    bool apply(Action action, int64_t amount = 0);
+    void undo();
+    bool canUndo() const { return !undo_.empty(); }
+
+    // 64-bit hash of hero's seat and cards, the board and the table state,
+    // kept up to date incrementally; two move orders reaching the same
+    // state hash alike, to key transposition tables and decision caches
+    uint64_t hash() const { return hash_; }
+
+    // Who sits where, for a stats store that outlives the hand: every
+    // recorded action is also counted against the seat's player. Ids come
+    // from OpponentStats::add(); seats without one aren't counted.
+    void setOpponentStats(OpponentStats* stats) { opponentStats_ = stats; }
+    void seatPlayer(Position pos, uint32_t player) { playerIds_[static_cast<int>(pos)] = player; }
+    const OpponentStats* opponentStats() const { return opponentStats_; }
+    uint32_t playerAt(Position pos) const { return playerIds_[static_cast<int>(pos)]; }
+
+    // Changes on every newHand(), so observers can tell hands apart
+    uint32_t handId() const { return handId_; }
 
     // Cards
     CardSet heroCards() const { return heroCards_; }
@@ -85,42 +251,59 @@ public:
     int handsPlayed() const { return handsPlayed_; }
     int handsWon() const { return handsWon_; }
 
-    // Calculation helpers
+    // Calculation helpers, for hero, exact multiway: only chips hero can
+    // win count towards the pot, and only the deepest opponent still in
+    // caps the stack
     double potOdds() const;     // Returns as percentage (0.0 to 1.0)
     double spr() const;         // Stack-to-Pot Ratio
     int64_t effectiveStack() const;
 
     // String helpers
     static std::string positionToString(Position pos);
+    static std::optional<Position> positionFromString(std::string_view text);  // Any case; "BUTTON" too
     static std::string actionToString(Action action);
     static std::string streetToString(Street street);
 
 private:
-    void updatePot(int64_t amount) { pot_ += amount; }
-    void deductFromStack(int64_t amount) { heroStack_ -= amount; }
+    int heroSeat() const { return static_cast<int>(heroPosition_); }
+    void seatEveryone(int64_t stack);
+
+    // Moves chips and logs the action, keeping the hash current
+    void step(int seat, Action action, int64_t amount);
+
+    // After a change to the chips outside apply(): recompute the hash and
+    // forget the undo stack, which no longer leads back anywhere
+    void tableChanged();
+
+    struct Undo {
+        TableState table;
+        CardSet board;
+        uint64_t hash;
+    };
 
     // Game state
     int playerCount_;
     int sb_, bb_;
     Position heroPosition_;
-    int64_t heroStack_;
-    std::array<int64_t, 6> opponentStacks_;  // indexed by Position
 
     // Cards
     CardSet heroCards_;
     CardSet board_;
 
-    // Betting
-    int64_t pot_;
-    int64_t currentBet_;
-    int64_t toCall_;
-    Street street_;
+    // Stacks, bets and pots of every seat
+    TableState table_;
+    uint64_t hash_;
+    std::vector<Undo> undo_;
 
     // Hand history
-    std::array<ActionRecord, 50> actionHistory_;
-    size_t actionCount_;
+    ActionLog actions_;
+    uint32_t handId_;
     int64_t initialHeroStack_;
 
+    // Long-lived opponent stats (not owned) and the player in each seat
+    OpponentStats* opponentStats_;
+    std::array<uint32_t, 6> playerIds_;
+
     // Session tracking
     int64_t sessionProfit_;
     int handsPlayed_;
@@ -1,168 +1,235 @@
 #include "gto_charts.h"
+#include "preflop_strategy.h"
+#include "push_fold.h"
+#include "rng.h"
 #include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <format>
+#include <mutex>
 
 namespace sharkwave {
 
 namespace {
     constexpr int rankToInt(Rank r) { return static_cast<int>(r); }
 
-    // UTG opening range: ~15% - 77+, ATs+, KQs, AJo+, KQo
-    bool inUTGRange(Card c1, Card c2) {
-        int r1 = rankToInt(c1.rank());
-        int r2 = rankToInt(c2.rank());
-        bool suited = (c1.suit() == c2.suit());
-        bool paired = (r1 == r2);
-        int high = std::max(r1, r2);
-        int low = std::min(r1, r2);
+    std::atomic<std::shared_ptr<const PushFoldTables>> pushFold;
+    std::atomic<std::shared_ptr<const PreflopStrategy>> charts;
 
+    // Where the loaded charts came from, to notice when they're rewritten
+    struct ChartSource {
+        std::mutex mutex;
+        std::string path;
+        std::filesystem::file_time_type written;
+        uintmax_t size = 0;
+    };
+
+    ChartSource& chartSource() {
+        static ChartSource source;
+        return source;
+    }
+
+    const std::shared_ptr<const PreflopStrategy>& builtInStrategy() {
+        static const std::shared_ptr<const PreflopStrategy> strategy =
+            std::make_shared<const PreflopStrategy>(PreflopStrategy::builtIn());
+        return strategy;
+    }
+
+    // A hand class as its two ranks (2-14, high first) and whether it's suited
+    struct ClassHand {
+        int high;
+        int low;
+        bool suited;
+
+        constexpr bool paired() const { return high == low; }
+    };
+
+    constexpr ClassHand classHand(int cls) {
+        int row = cls / 13;
+        int col = cls % 13;
+        int high = 14 - (row < col ? row : col);
+        int low = 14 - (row < col ? col : row);
+        return {high, low, row < col};
+    }
+
+    // Every class the chart predicate accepts, evaluated at compile time
+    template <typename Chart>
+    constexpr HandClassSet rangeOf(Chart inChart) {
+        HandClassSet range;
+        for (int cls = 0; cls < kNumHandClasses; ++cls) {
+            if (inChart(classHand(cls))) range.set(cls);
+        }
+        return range;
+    }
+
+    // UTG opening range: ~15% - 77+, ATs+, KQs, QJs, AJo+, KQo
+    constexpr bool utgOpen(ClassHand h) {
         // Pairs 77+
-        if (paired && r1 >= 7) return true;
+        if (h.paired()) return h.high >= 7;
 
         // High suited
-        if (suited) {
-            if (high == 14 && low >= 10) return true; // ATs+
-            if (high == 13 && low == 12) return true; // KQs
-            if (high == 12 && low == 11) return true; // QJs
+        if (h.suited) {
+            if (h.high == 14 && h.low >= 10) return true; // ATs+
+            if (h.high == 13 && h.low == 12) return true; // KQs
+            if (h.high == 12 && h.low == 11) return true; // QJs
+            return false;
         }
 
         // High offsuit
-        if (!suited) {
-            if (high == 14 && low >= 11) return true; // AJo+
-            if (high == 13 && low == 12) return true; // KQo
-        }
-
+        if (h.high == 14 && h.low >= 11) return true; // AJo+
+        if (h.high == 13 && h.low == 12) return true; // KQo
         return false;
     }
 
-    // MP opening range: ~19% - 66+, ATs+, KJs+, QJs, AJo+, KQo
-    bool inMPRange(Card c1, Card c2) {
-        int r1 = rankToInt(c1.rank());
-        int r2 = rankToInt(c2.rank());
-        bool suited = (c1.suit() == c2.suit());
-        bool paired = (r1 == r2);
-        int high = std::max(r1, r2);
-        int low = std::min(r1, r2);
-
+    // MP opening range: ~19% - 66+, A9s+, KTs+, QJs, ATo+, KJo+, QJo
+    constexpr bool mpOpen(ClassHand h) {
         // Pairs 66+
-        if (paired && r1 >= 6) return true;
+        if (h.paired()) return h.high >= 6;
 
         // Suited
-        if (suited) {
-            if (high == 14 && low >= 9) return true;  // A9s+
-            if (high == 13 && low >= 10) return true; // KTs+
-            if (high == 12 && low >= 11) return true; // QJs+
+        if (h.suited) {
+            if (h.high == 14 && h.low >= 9) return true;  // A9s+
+            if (h.high == 13 && h.low >= 10) return true; // KTs+
+            if (h.high == 12 && h.low >= 11) return true; // QJs+
+            return false;
         }
 
         // Offsuit
-        if (!suited) {
-            if (high == 14 && low >= 10) return true; // ATo+
-            if (high == 13 && low >= 11) return true; // KJo+
-            if (high == 12 && low == 11) return true; // QJo
-        }
-
+        if (h.high == 14 && h.low >= 10) return true; // ATo+
+        if (h.high == 13 && h.low >= 11) return true; // KJo+
+        if (h.high == 12 && h.low == 11) return true; // QJo
         return false;
     }
 
-    // CO opening range: ~28% - 55+, ATs+, KTs+, QJs+, JTs, ATo+, KJo+, QJo
-    bool inCORange(Card c1, Card c2) {
-        int r1 = rankToInt(c1.rank());
-        int r2 = rankToInt(c2.rank());
-        bool suited = (c1.suit() == c2.suit());
-        bool paired = (r1 == r2);
-        int high = std::max(r1, r2);
-        int low = std::min(r1, r2);
-
+    // CO opening range: ~28% - 55+, A7s+, K8s+, Q9s+, J9s+, T9s, A9o+, KTo+, QTo+, JTo
+    constexpr bool coOpen(ClassHand h) {
         // Pairs 55+
-        if (paired && r1 >= 5) return true;
-
-        // Suited - THIS WAS THE BUG: JTc should raise
-        if (suited) {
-            if (high == 14 && low >= 7) return true;  // A7s+
-            if (high == 13 && low >= 8) return true;  // K8s+
-            if (high == 12 && low >= 9) return true;  // Q9s+
-            if (high == 11 && low >= 9) return true;  // J9s+
-            if (high == 10 && low >= 9) return true;  // T9s
-        }
+        if (h.paired()) return h.high >= 5;
 
-        // Offsuit
-        if (!suited) {
-            if (high == 14 && low >= 9) return true;  // A9o+
-            if (high == 13 && low >= 10) return true; // KTo+
-            if (high == 12 && low >= 10) return true; // QTo+
-            if (high == 11 && low >= 10) return true; // JTo
+        // Suited
+        if (h.suited) {
+            if (h.high == 14 && h.low >= 7) return true;  // A7s+
+            if (h.high == 13 && h.low >= 8) return true;  // K8s+
+            if (h.high == 12 && h.low >= 9) return true;  // Q9s+
+            if (h.high == 11 && h.low >= 9) return true;  // J9s+
+            if (h.high == 10 && h.low >= 9) return true;  // T9s
+            return false;
         }
 
+        // Offsuit
+        if (h.high == 14 && h.low >= 9) return true;  // A9o+
+        if (h.high == 13 && h.low >= 10) return true; // KTo+
+        if (h.high == 12 && h.low >= 10) return true; // QTo+
+        if (h.high == 11 && h.low >= 10) return true; // JTo
         return false;
     }
 
     // BTN opening range: ~45% - very wide
-    bool inBTNRange(Card c1, Card c2) {
-        int r1 = rankToInt(c1.rank());
-        int r2 = rankToInt(c2.rank());
-        bool suited = (c1.suit() == c2.suit());
-        bool paired = (r1 == r2);
-        int high = std::max(r1, r2);
-        int low = std::min(r1, r2);
-
+    constexpr bool btnOpen(ClassHand h) {
         // All pairs
-        if (paired) return true;
+        if (h.paired()) return true;
 
         // Suited - almost all suited connectors and gappers
-        if (suited) {
-            if (high == 14 && low >= 2) return true;  // All Ax suited
-            if (high == 13 && low >= 5) return true;  // K5s+
-            if (high == 12 && low >= 6) return true;  // Q6s+
-            if (high >= 9 && low >= 5) return true;   // J9s+, T9s, 98s
-            if (high - low <= 3 && high >= 7) return true; // Connected 1-3 gap
+        if (h.suited) {
+            if (h.high == 14) return true;                      // All Ax suited
+            if (h.high == 13 && h.low >= 5) return true;        // K5s+
+            if (h.high == 12 && h.low >= 6) return true;        // Q6s+
+            if (h.high >= 9 && h.low >= 5) return true;         // J9s+, T9s, 98s
+            if (h.high - h.low <= 3 && h.high >= 7) return true; // Connected 1-3 gap
+            return false;
         }
 
         // Offsuit - more selective
-        if (!suited) {
-            if (high == 14 && low >= 5) return true;  // A5o+
-            if (high == 13 && low >= 8) return true;  // K8o+
-            if (high == 12 && low >= 9) return true;  // Q9o+
-            if (high == 11 && low >= 9) return true;  // J9o+
-            if (high >= 9 && high - low <= 1) return true; // JTo, T9o
-        }
-
+        if (h.high == 14 && h.low >= 5) return true;            // A5o+
+        if (h.high == 13 && h.low >= 8) return true;            // K8o+
+        if (h.high == 12 && h.low >= 9) return true;            // Q9o+
+        if (h.high == 11 && h.low >= 9) return true;            // J9o+
+        if (h.high >= 9 && h.high - h.low <= 1) return true;    // JTo, T9o
         return false;
     }
 
     // SB opening range: ~38% - wide but cautious of BB
-    bool inSBRange(Card c1, Card c2) {
-        int r1 = rankToInt(c1.rank());
-        int r2 = rankToInt(c2.rank());
-        bool suited = (c1.suit() == c2.suit());
-        bool paired = (r1 == r2);
-        int high = std::max(r1, r2);
-        int low = std::min(r1, r2);
-
+    constexpr bool sbOpen(ClassHand h) {
         // All pairs
-        if (paired) return true;
+        if (h.paired()) return true;
 
         // Suited - strong suited hands
-        if (suited) {
-            if (high == 14 && low >= 4) return true;  // A4s+
-            if (high == 13 && low >= 6) return true;  // K6s+
-            if (high == 12 && low >= 7) return true;  // Q7s+
-            if (high == 11 && low >= 8) return true;  // J8s+
-            if (high == 10 && low >= 8) return true;  // T8s+
+        if (h.suited) {
+            if (h.high == 14 && h.low >= 4) return true;  // A4s+
+            if (h.high == 13 && h.low >= 6) return true;  // K6s+
+            if (h.high == 12 && h.low >= 7) return true;  // Q7s+
+            if (h.high == 11 && h.low >= 8) return true;  // J8s+
+            if (h.high == 10 && h.low >= 8) return true;  // T8s+
+            return false;
         }
 
         // Offsuit
-        if (!suited) {
-            if (high == 14 && low >= 7) return true;  // A7o+
-            if (high == 13 && low >= 9) return true;  // K9o+
-            if (high == 12 && low >= 9) return true;  // Q9o+
-            if (high == 11 && low >= 9) return true;  // J9o
-        }
-
+        if (h.high == 14 && h.low >= 7) return true;  // A7o+
+        if (h.high == 13 && h.low >= 9) return true;  // K9o+
+        if (h.high == 12 && h.low >= 9) return true;  // Q9o+
+        if (h.high == 11 && h.low >= 9) return true;  // J9o
         return false;
     }
+
+    // 3-bet range: QQ+, AK, AQs, KQs
+    constexpr bool threeBet(ClassHand h) {
+        if (h.paired()) return h.high >= 12;
+        if (h.high == 14 && h.low == 13) return true;
+        return h.suited && ((h.high == 14 && h.low == 12) || (h.high == 13 && h.low == 12));
+    }
+
+    // 4-bet range: KK+, AKs
+    constexpr bool fourBet(ClassHand h) {
+        if (h.paired()) return h.high >= 13;
+        return h.suited && h.high == 14 && h.low == 13;
+    }
+
+    // Call 3-bet: 99-JJ, AQs-AJs, suited connectors 98s+ (KQs among them)
+    constexpr bool call3bet(ClassHand h) {
+        if (h.paired()) return h.high >= 9 && h.high <= 11;
+        if (!h.suited) return false;
+        if (h.high == 14 && h.low >= 11 && h.low <= 12) return true;
+        return h.high >= 9 && h.high - h.low == 1;
+    }
+
+    // Ranges by position. Only opening depends on the seat so far; the rest
+    // are the same table six times, ready for per-position charts.
+    constexpr std::array<HandClassSet, 6> kOpen = {
+        rangeOf(utgOpen), rangeOf(mpOpen), rangeOf(coOpen), rangeOf(btnOpen), rangeOf(sbOpen),
+        HandClassSet{}      // Can't open from BB
+    };
+
+    constexpr std::array<HandClassSet, 6> samePerPosition(HandClassSet range) {
+        return {range, range, range, range, range, range};
+    }
+
+    constexpr std::array<HandClassSet, 6> k3bet = samePerPosition(rangeOf(threeBet));
+    constexpr std::array<HandClassSet, 6> k4bet = samePerPosition(rangeOf(fourBet));
+    constexpr std::array<HandClassSet, 6> kCall3bet = samePerPosition(rangeOf(call3bet));
+
+    static_assert(kOpen[0].count() == 18, "UTG opens 77+, ATs+, KQs, QJs, AJo+, KQo");
+}
+
+GtoDecision GtoCharts::getAction(Position pos, const CardSet& holeCards,
+                                 int bigBlinds, bool facingRaise, int players) {
+    PreflopSpot spot = facingRaise ? PreflopSpot::VsRaise : PreflopSpot::Open;
+    return decide(pos, holeCards, bigBlinds, spot, players, nullptr);
 }
 
 GtoDecision GtoCharts::getAction(Position pos, const CardSet& holeCards,
-                                 int bigBlinds, bool facingRaise) {
+                                 int bigBlinds, bool facingRaise, Rng& rng, int players) {
+    PreflopSpot spot = facingRaise ? PreflopSpot::VsRaise : PreflopSpot::Open;
+    return decide(pos, holeCards, bigBlinds, spot, players, &rng);
+}
+
+GtoDecision GtoCharts::getAction(Position pos, const CardSet& holeCards,
+                                 int bigBlinds, PreflopSpot spot, Rng& rng, int players) {
+    return decide(pos, holeCards, bigBlinds, spot, players, &rng);
+}
+
+GtoDecision GtoCharts::decide(Position pos, const CardSet& holeCards, int bigBlinds,
+                              PreflopSpot spot, int players, Rng* rng) {
+    bool facingRaise = spot != PreflopSpot::Open;
     if (holeCards.count < 2) {
         return {GtoAction::Fold, 0};
     }
@@ -172,90 +239,128 @@ GtoDecision GtoCharts::getAction(Position pos, const CardSet& holeCards,
 
     // Short stack - shove or fold
     if (bigBlinds < 25) {
+        // Heads-up the button posts the small blind, which is where the
+        // charts keep its ranges
+        Position chartPos = players <= 2 && pos == Position::BTN ? Position::SB : pos;
+
+        // Facing a shove, assume it came from the seat just before ours
+        int seat = static_cast<int>(chartPos);
+        int firstSeat = 6 - std::clamp(players, 2, 6);
+        std::shared_ptr<const PushFoldTables> tables = pushFold.load(std::memory_order_acquire);
+        if (tables && (!facingRaise || seat > firstSeat)) {
+            const PushFoldChart& chart = tables->find(players, bigBlinds);
+            bool play = facingRaise ? chart.shouldCall(static_cast<Position>(seat - 1), chartPos, c1, c2)
+                                    : chart.shouldShove(chartPos, c1, c2);
+            return {play ? GtoAction::AllIn : GtoAction::Fold, 0};
+        }
+
         if (isPremium(c1, c2) || isBrodier(c1, c2) || isSpeculative(c1, c2)) {
             return {GtoAction::AllIn, 0};
         }
         return {GtoAction::Fold, 0};
     }
 
-    if (facingRaise) {
-        // 3-bet or call logic
-        if (should3bet(pos, c1, c2)) {
-            return {GtoAction::Raise, static_cast<int>(bigBlinds * 2.5)};
-        }
-        if (shouldCall3bet(pos, c1, c2)) {
-            return {GtoAction::Call, 0};
-        }
-        return {GtoAction::Fold, 0};
+    // One strategy for the whole decision, even if it's swapped meanwhile
+    std::shared_ptr<const PreflopStrategy> chart = strategy();
+    DepthBucket depth = depthBucket(bigBlinds);
+    int cls = handClass(c1, c2);
+    const ActionMix& mix = chart->mix(spot, pos, depth, cls);
+    GtoAction action = rng ? chart->sample(spot, pos, depth, cls, rng->next()) : mix.mostLikely();
+
+    int raiseSize = 0;
+    if (action == GtoAction::Raise) {
+        if (facingRaise) raiseSize = static_cast<int>(bigBlinds * 2.5);
+        else raiseSize = pos == Position::SB ? 20 : 25; // 2.5x default
     }
+    return {action, raiseSize, mix[action]};
+}
 
-    // Unopened pot - check opening range
-    if (shouldOpen(pos, c1, c2)) {
-        int raiseSize = 25; // 2.5x default
-        if (pos == Position::SB) raiseSize = 20;
-        return {GtoAction::Raise, raiseSize};
+std::shared_ptr<const PreflopStrategy> GtoCharts::strategy() {
+    std::shared_ptr<const PreflopStrategy> loaded = charts.load(std::memory_order_acquire);
+    return loaded ? loaded : builtInStrategy();
+}
+
+void GtoCharts::setStrategy(std::shared_ptr<const PreflopStrategy> strategy) {
+    charts.store(std::move(strategy), std::memory_order_release);
+}
+
+bool GtoCharts::loadCharts(const std::string& path, std::string& error) {
+    ChartSource& source = chartSource();
+    std::lock_guard lock(source.mutex);
+
+    // Stat first: a rewrite after the stat shows up as a change next time
+    std::error_code timeError, sizeError;
+    auto written = std::filesystem::last_write_time(path, timeError);
+    uintmax_t size = std::filesystem::file_size(path, sizeError);
+    if (timeError || sizeError) {
+        error = std::format("cannot read {}: {}", path, (timeError ? timeError : sizeError).message());
+        return false;
     }
 
-    return {GtoAction::Fold, 0};
+    std::optional<PreflopStrategy> strategy = PreflopStrategy::load(path, error);
+    if (!strategy) return false;
+    setStrategy(std::make_shared<const PreflopStrategy>(std::move(*strategy)));
+    source.path = path;
+    source.written = written;
+    source.size = size;
+    return true;
 }
 
-bool GtoCharts::shouldOpen(Position pos, Card c1, Card c2) {
-    switch (pos) {
-        case Position::UTG: return inUTGRange(c1, c2);
-        case Position::MP:  return inMPRange(c1, c2);
-        case Position::CO:  return inCORange(c1, c2);
-        case Position::BTN: return inBTNRange(c1, c2);
-        case Position::SB:  return inSBRange(c1, c2);
-        case Position::BB:  return false; // Can't open from BB
+bool GtoCharts::reloadChartsIfChanged() {
+    std::string path;
+    {
+        ChartSource& source = chartSource();
+        std::lock_guard lock(source.mutex);
+        if (source.path.empty()) return false;
+
+        std::error_code timeError, sizeError;
+        auto written = std::filesystem::last_write_time(source.path, timeError);
+        uintmax_t size = std::filesystem::file_size(source.path, sizeError);
+        if (timeError || sizeError || (written == source.written && size == source.size)) return false;
+        path = source.path;
     }
-    return false;
+    std::string error;
+    return loadCharts(path, error);
 }
 
-bool GtoCharts::should3bet(Position pos, Card c1, Card c2) {
-    (void)pos;
-    int r1 = rankToInt(c1.rank());
-    int r2 = rankToInt(c2.rank());
-    bool suited = (c1.suit() == c2.suit());
-    bool paired = (r1 == r2);
-    int high = std::max(r1, r2);
+void GtoCharts::setPushFoldTables(std::shared_ptr<const PushFoldTables> tables) {
+    pushFold.store(std::move(tables), std::memory_order_release);
+}
 
-    // 3-bet range: QQ+, AK, AQs
-    if (paired && r1 >= 12) return true; // QQ+
-    if (high == 14 && r2 == 13) return true; // AK
-    if (suited && high == 14 && r2 >= 12) return true; // AQs+
-    if (suited && high == 13 && r2 == 12) return true; // KQs
+std::shared_ptr<const PushFoldTables> GtoCharts::pushFoldTables() {
+    return pushFold.load(std::memory_order_acquire);
+}
 
-    return false;
+bool GtoCharts::shouldOpen(Position pos, Card c1, Card c2) {
+    return inRfiRange(pos, handToIndex(c1, c2));
+}
+
+bool GtoCharts::should3bet(Position pos, Card c1, Card c2) {
+    return in3betRange(pos, handToIndex(c1, c2));
 }
 
 bool GtoCharts::should4bet(Position pos, Card c1, Card c2) {
-    (void)pos;
-    int r1 = rankToInt(c1.rank());
-    int r2 = rankToInt(c2.rank());
-    bool paired = (r1 == r2);
+    return in4betRange(pos, handToIndex(c1, c2));
+}
 
-    // 4-bet range: KK+, AKs
-    if (paired && r1 >= 13) return true; // KK+
-    if (r1 == 14 && r2 == 13 && c1.suit() == c2.suit()) return true; // AKs
+bool GtoCharts::shouldCall3bet(Position pos, Card c1, Card c2) {
+    return inCall3betRange(pos, handToIndex(c1, c2));
+}
 
-    return false;
+const HandClassSet& GtoCharts::openRange(Position pos) {
+    return kOpen[static_cast<int>(pos)];
 }
 
-bool GtoCharts::shouldCall3bet(Position pos, Card c1, Card c2) {
-    (void)pos;
-    int r1 = rankToInt(c1.rank());
-    int r2 = rankToInt(c2.rank());
-    bool suited = (c1.suit() == c2.suit());
-    bool paired = (r1 == r2);
-    int high = std::max(r1, r2);
+const HandClassSet& GtoCharts::threeBetRange(Position pos) {
+    return k3bet[static_cast<int>(pos)];
+}
 
-    // Call 3-bet: TT-99, AQs-AJs, KQs, T9s-98s
-    if (paired && r1 >= 9 && r1 <= 11) return true; // 99-JJ
-    if (suited && high == 14 && r2 >= 11 && r2 <= 12) return true; // AQs-AJs
-    if (suited && high == 13 && r2 == 12) return true; // KQs
-    if (suited && high >= 9 && (high - r2) <= 1) return true; // Suited connectors 98+
+const HandClassSet& GtoCharts::fourBetRange(Position pos) {
+    return k4bet[static_cast<int>(pos)];
+}
 
-    return false;
+const HandClassSet& GtoCharts::call3betRange(Position pos) {
+    return kCall3bet[static_cast<int>(pos)];
 }
 
 int GtoCharts::handType(Card c1, Card c2) {
@@ -311,39 +416,23 @@ bool GtoCharts::isSpeculative(Card c1, Card c2) {
 }
 
 uint16_t GtoCharts::handToIndex(Card c1, Card c2) {
-    int r1 = rankToInt(c1.rank());
-    int r2 = rankToInt(c2.rank());
-    bool suited = (c1.suit() == c2.suit());
-
-    if (r1 < r2) std::swap(r1, r2);
-
-    uint16_t type = suited ? 1 : (r1 == r2 ? 0 : 2);
-    return static_cast<uint16_t>(r1 * 100 + r2 * 2 + type);
+    return static_cast<uint16_t>(handClass(c1, c2));
 }
 
-// Stub implementations for remaining functions
 bool GtoCharts::inRfiRange(Position pos, uint16_t handIdx) {
-    (void)pos;
-    (void)handIdx;
-    return false;
+    return kOpen[static_cast<int>(pos)].test(handIdx);
 }
 
 bool GtoCharts::in3betRange(Position pos, uint16_t handIdx) {
-    (void)pos;
-    (void)handIdx;
-    return false;
+    return k3bet[static_cast<int>(pos)].test(handIdx);
 }
 
 bool GtoCharts::in4betRange(Position pos, uint16_t handIdx) {
-    (void)pos;
-    (void)handIdx;
-    return false;
+    return k4bet[static_cast<int>(pos)].test(handIdx);
 }
 
 bool GtoCharts::inCall3betRange(Position pos, uint16_t handIdx) {
-    (void)pos;
-    (void)handIdx;
-    return false;
+    return kCall3bet[static_cast<int>(pos)].test(handIdx);
 }
 
 } // namespace sharkwave
@@ -2,9 +2,17 @@
 
 #include "card.h"
 #include "game_session.h"
+#include "range.h"
+#include <memory>
+#include <string>
 
 namespace sharkwave {
 
+class PreflopStrategy;
+class PushFoldTables;
+class Rng;
+enum class PreflopSpot : uint8_t;
+
 enum class GtoAction : uint8_t {
     Fold,
     Call,
@@ -15,20 +23,64 @@ enum class GtoAction : uint8_t {
 struct GtoDecision {
     GtoAction action;
     int raiseSize; // as multiple of BB, 0 for N/A
+    uint8_t frequency = 255;    // How often the chart takes this action, in 255ths
 };
 
 class GtoCharts {
 public:
-    // Get GTO action for a given situation
+    // Get GTO action for a given situation. Under 25bb it's push or fold,
+    // from the solved charts when they're loaded (heads-up ones for
+    // players == 2) and a fixed shove list otherwise.
+    static GtoDecision getAction(Position pos, const CardSet& holeCards,
+                                 int bigBlinds, bool facingRaise, int players = 6);
+
+    // The same, but drawing from the chart's mixed strategy instead of
+    // always taking its most frequent action
     static GtoDecision getAction(Position pos, const CardSet& holeCards,
-                                 int bigBlinds, bool facingRaise);
+                                 int bigBlinds, bool facingRaise, Rng& rng, int players = 6);
+
+    // The same for any spot the charts cover, Vs3bet included. Under 25bb
+    // every spot but Open is a call-or-fold against a shove.
+    static GtoDecision getAction(Position pos, const CardSet& holeCards,
+                                 int bigBlinds, PreflopSpot spot, Rng& rng, int players = 6);
+
+    // Per-hand action frequencies behind getAction, 25bb and deeper: the
+    // built-in ones unless charts have been loaded
+    static std::shared_ptr<const PreflopStrategy> strategy();
 
-    // Preflop opening ranges by position
+    // Swap in a strategy (nullptr to go back to the built-in one). Safe
+    // while other threads are deciding; a decision already under way
+    // finishes on the strategy it started with, which stays alive (and
+    // mapped) until it does.
+    static void setStrategy(std::shared_ptr<const PreflopStrategy> strategy);
+
+    // Maps a chart file from PreflopStrategy::save() and swaps it in. On
+    // failure, keeps the current charts, returns false and says why in
+    // `error`.
+    static bool loadCharts(const std::string& path, std::string& error);
+
+    // Loads the last loadCharts() file again if it has been rewritten
+    // since; one stat() when it hasn't. True if new charts went in.
+    static bool reloadChartsIfChanged();
+
+    // Swap in push/fold charts (nullptr to go back to the shove list). Safe
+    // while other threads are deciding; each lookup sees one set of charts.
+    static void setPushFoldTables(std::shared_ptr<const PushFoldTables> tables);
+    static std::shared_ptr<const PushFoldTables> pushFoldTables();
+
+    // Preflop ranges by position. Each is a compile-time 169-bit table, so
+    // every check is one bit test.
     static bool shouldOpen(Position pos, Card c1, Card c2);
     static bool should3bet(Position pos, Card c1, Card c2);
     static bool should4bet(Position pos, Card c1, Card c2);
     static bool shouldCall3bet(Position pos, Card c1, Card c2);
 
+    // The same ranges whole, for set operations and combo counts
+    static const HandClassSet& openRange(Position pos);
+    static const HandClassSet& threeBetRange(Position pos);
+    static const HandClassSet& fourBetRange(Position pos);
+    static const HandClassSet& call3betRange(Position pos);
+
     // Hand strength utilities
     static int handType(Card c1, Card c2);
     static bool isPremium(Card c1, Card c2);
@@ -36,10 +88,12 @@ public:
     static bool isSpeculative(Card c1, Card c2);
 
 private:
-    // Convert hand to index for lookup table
+    static GtoDecision decide(Position pos, const CardSet& holeCards, int bigBlinds,
+                              PreflopSpot spot, int players, Rng* rng);
+
+    // Hand class (see handClass()), the index into the range tables
     static uint16_t handToIndex(Card c1, Card c2);
 
-    // Range definitions (simplified for MVP)
     static bool inRfiRange(Position pos, uint16_t handIdx);
     static bool in3betRange(Position pos, uint16_t handIdx);
     static bool in4betRange(Position pos, uint16_t handIdx);
@@ -253,7 +253,7 @@ void PokerGui::makeDecision() {
     }
 
     state_.decisionOutput = actionStr;
-    state_.reasonOutput = decision.reason;
+    state_.reasonOutput = decision.reason.text();
 
     // Calculate equity
     double equity = HandEvaluator::calculateEquity(session.heroCards(), session.board(), 500);
@@ -283,7 +283,7 @@ void PokerGui::makeDecision() {
 
     logDebug("=== DECISION COMPLETE ===");
     logDebug("Action: %s", actionStr.c_str());
-    logDebug("Reason: %s", decision.reason.c_str());
+    logDebug("Reason: %s", state_.reasonOutput.c_str());
     logDebug("Equity: %s", eqBuf);
     logDebug("SPR: %s", sprBuf);
 }
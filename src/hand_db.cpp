@@ -0,0 +1,590 @@
+#include "hand_db.h"
+#include "board_texture.h"
+#include "hand_history.h"
+#include "range.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace sharkwave {
+
+namespace {
+    namespace fs = std::filesystem;
+
+    // Cells are written as the low bytes of a word
+    static_assert(std::endian::native == std::endian::little);
+
+    struct ColumnInfo {
+        const char* name;
+        size_t width;
+    };
+
+    constexpr std::array<ColumnInfo, kNumHandColumns> kColumns{{
+        {"position", 1}, {"class", 1}, {"hole", 2}, {"board", 8}, {"street", 1},
+        {"actions", 4}, {"flags", 2}, {"texture", 8}, {"profit", 4},
+    }};
+
+    constexpr std::string_view kMagic = "SWHANDDB";
+    constexpr uint32_t kVersion = 1;
+
+    struct MetaFile {
+        char magic[8];
+        uint32_t version;
+        uint32_t columns;
+        uint64_t rows;
+    };
+
+    // Rows per block: a block's pass flags and passing rows stay in L1
+    constexpr size_t kBlockRows = 4096;
+
+    constexpr std::array<std::string_view, 7> kTextureNames{
+        "dry-high", "dry-low", "paired", "two-tone", "connected", "dynamic", "monotone"};
+
+    std::string columnPath(const std::string& dir, int column) {
+        return (fs::path(dir) / std::format("{}.col", kColumns[column].name)).string();
+    }
+
+    std::string metaPath(const std::string& dir) { return (fs::path(dir) / "hands.meta").string(); }
+
+    // The committed row count; 0 for a database not created yet unless it
+    // must exist
+    std::optional<uint64_t> readRowCount(const std::string& dir, bool mustExist, std::string& error) {
+        std::ifstream in(metaPath(dir), std::ios::binary);
+        if (!in) {
+            if (!mustExist && !fs::exists(metaPath(dir))) return 0;
+            error = std::format("no hand database in {}", dir);
+            return std::nullopt;
+        }
+        MetaFile meta{};
+        in.read(reinterpret_cast<char*>(&meta), sizeof(meta));
+        if (!in || std::string_view(meta.magic, sizeof(meta.magic)) != kMagic || meta.version != kVersion ||
+            meta.columns != kNumHandColumns) {
+            error = std::format("{} isn't a hand database this version can read", metaPath(dir));
+            return std::nullopt;
+        }
+        return meta.rows;
+    }
+
+    bool writeRowCount(const std::string& dir, uint64_t rows, std::string& error) {
+        MetaFile meta{};
+        std::memcpy(meta.magic, kMagic.data(), kMagic.size());
+        meta.version = kVersion;
+        meta.columns = kNumHandColumns;
+        meta.rows = rows;
+
+        std::string path = metaPath(dir);
+        std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&meta), sizeof(meta));
+            out.flush();
+            if (!out) {
+                error = std::format("cannot write {}", tmpPath);
+                return false;
+            }
+        }
+        std::error_code ec;
+        fs::rename(tmpPath, path, ec);
+        if (ec) {
+            error = std::format("cannot replace {}: {}", path, ec.message());
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t cell(const HandRow& row, HandColumn column) {
+        switch (column) {
+            case HandColumn::Position:  return static_cast<uint64_t>(row.position);
+            case HandColumn::HandClass: return row.handClass;
+            case HandColumn::Hole:      return row.hole;
+            case HandColumn::Board:     return row.board;
+            case HandColumn::Street:    return static_cast<uint64_t>(row.street);
+            case HandColumn::Actions:   return row.actions;
+            case HandColumn::Flags:     return row.flags;
+            case HandColumn::Texture:   return row.texture;
+            case HandColumn::Profit:    return static_cast<uint32_t>(row.profit);
+        }
+        return 0;
+    }
+
+    // One flat pass over a block of a column, no branches, so it vectorizes
+    template <typename T>
+    void passRange(const T* cells, size_t n, T mask, T lo, T hi, uint8_t* pass) {
+        for (size_t i = 0; i < n; ++i) {
+            T value = static_cast<T>(cells[i] & mask);
+            pass[i] &= static_cast<uint8_t>(value >= lo) & static_cast<uint8_t>(value <= hi);
+        }
+    }
+
+    template <typename T>
+    void passValues(const T* cells, size_t n, T mask, const uint8_t* values, uint8_t* pass) {
+        for (size_t i = 0; i < n; ++i) {
+            pass[i] &= values[static_cast<uint8_t>(cells[i] & mask)];
+        }
+    }
+
+    template <typename T>
+    void applyFilter(const HandFilter& filter, const std::byte* column, size_t first, size_t n, uint8_t* pass) {
+        const T* cells = reinterpret_cast<const T*>(column) + first;
+        const T mask = static_cast<T>(filter.mask);
+        if (!filter.values.empty()) {
+            passValues(cells, n, mask, filter.values.data(), pass);
+            return;
+        }
+
+        constexpr T kMax = std::numeric_limits<T>::max();
+        T lo, hi;
+        if constexpr (std::is_signed_v<T>) {
+            lo = static_cast<T>(std::clamp<int64_t>(filter.lo, std::numeric_limits<T>::min(), kMax));
+            hi = static_cast<T>(std::clamp<int64_t>(filter.hi, std::numeric_limits<T>::min(), kMax));
+        } else {
+            lo = static_cast<T>(std::min<uint64_t>(std::max<int64_t>(filter.lo, 0), kMax));
+            hi = filter.hi < 0 ? kMax : static_cast<T>(std::min<uint64_t>(filter.hi, kMax));
+        }
+        passRange(cells, n, mask, lo, hi, pass);
+    }
+
+    Street streetOf(const CardSet& board) {
+        return board.count >= 5 ? Street::River : board.count == 4 ? Street::Turn
+               : board.count == 3 ? Street::Flop : Street::Preflop;
+    }
+
+    std::optional<Street> parseStreet(std::string_view text) {
+        for (int s = 0; s <= static_cast<int>(Street::Showdown); ++s) {
+            std::string name = GameSession::streetToString(static_cast<Street>(s));
+            if (name.size() == text.size() &&
+                std::equal(name.begin(), name.end(), text.begin(), [](char a, char b) {
+                    return a == std::toupper(static_cast<unsigned char>(b));
+                })) {
+                return static_cast<Street>(s);
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Action> parseAction(std::string_view text) {
+        constexpr std::array<std::string_view, 5> kNames{"fold", "check", "call", "bet", "raise"};
+        for (size_t a = 0; a < kNames.size(); ++a) {
+            if (kNames[a] == text) return static_cast<Action>(a);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<uint16_t> parseFlag(std::string_view text) {
+        using enum HandRow::Flags;
+        constexpr std::array<std::pair<std::string_view, uint16_t>, 11> kFlags{{
+            {"vpip", Vpip}, {"pfr", Pfr}, {"3bet", ThreeBet}, {"aggressor", Aggressor},
+            {"saw-flop", SawFlop}, {"cbet-chance", CBetChance}, {"cbet", CBet},
+            {"faced-cbet", FacedCBet}, {"fold-to-cbet", FoldedToCBet},
+            {"showdown", WentToShowdown}, {"won", Won},
+        }};
+        for (const auto& [name, flag] : kFlags) {
+            if (name == text) return flag;
+        }
+        return std::nullopt;
+    }
+
+    // Texture classes a name covers, as [first, last]
+    std::optional<std::pair<int, int>> parseTexture(std::string_view text) {
+        if (text == "dry") return std::pair{0, 2};
+        if (text == "wet") return std::pair{3, 4};
+        if (text == "very-wet") return std::pair{5, 6};
+        for (size_t t = 0; t < kTextureNames.size(); ++t) {
+            if (kTextureNames[t] == text) return std::pair{static_cast<int>(t), static_cast<int>(t)};
+        }
+        return std::nullopt;
+    }
+
+    std::optional<HandColumn> parseGroup(std::string_view text) {
+        if (text == "position") return HandColumn::Position;
+        if (text == "class") return HandColumn::HandClass;
+        if (text == "street") return HandColumn::Street;
+        if (text == "texture") return HandColumn::Texture;
+        return std::nullopt;
+    }
+}
+
+RunningStats HandGroup::bbPer100() const {
+    if (hands == 0) return {};
+    // Thousandths of a big blind a hand are tenths of BB/100
+    double n = static_cast<double>(hands);
+    double mean = profit / 10.0 / n;
+    double m2 = std::max(0.0, (profitSquares - static_cast<double>(profit) * profit / n) / 100.0);
+    return RunningStats::fromState(static_cast<int64_t>(hands), mean, m2);
+}
+
+bool HandDb::append(const std::string& dir, std::span<const HandRow> rows, std::string& error) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        error = std::format("cannot create {}: {}", dir, ec.message());
+        return false;
+    }
+    std::optional<uint64_t> committed = readRowCount(dir, false, error);
+    if (!committed) return false;
+
+    std::vector<char> buffer;
+    for (int c = 0; c < kNumHandColumns; ++c) {
+        const size_t width = kColumns[c].width;
+        const std::string path = columnPath(dir, c);
+        const uint64_t bytes = *committed * width;
+
+        // Drop whatever an append that never committed left behind
+        if (fs::exists(path, ec)) {
+            if (fs::file_size(path, ec) < bytes || ec) {
+                error = std::format("{} is shorter than its {} rows", path, *committed);
+                return false;
+            }
+            fs::resize_file(path, bytes, ec);
+            if (ec) {
+                error = std::format("cannot trim {}: {}", path, ec.message());
+                return false;
+            }
+        } else if (bytes > 0) {
+            error = std::format("{} is missing", path);
+            return false;
+        }
+
+        buffer.resize(rows.size() * width);
+        for (size_t i = 0; i < rows.size(); ++i) {
+            uint64_t value = cell(rows[i], static_cast<HandColumn>(c));
+            std::memcpy(buffer.data() + i * width, &value, width);
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        out.flush();
+        if (!out) {
+            error = std::format("cannot write {}", path);
+            return false;
+        }
+    }
+    return writeRowCount(dir, *committed + rows.size(), error);
+}
+
+std::optional<HandDb> HandDb::open(const std::string& dir, std::string& error) {
+    std::optional<uint64_t> rows = readRowCount(dir, true, error);
+    if (!rows) return std::nullopt;
+
+    HandDb db;
+    db.rows_ = *rows;
+    for (int c = 0; c < kNumHandColumns; ++c) {
+        const std::string path = columnPath(dir, c);
+        std::optional<MappedFile> file = MappedFile::open(path);
+        if (!file || file->size() < *rows * kColumns[c].width) {
+            error = std::format("cannot read {} rows from {}", *rows, path);
+            return std::nullopt;
+        }
+        db.files_[c] = std::move(*file);
+    }
+    return db;
+}
+
+HandQueryResult HandDb::query(const HandQuery& query, ThreadPool* pool) const {
+    auto start = std::chrono::steady_clock::now();
+    HandQueryResult result;
+    result.scanned = rows_;
+
+    const size_t blocks = (rows_ + kBlockRows - 1) / kBlockRows;
+    const size_t chunks = std::min(blocks, pool ? pool->size() * 4 : size_t{1});
+    std::vector<std::array<HandGroup, 256>> partial(chunks);
+
+    const auto* profit = reinterpret_cast<const int32_t*>(files_[static_cast<int>(HandColumn::Profit)].data());
+    const std::byte* keys = query.groupBy ? files_[static_cast<int>(*query.groupBy)].data() : nullptr;
+    const size_t keyWidth = query.groupBy ? kColumns[static_cast<int>(*query.groupBy)].width : 0;
+
+    // A chunk is a run of blocks. Each block's filters clear the pass flags
+    // of rows that fail, the rows left are gathered without a branch, and
+    // only those are summed.
+    auto scan = [&](size_t chunk) {
+        std::array<HandGroup, 256>& groups = partial[chunk];
+        std::array<uint8_t, kBlockRows> pass;
+        std::array<uint32_t, kBlockRows> passed;
+        for (size_t block = blocks * chunk / chunks; block < blocks * (chunk + 1) / chunks; ++block) {
+            const size_t first = block * kBlockRows;
+            const size_t n = std::min(kBlockRows, rows_ - first);
+            std::fill_n(pass.begin(), n, uint8_t{1});
+            for (const HandFilter& filter : query.filters) {
+                const std::byte* column = files_[static_cast<int>(filter.column)].data();
+                if (filter.column == HandColumn::Profit) {
+                    applyFilter<int32_t>(filter, column, first, n, pass.data());
+                    continue;
+                }
+                switch (kColumns[static_cast<int>(filter.column)].width) {
+                    case 1: applyFilter<uint8_t>(filter, column, first, n, pass.data()); break;
+                    case 2: applyFilter<uint16_t>(filter, column, first, n, pass.data()); break;
+                    case 4: applyFilter<uint32_t>(filter, column, first, n, pass.data()); break;
+                    default: applyFilter<uint64_t>(filter, column, first, n, pass.data()); break;
+                }
+            }
+
+            size_t count = 0;
+            for (size_t i = 0; i < n; ++i) {
+                passed[count] = static_cast<uint32_t>(i);
+                count += pass[i];
+            }
+            for (size_t j = 0; j < count; ++j) {
+                const size_t row = first + passed[j];
+                HandGroup& group = groups[keys ? std::to_integer<uint8_t>(keys[row * keyWidth]) : 0];
+                const int64_t p = profit[row];
+                group.hands++;
+                group.profit += p;
+                group.profitSquares += static_cast<double>(p) * static_cast<double>(p);
+            }
+        }
+    };
+    if (pool && chunks > 1) {
+        pool->parallelFor(0, chunks, scan);
+    } else {
+        for (size_t chunk = 0; chunk < chunks; ++chunk) scan(chunk);
+    }
+
+    for (const auto& groups : partial) {
+        for (size_t g = 0; g < groups.size(); ++g) {
+            result.groups[g].merge(groups[g]);
+            result.total.merge(groups[g]);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::optional<HandRow> HandDb::row(const HandRecord& hand, std::span<const ActionRecord> actions) {
+    if (hand.hero < 0 || !hand.knownHole(static_cast<Position>(hand.hero))) return std::nullopt;
+    const int seat = hand.hero;
+
+    // What hero put in, by playing the chips through: the blinds, every
+    // action, and the uncalled bet handed back at the end
+    TableState table;
+    table.stack = hand.stack;
+    table.newHand(hand.sb, hand.bb);
+    bool heroFolded = false;
+    for (const ActionRecord& action : actions) {
+        if (action.street() != table.street) table.endStreet(action.street());
+        table.apply(static_cast<int>(action.position()), action.action(), action.amount());
+        heroFolded |= action.action() == Action::Fold && static_cast<int>(action.position()) == seat;
+    }
+    table.endStreet(Street::Showdown);
+    const int64_t profit = hand.collected[seat] - (hand.stack[seat] - table.stack[seat]);
+
+    CardSet board;
+    for (int i = 0; i < hand.boardCount; ++i) board.add(cardFromIndex(hand.board[i]));
+    const auto& cards = hand.hole[seat];
+    return row(static_cast<Position>(seat), cardFromIndex(cards[0]), cardFromIndex(cards[1]), board, actions,
+               !heroFolded && table.liveSeats() >= 2, profit, hand.bb);
+}
+
+HandRow HandDb::row(Position hero, Card first, Card second, const CardSet& board,
+                    std::span<const ActionRecord> actions, bool showdown, int64_t profit, int64_t bb) {
+    using enum HandRow::Flags;
+    HandRow row;
+    row.position = hero;
+    row.handClass = static_cast<uint8_t>(handClass(first, second));
+    row.hole = static_cast<uint16_t>(cardIndex(first) | cardIndex(second) << 8);
+    row.board = board.mask();
+    if (board.count >= 3) {
+        BoardTexture texture = describeBoard(cardBit(board.cards[0]) | cardBit(board.cards[1]) | cardBit(board.cards[2]));
+        row.texture = 0;
+        std::memcpy(&row.texture, &texture, sizeof(texture));
+    }
+
+    int raises = 0;
+    std::optional<Position> aggressor;      // Last preflop raiser
+    std::optional<Street> folded;
+    bool flopBet = false;
+    bool cbetOpen = false;      // Someone else's c-bet that hero hasn't answered and nobody has raised
+    for (const ActionRecord& action : actions) {
+        const bool mine = action.position() == hero;
+        const Street street = action.street();
+        if (mine && street <= Street::River) {
+            row.actions |= (1u << static_cast<int>(action.action())) << (8 * static_cast<int>(street));
+        }
+        if (street == Street::Preflop) {
+            if (mine && (action.action() == Action::Call || action.aggressive())) row.flags |= Vpip;
+            if (action.aggressive()) {
+                if (mine) row.flags |= raises == 1 ? Pfr | ThreeBet : Pfr;
+                ++raises;
+                aggressor = action.position();
+            }
+        } else if (street == Street::Flop) {
+            if (mine && cbetOpen) {
+                row.flags |= action.action() == Action::Fold ? FacedCBet | FoldedToCBet : FacedCBet;
+                cbetOpen = false;
+            }
+            if (!flopBet) {
+                if (mine && aggressor == hero) row.flags |= action.aggressive() ? CBetChance | CBet : CBetChance;
+                if (action.aggressive()) {
+                    flopBet = true;
+                    cbetOpen = !mine && aggressor == action.position();
+                }
+            } else if (action.aggressive()) {
+                cbetOpen = false;
+            }
+        }
+        if (mine && action.action() == Action::Fold && !folded) folded = street;
+    }
+
+    if (aggressor == hero) row.flags |= Aggressor;
+    if (board.count >= 3 && folded != Street::Preflop) row.flags |= SawFlop;
+    if (showdown && !folded) row.flags |= WentToShowdown;
+    if (profit > 0) row.flags |= Won;
+    row.street = folded ? *folded : showdown ? Street::Showdown : streetOf(board);
+
+    double thousandths = std::round(static_cast<double>(profit) * 1000.0 / static_cast<double>(bb));
+    row.profit = static_cast<int32_t>(std::clamp<double>(thousandths, std::numeric_limits<int32_t>::min(),
+                                                         std::numeric_limits<int32_t>::max()));
+    return row;
+}
+
+std::optional<HandQuery> HandDb::parseQuery(std::string_view where, std::string_view by, std::string& error) {
+    HandQuery query;
+    while (!where.empty()) {
+        size_t end = 0;
+        while (end < where.size() && !std::isspace(static_cast<unsigned char>(where[end]))) ++end;
+        std::string_view token = where.substr(0, end);
+        where.remove_prefix(end);
+        while (!where.empty() && std::isspace(static_cast<unsigned char>(where.front()))) where.remove_prefix(1);
+        if (token.empty()) continue;
+
+        const bool negate = token.front() == '!';
+        if (negate) token.remove_prefix(1);
+
+        // A flag, or an action on a street: a bit that's set, or with '!' clear
+        HandFilter filter;
+        if (std::optional<uint16_t> flag = parseFlag(token)) {
+            filter.column = HandColumn::Flags;
+            filter.mask = *flag;
+            filter.lo = filter.hi = negate ? 0 : *flag;
+            query.filters.push_back(std::move(filter));
+            continue;
+        }
+        if (size_t colon = token.find(':'); colon != std::string_view::npos) {
+            std::optional<Street> street = parseStreet(token.substr(0, colon));
+            std::optional<Action> action = parseAction(token.substr(colon + 1));
+            if (!street || *street == Street::Showdown || !action) {
+                error = std::format("'{}' isn't street:action, e.g. flop:raise", token);
+                return std::nullopt;
+            }
+            uint64_t bit = uint64_t{1} << (static_cast<int>(*action) + 8 * static_cast<int>(*street));
+            filter.column = HandColumn::Actions;
+            filter.mask = bit;
+            filter.lo = filter.hi = negate ? 0 : static_cast<int64_t>(bit);
+            query.filters.push_back(std::move(filter));
+            continue;
+        }
+        if (negate) {
+            error = std::format("'!' only goes before a flag or street:action, not '{}'", token);
+            return std::nullopt;
+        }
+
+        size_t op = token.find_first_of("<>=");
+        if (op == std::string_view::npos) {
+            error = std::format("unknown condition '{}'", token);
+            return std::nullopt;
+        }
+        std::string_view field = token.substr(0, op);
+        const char relation = token[op];
+        size_t valueAt = op + 1;
+        if (relation != '=') {
+            if (valueAt >= token.size() || token[valueAt] != '=') {
+                error = std::format("'{}': use =, >= or <=", token);
+                return std::nullopt;
+            }
+            ++valueAt;
+        }
+        std::string_view value = token.substr(valueAt);
+
+        // Everything else is a span of values [first, last] on one column,
+        // widened to the top or bottom of `limit` by >= or <=
+        int first = 0, last = 0, limit = 0;
+        if (field == "position") {
+            std::optional<Position> pos = GameSession::positionFromString(value);
+            if (!pos) {
+                error = std::format("unknown position '{}'", value);
+                return std::nullopt;
+            }
+            filter.column = HandColumn::Position;
+            first = last = static_cast<int>(*pos);
+            limit = static_cast<int>(Position::BB);
+        } else if (field == "street") {
+            std::optional<Street> street = parseStreet(value);
+            if (!street) {
+                error = std::format("unknown street '{}'", value);
+                return std::nullopt;
+            }
+            filter.column = HandColumn::Street;
+            first = last = static_cast<int>(*street);
+            limit = static_cast<int>(Street::Showdown);
+        } else if (field == "texture") {
+            std::optional<std::pair<int, int>> classes = parseTexture(value);
+            if (!classes) {
+                error = std::format("unknown texture '{}'", value);
+                return std::nullopt;
+            }
+            filter.column = HandColumn::Texture;
+            filter.mask = 0xFF;     // TextureClass is BoardTexture's first byte
+            std::tie(first, last) = *classes;
+            limit = static_cast<int>(TextureClass::Monotone);
+        } else if (field == "class") {
+            if (relation != '=') {
+                error = "class takes = and a range";
+                return std::nullopt;
+            }
+            std::optional<ClassWeights> weights = parseRange(value, error);
+            if (!weights) return std::nullopt;
+            filter.column = HandColumn::HandClass;
+            filter.values.assign(256, 0);
+            for (int cls = 0; cls < kNumHandClasses; ++cls) filter.values[cls] = (*weights)[cls] > 0.0f;
+            query.filters.push_back(std::move(filter));
+            continue;
+        } else {
+            error = std::format("unknown field '{}'", field);
+            return std::nullopt;
+        }
+        filter.lo = relation == '<' ? 0 : first;
+        filter.hi = relation == '>' ? limit : last;
+        query.filters.push_back(std::move(filter));
+    }
+
+    if (!by.empty()) {
+        query.groupBy = parseGroup(by);
+        if (!query.groupBy) {
+            error = std::format("can't group by '{}': use position, class, street or texture", by);
+            return std::nullopt;
+        }
+    }
+    return query;
+}
+
+std::string HandDb::groupName(HandColumn column, int key) {
+    switch (column) {
+        case HandColumn::Position:
+            if (key <= static_cast<int>(Position::BB)) return GameSession::positionToString(static_cast<Position>(key));
+            break;
+        case HandColumn::HandClass:
+            if (key < kNumHandClasses) return handClassName(key);
+            break;
+        case HandColumn::Street:
+            if (key <= static_cast<int>(Street::Showdown)) return GameSession::streetToString(static_cast<Street>(key));
+            break;
+        case HandColumn::Texture:
+            if (key < static_cast<int>(kTextureNames.size())) return std::string(kTextureNames[key]);
+            if (key == 0xFF) return "no flop";
+            break;
+        default:
+            break;
+    }
+    return std::to_string(key);
+}
+
+} // namespace sharkwave
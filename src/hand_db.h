@@ -0,0 +1,157 @@
+#pragma once
+
+#include "card.h"
+#include "game_session.h"
+#include "mapped_file.h"
+#include "stats.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sharkwave {
+
+class ThreadPool;
+struct HandRecord;
+
+// The columns of a HandDb, one file each, every cell a fixed width
+enum class HandColumn : uint8_t {
+    Position,       // 1 byte: hero's Position
+    HandClass,      // 1 byte: see handClass()
+    Hole,           // 2 bytes: cardIndex() of each hole card, the first in the low byte
+    Board,          // 8 bytes: CardMask of the board
+    Street,         // 1 byte: where hero folded, else the last street dealt, or Showdown
+    Actions,        // 4 bytes: a byte per street from preflop up, bit 1 << Action for each action hero took
+    Flags,          // 2 bytes: HandRow::Flags
+    Texture,        // 8 bytes: the flop's BoardTexture, all ones if there was no flop
+    Profit          // 4 bytes, signed: hero's net in thousandths of a big blind
+};
+
+constexpr int kNumHandColumns = 9;
+
+// One hand from hero's seat: a row of the database
+struct HandRow {
+    // What hero did, a bit each in the Flags column
+    enum Flags : uint16_t {
+        Vpip = 1 << 0,          // Called, bet or raised preflop
+        Pfr = 1 << 1,           // Raised preflop
+        ThreeBet = 1 << 2,      // Re-raised a single preflop raise
+        Aggressor = 1 << 3,     // Made the last preflop raise
+        SawFlop = 1 << 4,
+        CBetChance = 1 << 5,    // The preflop aggressor, and nobody had bet the flop when hero acted
+        CBet = 1 << 6,          // ... and bet
+        FacedCBet = 1 << 7,     // Someone else c-bet and hero had to answer it
+        FoldedToCBet = 1 << 8,
+        WentToShowdown = 1 << 9,
+        Won = 1 << 10           // Finished ahead
+    };
+
+    Position position = Position::BTN;
+    uint8_t handClass = 0;
+    uint16_t hole = 0;
+    CardMask board = 0;
+    Street street = Street::Preflop;
+    uint32_t actions = 0;
+    uint16_t flags = 0;
+    uint64_t texture = ~uint64_t{0};
+    int32_t profit = 0;
+};
+
+// Rows pass a filter when (cell & mask) is within [lo, hi], or, with
+// `values` set, when values[(cell & mask) & 0xFF] is non-zero. Bounds are
+// signed for the Profit column; for the rest a negative hi is no bound.
+struct HandFilter {
+    HandColumn column = HandColumn::Flags;
+    uint64_t mask = ~uint64_t{0};
+    int64_t lo = 0;
+    int64_t hi = -1;
+    std::vector<uint8_t> values;    // Empty, or 256 entries
+};
+
+struct HandQuery {
+    std::vector<HandFilter> filters;            // All must pass
+    std::optional<HandColumn> groupBy;          // Groups rows by the low byte of a column
+};
+
+// Hands and profit (in thousandths of a big blind) of one group
+struct HandGroup {
+    uint64_t hands = 0;
+    int64_t profit = 0;
+    double profitSquares = 0.0;
+
+    void merge(const HandGroup& other) {
+        hands += other.hands;
+        profit += other.profit;
+        profitSquares += other.profitSquares;
+    }
+
+    // Per-hand profit in big blinds per 100 hands, so mean() is BB/100
+    RunningStats bbPer100() const;
+};
+
+struct HandQueryResult {
+    std::array<HandGroup, 256> groups{};    // By group key; everything in group 0 without groupBy
+    HandGroup total;
+    size_t scanned = 0;
+    double seconds = 0.0;
+};
+
+// An append-only database of hands, stored a column per file so a query
+// reads only the columns it filters and groups on. Readers map the files;
+// a query cuts the rows into blocks, runs each filter over a block as one
+// flat loop over its column (which the compiler turns into SIMD compares),
+// then sums the profit of the rows that passed, blocks spread over the
+// pool. A directory holds the column files and hands.meta, whose row count
+// is the only thing an append commits.
+class HandDb {
+public:
+    // Adds `rows` to the database in `dir`, created if it doesn't exist.
+    // The columns grow first and then the new row count replaces
+    // hands.meta (tmp + rename), so an append that dies part way leaves the
+    // database as it was; the next one trims the columns back to the count.
+    static bool append(const std::string& dir, std::span<const HandRow> rows, std::string& error);
+
+    // Maps the database in `dir` as of its last complete append
+    static std::optional<HandDb> open(const std::string& dir, std::string& error);
+
+    size_t size() const { return rows_; }
+
+    HandQueryResult query(const HandQuery& query, ThreadPool* pool = nullptr) const;
+
+    // Hero's row for an imported hand; std::nullopt if hero or hero's cards
+    // aren't known
+    static std::optional<HandRow> row(const HandRecord& hand, std::span<const ActionRecord> actions);
+
+    // Hero's row for any finished hand, from every action in it. `profit`
+    // is in chips, as is `bb`.
+    static HandRow row(Position hero, Card first, Card second, const CardSet& board,
+                       std::span<const ActionRecord> actions, bool showdown, int64_t profit, int64_t bb);
+
+    // A query from space-separated conditions, each of
+    //   vpip, pfr, 3bet, aggressor, saw-flop, cbet-chance, cbet,
+    //   faced-cbet, fold-to-cbet, showdown, won     a flag; "!cbet" for its absence
+    //   flop:raise                    hero took an action on a street; "!" works here too
+    //   position=BTN                  or >=, <=, in Position order (UTG .. BB)
+    //   street>=flop                  the street reached
+    //   texture=two-tone              dry-high, dry-low, paired, two-tone, connected,
+    //                                 dynamic, monotone, or dry, wet and very-wet for
+    //                                 BoardTexture::wetness()
+    //   class=22+,A2s+                hand classes in range notation (see parseRange())
+    // grouped by `by`: position, class, street, texture or "" for one
+    // group. On bad input, std::nullopt and the reason in `error`.
+    static std::optional<HandQuery> parseQuery(std::string_view where, std::string_view by, std::string& error);
+
+    // How a group key of `column` reads: "BTN", "AKs", "FLOP", "two-tone"
+    static std::string groupName(HandColumn column, int key);
+
+private:
+    HandDb() = default;
+
+    std::array<MappedFile, kNumHandColumns> files_;
+    size_t rows_ = 0;
+};
+
+} // namespace sharkwave
@@ -1,6 +1,9 @@
 #include "hand_evaluator.h"
+#include "profiler.h"
 #include <algorithm>
 #include <array>
+#include <bit>
+#include <cmath>
 #include <format>
 #include <random>
 
@@ -12,227 +15,185 @@ namespace {
         return static_cast<int>(r);
     }
 
-    // Count occurrences of each rank
-    std::array<int, 15> countRanks(const Card* cards, size_t count) {
-        std::array<int, 15> counts{};
-        for (size_t i = 0; i < count; ++i) {
-            counts[rankValue(cards[i].rank())]++;
-        }
-        return counts;
-    }
+    constexpr uint32_t kRankBits = 0x1FFF;
 
-    // Count occurrences of each suit
-    std::array<int, 4> countSuits(const Card* cards, size_t count) {
-        std::array<int, 4> counts{};
-        for (size_t i = 0; i < count; ++i) {
-            counts[static_cast<int>(cards[i].suit())]++;
-        }
-        return counts;
+    constexpr uint32_t rankBit(int r) {
+        return 1u << (r - 2);
     }
 
-    // Check for flush and return the flush suit
-    bool findFlushSuit(const Card* cards, size_t count, Suit& flushSuit) {
-        auto suitCounts = countSuits(cards, count);
-        for (int i = 0; i < 4; ++i) {
-            if (suitCounts[i] >= 5) {
-                flushSuit = static_cast<Suit>(i);
-                return true;
-            }
-        }
-        return false;
+    // Highest rank present in a non-empty 13-bit rank set
+    constexpr int topRank(uint32_t ranks) {
+        return 31 - std::countl_zero(ranks) + 2;
     }
-}
 
-HandResult HandEvaluator::evaluate(const CardSet& cards) {
-    return evaluate(cards.cards, cards.count);
-}
-
-HandResult HandEvaluator::evaluate(const Card* cards, size_t count) {
-    if (count < 5) {
-        return {HandRank::HighCard, 0};
+    // High card of the best straight in a 13-bit rank set (5 for the wheel), 0 if none
+    constexpr int straightHigh(uint32_t ranks) {
+        uint32_t ext = (ranks << 1) | (ranks >> 12); // bit k = rank k+1, ace also plays low
+        uint32_t run = ext & (ext >> 1) & (ext >> 2) & (ext >> 3) & (ext >> 4);
+        if (run == 0) return 0;
+        return 31 - std::countl_zero(run) + 5;
     }
 
-    // Check for flush
-    Suit flushSuit;
-    bool hasFlush = findFlushSuit(cards, count, flushSuit);
-
-    // Check for straight
-    uint64_t straightValue = 0;
-    bool hasStraight = isStraight(cards, count, straightValue);
-
-    // Royal flush and straight flush
-    if (hasFlush && hasStraight) {
-        // Extract flush cards
-        Card flushCards[7];
-        size_t flushCount = 0;
-        for (size_t i = 0; i < count; ++i) {
-            if (cards[i].suit() == flushSuit) {
-                flushCards[flushCount++] = cards[i];
-            }
+    // Pack the `n` highest ranks into value, starting at `shift` and stepping down
+    constexpr uint64_t packRanks(uint32_t ranks, int n, int shift, int step) {
+        uint64_t value = 0;
+        for (; n > 0 && ranks != 0; --n) {
+            int r = topRank(ranks);
+            value |= static_cast<uint64_t>(r) << shift;
+            ranks &= ~rankBit(r);
+            shift -= step;
         }
-        uint64_t sfValue = 0;
-        if (isStraight(flushCards, flushCount, sfValue)) {
-            if (sfValue >= static_cast<uint64_t>(Rank::Ten) << 48) {
-                return {HandRank::RoyalFlush, sfValue};
+        return value;
+    }
+
+    // Preflop equity vs one random hand, as the usual 13x13 grid with aces
+    // first: suited hands above the diagonal, offsuit below. Generated offline
+    // with 400k Monte Carlo runouts per class (standard error < 0.1%).
+    constexpr float kPreflopEquity[13][13] = {
+        {0.851, 0.670, 0.662, 0.653, 0.645, 0.628, 0.620, 0.611, 0.599, 0.601, 0.591, 0.582, 0.574},   // A
+        {0.654, 0.823, 0.634, 0.626, 0.618, 0.599, 0.583, 0.576, 0.567, 0.558, 0.550, 0.540, 0.532},   // K
+        {0.645, 0.615, 0.800, 0.604, 0.592, 0.577, 0.560, 0.543, 0.536, 0.528, 0.519, 0.511, 0.502},   // Q
+        {0.634, 0.606, 0.581, 0.775, 0.573, 0.556, 0.539, 0.523, 0.506, 0.500, 0.491, 0.482, 0.474},   // J
+        {0.627, 0.597, 0.574, 0.553, 0.750, 0.540, 0.523, 0.507, 0.489, 0.472, 0.465, 0.457, 0.449},   // T
+        {0.608, 0.579, 0.553, 0.532, 0.514, 0.721, 0.510, 0.491, 0.474, 0.458, 0.438, 0.433, 0.424},   // 9
+        {0.599, 0.560, 0.536, 0.515, 0.496, 0.480, 0.692, 0.480, 0.462, 0.445, 0.427, 0.409, 0.402},   // 8
+        {0.587, 0.553, 0.519, 0.497, 0.479, 0.463, 0.450, 0.664, 0.454, 0.436, 0.419, 0.402, 0.381},   // 7
+        {0.578, 0.542, 0.510, 0.479, 0.460, 0.445, 0.432, 0.423, 0.633, 0.431, 0.413, 0.396, 0.377},   // 6
+        {0.577, 0.533, 0.502, 0.471, 0.444, 0.427, 0.414, 0.405, 0.400, 0.604, 0.415, 0.396, 0.378},   // 5
+        {0.567, 0.524, 0.492, 0.462, 0.436, 0.408, 0.394, 0.386, 0.381, 0.381, 0.571, 0.387, 0.368},   // 4
+        {0.558, 0.515, 0.482, 0.451, 0.426, 0.400, 0.375, 0.367, 0.361, 0.360, 0.352, 0.537, 0.360},   // 3
+        {0.549, 0.504, 0.473, 0.442, 0.416, 0.392, 0.368, 0.347, 0.341, 0.343, 0.331, 0.323, 0.503},   // 2
+    };
+
+    // Best hand from per-suit rank sets (at least 5 cards in total)
+    constexpr HandResult evaluateSuits(uint32_t c, uint32_t d, uint32_t h, uint32_t s) {
+        uint32_t all = c | d | h | s;
+        uint32_t twoPlus = (c & d) | (c & h) | (c & s) | (d & h) | (d & s) | (h & s);
+        uint32_t threePlus = (c & d & h) | (c & d & s) | (c & h & s) | (d & h & s);
+        uint32_t four = c & d & h & s;
+
+        uint32_t flushRanks = 0;
+        for (uint32_t suitRanks : {c, d, h, s}) {
+            if (std::popcount(suitRanks) >= 5) {
+                flushRanks = suitRanks;
+                break;
             }
-            return {HandRank::StraightFlush, sfValue};
         }
-    }
 
-    // Four of a kind
-    auto rankCounts = countRanks(cards, count);
-    for (int r = 14; r >= 2; --r) {
-        if (rankCounts[r] == 4) {
-            uint64_t value = static_cast<uint64_t>(r) << 48;
-            // Find kicker
-            for (int k = 14; k >= 2; --k) {
-                if (k != r && rankCounts[k] > 0) {
-                    value |= static_cast<uint64_t>(k) << 32;
-                    break;
-                }
+        // Royal flush and straight flush
+        if (flushRanks != 0) {
+            if (int high = straightHigh(flushRanks)) {
+                HandRank rank = (high == 14) ? HandRank::RoyalFlush : HandRank::StraightFlush;
+                return {rank, static_cast<uint64_t>(high) << 48};
             }
-            return {HandRank::FourOfAKind, value};
         }
-    }
 
-    // Full house
-    int threeRank = 0, pairRank = 0;
-    for (int r = 14; r >= 2; --r) {
-        if (rankCounts[r] >= 3 && threeRank == 0) {
-            threeRank = r;
-        } else if (rankCounts[r] >= 2 && pairRank == 0) {
-            pairRank = r;
+        // Four of a kind
+        if (four != 0) {
+            int r = topRank(four);
+            return {HandRank::FourOfAKind,
+                    (static_cast<uint64_t>(r) << 48) | packRanks(all & ~rankBit(r), 1, 32, 0)};
         }
-    }
-    if (threeRank > 0) {
-        // Check for two pair to upgrade
-        for (int r = 14; r >= 2; --r) {
-            if (r != threeRank && rankCounts[r] >= 3) {
-                pairRank = r; // Use lower three of a kind as pair
-                break;
-            }
-        }
-        if (pairRank > 0 || rankCounts[threeRank] >= 2) {
-            uint64_t value = static_cast<uint64_t>(threeRank) << 48;
-            value |= static_cast<uint64_t>(pairRank > 0 ? pairRank : threeRank) << 32;
-            return {HandRank::FullHouse, value};
-        }
-    }
 
-    // Flush
-    if (hasFlush) {
-        uint64_t value = 0;
-        int shift = 48;
-        for (int r = 14; r >= 2 && shift >= 0; --r) {
-            for (size_t i = 0; i < count && shift >= 0; ++i) {
-                if (cards[i].suit() == flushSuit && rankValue(cards[i].rank()) == r) {
-                    value |= static_cast<uint64_t>(r) << shift;
-                    shift -= 4;
-                    break;
-                }
+        // Full house (second trips count as the pair)
+        if (threePlus != 0) {
+            int trips = topRank(threePlus);
+            uint32_t pairs = twoPlus & ~rankBit(trips);
+            if (pairs != 0) {
+                return {HandRank::FullHouse,
+                        (static_cast<uint64_t>(trips) << 48) | (static_cast<uint64_t>(topRank(pairs)) << 32)};
             }
         }
-        return {HandRank::Flush, value};
-    }
 
-    // Straight
-    if (hasStraight) {
-        return {HandRank::Straight, straightValue};
-    }
-
-    // Three of a kind
-    for (int r = 14; r >= 2; --r) {
-        if (rankCounts[r] == 3) {
-            uint64_t value = static_cast<uint64_t>(r) << 48;
-            int kickers = 0;
-            for (int k = 14; k >= 2 && kickers < 2; --k) {
-                if (k != r && rankCounts[k] > 0) {
-                    value |= static_cast<uint64_t>(k) << (32 - kickers * 16);
-                    kickers++;
-                }
-            }
-            return {HandRank::ThreeOfAKind, value};
+        // Flush: top five flush cards
+        if (flushRanks != 0) {
+            return {HandRank::Flush, packRanks(flushRanks, 5, 48, 4)};
         }
-    }
 
-    // Two pair
-    int pairs[2] = {0, 0};
-    int pairIdx = 0;
-    for (int r = 14; r >= 2 && pairIdx < 2; --r) {
-        if (rankCounts[r] == 2) {
-            pairs[pairIdx++] = r;
+        // Straight
+        if (int high = straightHigh(all)) {
+            return {HandRank::Straight, static_cast<uint64_t>(high) << 48};
         }
-    }
-    if (pairIdx >= 2) {
-        uint64_t value = static_cast<uint64_t>(pairs[0]) << 48;
-        value |= static_cast<uint64_t>(pairs[1]) << 32;
-        // Find kicker
-        for (int k = 14; k >= 2; --k) {
-            if (k != pairs[0] && k != pairs[1] && rankCounts[k] > 0) {
-                value |= static_cast<uint64_t>(k) << 16;
-                break;
-            }
+
+        // Three of a kind
+        if (threePlus != 0) {
+            int trips = topRank(threePlus);
+            return {HandRank::ThreeOfAKind,
+                    (static_cast<uint64_t>(trips) << 48) | packRanks(all & ~rankBit(trips), 2, 32, 16)};
         }
-        return {HandRank::TwoPair, value};
-    }
-
-    // One pair
-    for (int r = 14; r >= 2; --r) {
-        if (rankCounts[r] == 2) {
-            uint64_t value = static_cast<uint64_t>(r) << 48;
-            int kickers = 0;
-            for (int k = 14; k >= 2 && kickers < 3; --k) {
-                if (k != r && rankCounts[k] > 0) {
-                    value |= static_cast<uint64_t>(k) << (32 - kickers * 12);
-                    kickers++;
-                }
-            }
-            return {HandRank::OnePair, value};
+
+        // Two pair (a third pair can still play as the kicker)
+        if (std::popcount(twoPlus) >= 2) {
+            int high = topRank(twoPlus);
+            int low = topRank(twoPlus & ~rankBit(high));
+            uint32_t rest = all & ~rankBit(high) & ~rankBit(low);
+            return {HandRank::TwoPair,
+                    (static_cast<uint64_t>(high) << 48) | (static_cast<uint64_t>(low) << 32) |
+                    packRanks(rest, 1, 16, 0)};
         }
-    }
 
-    // High card
-    uint64_t value = 0;
-    int kickers = 0;
-    for (int r = 14; r >= 2 && kickers < 5; --r) {
-        if (rankCounts[r] > 0) {
-            value |= static_cast<uint64_t>(r) << (48 - kickers * 12);
-            kickers++;
+        // One pair
+        if (twoPlus != 0) {
+            int r = topRank(twoPlus);
+            return {HandRank::OnePair,
+                    (static_cast<uint64_t>(r) << 48) | packRanks(all & ~rankBit(r), 3, 32, 12)};
         }
+
+        // High card: five kickers 10 bits apart, the last at bit 8 where
+        // HandResult::key() still sees it
+        return {HandRank::HighCard, packRanks(all, 5, 48, 10)};
     }
-    return {HandRank::HighCard, value};
+
+    // Ace-king-queen-jack with a nine or an eight (and a deuce and trey that
+    // don't play): only the fifth kicker differs, and key() has to see it
+    static_assert(evaluateSuits(rankBit(14) | rankBit(13) | rankBit(12), rankBit(11) | rankBit(8), rankBit(3), rankBit(2)).key() <
+                  evaluateSuits(rankBit(14) | rankBit(13) | rankBit(12), rankBit(11) | rankBit(9), rankBit(3), rankBit(2)).key());
 }
 
-bool HandEvaluator::isStraight(const Card* cards, size_t count, uint64_t& straightValue) {
-    // Collect unique ranks
-    std::array<bool, 15> hasRank{};
-    for (size_t i = 0; i < count; ++i) {
-        hasRank[rankValue(cards[i].rank())] = true;
+HandResult HandEvaluator::evaluate(const CardSet& cards) {
+    return evaluate(cards.cards, cards.count);
+}
+
+HandResult HandEvaluator::evaluate(const Card* cards, size_t count) {
+    SHARKWAVE_PROFILE_SCOPE(Evaluate);
+    if (count < 5) {
+        return {HandRank::HighCard, 0};
     }
 
-    // Check for A-2-3-4-5 straight (wheel)
-    if (hasRank[14]) hasRank[1] = true; // Ace can be low
+    uint32_t suits[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < count; ++i) {
+        suits[static_cast<int>(cards[i].suit())] |= rankBit(rankValue(cards[i].rank()));
+    }
+    return evaluateSuits(suits[0], suits[1], suits[2], suits[3]);
+}
 
-    // Find highest straight
-    for (int start = 14; start >= 5; --start) {
-        bool straight = true;
-        for (int i = 0; i < 5; ++i) {
-            if (!hasRank[start - i]) {
-                straight = false;
-                break;
-            }
-        }
-        if (straight) {
-            // Return value with high card at bit 48
-            straightValue = static_cast<uint64_t>(start == 1 ? 5 : start) << 48;
-            return true;
-        }
+HandResult HandEvaluator::evaluate(CardMask cards) {
+    SHARKWAVE_PROFILE_SCOPE(Evaluate);
+    if (std::popcount(cards) < 5) {
+        return {HandRank::HighCard, 0};
     }
-    return false;
+    return evaluateSuits(static_cast<uint32_t>(cards) & kRankBits,
+                         static_cast<uint32_t>(cards >> 13) & kRankBits,
+                         static_cast<uint32_t>(cards >> 26) & kRankBits,
+                         static_cast<uint32_t>(cards >> 39) & kRankBits);
 }
 
-bool HandEvaluator::isFlush(const Card* cards, size_t count, Suit& flushSuit) {
-    return findFlushSuit(cards, count, flushSuit);
+void HandEvaluator::evaluateShowdown(CardMask board, const CardMask* holeCards, size_t count,
+                                     HandResult* results) {
+    SHARKWAVE_PROFILE_SCOPE(Evaluate);
+    // Split the shared board once; each player only ORs in their own cards
+    uint32_t boardSuits[4];
+    for (int s = 0; s < 4; ++s) {
+        boardSuits[s] = static_cast<uint32_t>(board >> (13 * s)) & kRankBits;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        CardMask hole = holeCards[i];
+        results[i] = evaluateSuits(boardSuits[0] | (static_cast<uint32_t>(hole) & kRankBits),
+                                   boardSuits[1] | (static_cast<uint32_t>(hole >> 13) & kRankBits),
+                                   boardSuits[2] | (static_cast<uint32_t>(hole >> 26) & kRankBits),
+                                   boardSuits[3] | (static_cast<uint32_t>(hole >> 39) & kRankBits));
+    }
 }
 
 std::string HandEvaluator::rankToString(HandRank rank) {
@@ -252,15 +213,15 @@ std::string HandEvaluator::rankToString(HandRank rank) {
 }
 
 bool HandEvaluator::hasFlushDraw(const CardSet& holeCards, const CardSet& board) {
-    if (board.count < 3) return false;
+    return hasFlushDraw(holeCards.mask(), board.mask());
+}
 
-    CardSet combined;
-    for (size_t i = 0; i < holeCards.count; ++i) combined.add(holeCards.cards[i]);
-    for (size_t i = 0; i < board.count; ++i) combined.add(board.cards[i]);
+bool HandEvaluator::hasFlushDraw(CardMask holeCards, CardMask board) {
+    if (std::popcount(board) < 3) return false;
 
-    auto suitCounts = countSuits(combined.cards, combined.count);
-    for (int i = 0; i < 4; ++i) {
-        if (suitCounts[i] == 4) return true; // One more card needed
+    CardMask combined = holeCards | board;
+    for (int s = 0; s < 4; ++s) {
+        if (std::popcount(combined >> (13 * s) & kRankBits) == 4) return true; // One more card needed
     }
     return false;
 }
@@ -327,74 +288,46 @@ bool HandEvaluator::hasGutshotStraightDraw(const CardSet& holeCards, const CardS
 }
 
 int HandEvaluator::countOuts(const CardSet& holeCards, const CardSet& board) {
-    CardSet combined;
-    for (size_t i = 0; i < holeCards.count; ++i) combined.add(holeCards.cards[i]);
-    for (size_t i = 0; i < board.count; ++i) combined.add(board.cards[i]);
+    return countOuts(holeCards.mask(), board.mask());
+}
 
-    if (combined.count < 4) return 0;
+int HandEvaluator::countOuts(CardMask holeCards, CardMask board) {
+    CardMask combined = holeCards | board;
+    if (std::popcount(combined) < 4) return 0;
 
     // Get current hand strength
     HandResult currentHand = evaluate(combined);
 
     // Count cards that improve hand
     int outs = 0;
-    std::array<bool, 15> hasRank{};
-    std::array<bool, 4> hasSuitWithRank[15]{};
-    std::array<bool, 52> hasCard{};
-
-    // Build card presence map
-    for (size_t i = 0; i < combined.count; ++i) {
-        Rank r = combined.cards[i].rank();
-        Suit s = combined.cards[i].suit();
-        hasRank[rankValue(r)] = true;
-        hasSuitWithRank[rankValue(r)][static_cast<int>(s)] = true;
-        int cardIdx = (rankValue(r) - 2) * 4 + static_cast<int>(s);
-        hasCard[cardIdx] = true;
+    uint32_t suits[4];
+    uint32_t ranks = 0;
+    for (int s = 0; s < 4; ++s) {
+        suits[s] = static_cast<uint32_t>(combined >> (13 * s)) & kRankBits;
+        ranks |= suits[s];
     }
 
-    // Check flush draw outs
-    for (int s = 0; s < 4; ++s) {
-        int suitCount = 0;
-        for (size_t i = 0; i < combined.count; ++i) {
-            if (static_cast<int>(combined.cards[i].suit()) == s) suitCount++;
-        }
-        if (suitCount == 4) {
-            // 9 outs for flush (13 - 4 = 9)
-            for (int r = 2; r <= 14; ++r) {
-                if (!hasSuitWithRank[r][s]) outs++;
-            }
+    // Check flush draw outs: 9 outs for flush (13 - 4 = 9)
+    for (uint32_t suit : suits) {
+        if (std::popcount(suit) == 4) {
+            outs += 13 - 4;
             break;
         }
     }
 
-    // Check straight draw outs
-    std::array<bool, 15> rankHas = hasRank;
-    if (rankHas[14]) rankHas[1] = true; // Ace low
-
-    // Open-ended: 8 outs
+    // Check straight draw outs: two per 5-rank window holding three ranks
+    // (gutshot: 4 outs each). Bit r of lowAce is rank value r, ace also at 1.
+    uint32_t lowAce = (ranks << 2) | ((ranks >> 12) & 1u) << 1;
     for (int start = 10; start >= 1; --start) {
-        int count = 0;
-        int missing[2] = {0, 0};
-        int missingIdx = 0;
-        for (int i = 0; i < 5; ++i) {
-            if (rankHas[start + i]) count++;
-            else if (missingIdx < 2) missing[missingIdx++] = start + i;
-        }
-        if (count == 3 && missingIdx == 2) {
-            // Gutshot: 4 outs
-            for (int m : missing) {
-                int r = (m == 1) ? 14 : m;
-                if (!hasRank[r]) outs++;
-            }
-        }
+        if (std::popcount((lowAce >> start) & 0x1Fu) == 3) outs += 2;
     }
 
     // Overcard outs (simplified)
-    HandResult boardOnly = evaluate(board.cards, board.count);
+    HandResult boardOnly = evaluate(board);
     if (currentHand.rank <= HandRank::OnePair) {
         int boardTopRank = static_cast<int>(boardOnly.value >> 48);
         for (int r = 14; r >= 11; --r) {
-            if (!hasRank[r] && r > boardTopRank) {
+            if (!(ranks & rankBit(r)) && r > boardTopRank) {
                 outs++; // Pair outs
             }
         }
@@ -404,64 +337,188 @@ int HandEvaluator::countOuts(const CardSet& holeCards, const CardSet& board) {
     return std::min(outs, 25);
 }
 
+double HandEvaluator::preflopEquity(Card c1, Card c2) {
+    int r1 = 14 - rankValue(c1.rank());    // Grid row/column, aces first
+    int r2 = 14 - rankValue(c2.rank());
+    bool suited = c1.suit() == c2.suit();
+    // Suited: higher rank picks the row; offsuit: lower rank does
+    int row = suited ? std::min(r1, r2) : std::max(r1, r2);
+    int col = suited ? std::max(r1, r2) : std::min(r1, r2);
+    return kPreflopEquity[row][col];
+}
+
 double HandEvaluator::calculateEquity(const CardSet& holeCards, const CardSet& board, int iterations) {
-    std::mt19937 rng(std::random_device{}());
-    int wins = 0;
-    int ties = 0;
-
-    // Create deck excluding known cards
-    std::array<Card, 52> deckArr;
-    size_t deckSize = 0;
-    for (Suit s : allSuits) {
-        for (Rank r : allRanks) {
-            Card c(r, s);
-            bool used = false;
-            for (size_t i = 0; i < holeCards.count; ++i) {
-                if (holeCards.cards[i] == c) { used = true; break; }
-            }
-            for (size_t i = 0; i < board.count; ++i) {
-                if (board.cards[i] == c) { used = true; break; }
+    thread_local Rng rng(std::random_device{}());
+    return calculateEquity(holeCards.mask(), board.mask(), iterations, rng);
+}
+
+double HandEvaluator::calculateEquity(CardMask holeCards, CardMask board, int iterations, Rng& rng) {
+    if (iterations <= 0) return 0.5;
+
+    EquitySampler sampler(holeCards, board);
+    sampler.sample(iterations, rng);
+    return sampler.equity();
+}
+
+EquitySampler::EquitySampler(CardMask holeCards, CardMask board)
+    : holeCards_(holeCards)
+    , board_(board)
+    , liveCount_(0)
+    , boardNeeded_(5 - std::popcount(board))
+    , heroFixed_{}
+    , exact_(false)
+    , exactEquity_(0.0)
+    , samples_(0)
+    , wins_(0)
+    , ties_(0)
+    , cdfCount_(0)
+{
+    // Preflop the table is both free and more precise than any sample we'd draw
+    if (board == 0 && std::popcount(holeCards) == 2) {
+        int low = std::countr_zero(holeCards);
+        int high = 63 - std::countl_zero(holeCards);
+        exact_ = true;
+        exactEquity_ = HandEvaluator::preflopEquity(cardFromIndex(low), cardFromIndex(high));
+        return;
+    }
+
+    const CardMask dead = holeCards | board;
+    for (int i = 0; i < 52; ++i) {
+        if (!(dead & (CardMask{1} << i))) {
+            livePos_[i] = static_cast<uint8_t>(liveCount_);
+            live_[liveCount_++] = static_cast<uint8_t>(i);
+        }
+    }
+
+    // On the river hero's hand never changes
+    if (boardNeeded_ == 0) heroFixed_ = HandEvaluator::evaluate(holeCards | board);
+}
+
+EquitySampler::EquitySampler(CardMask holeCards, CardMask board, const Range& villain)
+    : EquitySampler(holeCards, board)
+{
+    const auto& masks = comboMasks();
+    const CardMask dead = holeCards | board;
+    float total = 0.0f;
+    for (int i = 0; i < kNumCombos; ++i) {
+        if (villain[i] > 0.0f && !(masks[i] & dead)) {
+            total += villain[i];
+            cdf_[cdfCount_] = total;
+            cdfCombo_[cdfCount_++] = static_cast<uint16_t>(i);
+        }
+    }
+    if (cdfCount_ == 0) return;     // Nothing left in range: fall back to a random hand
+
+    // Cut the total into cdfCount_ equal slices and note, for each, how many
+    // combos end before it does: the search for a draw in that slice starts
+    // there, a step or two from its combo rather than a binary search away
+    const float perSlice = static_cast<float>(cdfCount_) / total;
+    std::fill_n(guide_.begin(), cdfCount_, uint16_t{0});
+    for (int k = 0; k < cdfCount_; ++k) {
+        guide_[std::min(static_cast<int>(cdf_[k] * perSlice), cdfCount_ - 1)]++;
+    }
+    for (int slice = 0, before = 0; slice < cdfCount_; ++slice) {
+        int ending = guide_[slice];
+        guide_[slice] = static_cast<uint16_t>(before);
+        before += ending;
+    }
+
+    // Preflop the table only knows random hands, so the range has to be sampled
+    if (exact_) {
+        exact_ = false;
+        for (int i = 0; i < 52; ++i) {
+            if (!(dead & (CardMask{1} << i))) {
+                livePos_[i] = static_cast<uint8_t>(liveCount_);
+                live_[liveCount_++] = static_cast<uint8_t>(i);
             }
-            if (!used) deckArr[deckSize++] = c;
         }
     }
+}
+
+void EquitySampler::swapLive(uint32_t a, uint32_t b) {
+    std::swap(live_[a], live_[b]);
+    livePos_[live_[a]] = static_cast<uint8_t>(a);
+    livePos_[live_[b]] = static_cast<uint8_t>(b);
+}
 
-    CardSet heroHand = holeCards;
-    (void)heroHand; // May be used in future
+void EquitySampler::sampleRange(int iterations, Rng& rng) {
+    const auto& cards = comboCards();
+    const auto& masks = comboMasks();
+    const float total = cdf_[cdfCount_ - 1];
+    const float perSlice = static_cast<float>(cdfCount_) / total;
+    const int last = cdfCount_ - 1;
 
     for (int iter = 0; iter < iterations; ++iter) {
-        // Shuffle remaining deck
-        std::shuffle(deckArr.begin(), deckArr.begin() + deckSize, rng);
-
-        // Deal remaining board cards
-        CardSet simBoard = board;
-        size_t cardsNeeded = 5 - simBoard.count;
-        for (size_t i = 0; i < cardsNeeded; ++i) {
-            simBoard.add(deckArr[i]);
+        // The first combo whose cumulative weight passes target, starting
+        // from its slice's guess; rounding can leave that a step off
+        float target = static_cast<float>(rng.uniform()) * total;
+        int k = guide_[std::min(static_cast<int>(target * perSlice), last)];
+        while (k > 0 && cdf_[k - 1] > target) --k;
+        while (k < last && cdf_[k] <= target) ++k;
+        int combo = cdfCombo_[k];
+
+        // Park villain's cards past the end of the deck so the board can't use them
+        uint32_t limit = liveCount_;
+        swapLive(livePos_[cards[combo].hi], --limit);
+        swapLive(livePos_[cards[combo].lo], --limit);
+        for (int i = 0; i < boardNeeded_; ++i) {
+            swapLive(i, i + rng.below(limit - i));
         }
 
-        // Deal villain cards
-        CardSet villainHand;
-        villainHand.add(deckArr[cardsNeeded]);
-        villainHand.add(deckArr[cardsNeeded + 1]);
+        CardMask runout = board_;
+        for (int i = 0; i < boardNeeded_; ++i) runout |= CardMask{1} << live_[i];
 
-        // Evaluate
-        CardSet heroFull;
-        for (size_t i = 0; i < heroHand.count; ++i) heroFull.add(heroHand.cards[i]);
-        for (size_t i = 0; i < simBoard.count; ++i) heroFull.add(simBoard.cards[i]);
+        HandResult heroResult = boardNeeded_ == 0 ? heroFixed_ : HandEvaluator::evaluate(holeCards_ | runout);
+        HandResult villainResult = HandEvaluator::evaluate(masks[combo] | runout);
 
-        CardSet villainFull;
-        for (size_t i = 0; i < villainHand.count; ++i) villainFull.add(villainHand.cards[i]);
-        for (size_t i = 0; i < simBoard.count; ++i) villainFull.add(simBoard.cards[i]);
+        if (heroResult > villainResult) wins_++;
+        else if (heroResult == villainResult) ties_++;
+    }
+    samples_ += iterations;
+}
 
-        HandResult heroResult = evaluate(heroFull);
-        HandResult villainResult = evaluate(villainFull);
+void EquitySampler::sample(int iterations, Rng& rng) {
+    SHARKWAVE_PROFILE_SCOPE(Equity);
+    if (exact_) return;
+    if (cdfCount_ > 0) {
+        sampleRange(iterations, rng);
+        return;
+    }
 
-        if (heroResult > villainResult) wins++;
-        else if (heroResult == villainResult) ties++;
+    // A partial Fisher-Yates draw is uniform whatever order live_ was left in
+    const int draws = boardNeeded_ + 2;
+    for (int iter = 0; iter < iterations; ++iter) {
+        for (int i = 0; i < draws; ++i) {
+            uint32_t j = i + rng.below(liveCount_ - i);
+            std::swap(live_[i], live_[j]);
+        }
+
+        CardMask runout = board_;
+        for (int i = 0; i < boardNeeded_; ++i) runout |= CardMask{1} << live_[i];
+        CardMask villain = (CardMask{1} << live_[boardNeeded_]) | (CardMask{1} << live_[boardNeeded_ + 1]);
+
+        HandResult heroResult = boardNeeded_ == 0 ? heroFixed_ : HandEvaluator::evaluate(holeCards_ | runout);
+        HandResult villainResult = HandEvaluator::evaluate(villain | runout);
+
+        if (heroResult > villainResult) wins_++;
+        else if (heroResult == villainResult) ties_++;
     }
+    samples_ += iterations;
+}
+
+double EquitySampler::equity() const {
+    if (exact_) return exactEquity_;
+    if (samples_ == 0) return 0.5;
+    return (wins_ + 0.5 * ties_) / samples_;
+}
 
-    return (wins + 0.5 * ties) / static_cast<double>(iterations);
+double EquitySampler::standardError() const {
+    if (exact_ || samples_ < 2) return 0.0;
+    // Each sample scores 1, 0.5 or 0
+    double n = static_cast<double>(samples_);
+    double mean = equity();
+    double meanSquare = (wins_ + 0.25 * ties_) / n;
+    return std::sqrt(std::max(0.0, meanSquare - mean * mean) / n);
 }
 
 std::string HandEvaluator::cardRankToString(Rank rank) {
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "card.h"
+#include "range.h"
+#include "rng.h"
+#include <array>
 #include <cstdint>
 
 namespace sharkwave {
@@ -32,6 +35,12 @@ struct HandResult {
     bool operator==(const HandResult& other) const {
         return rank == other.rank && value == other.value;
     }
+
+    // Orders hands like operator<=>, packed into the low 52 bits: the value's
+    // lowest field starts at bit 8, so nothing is lost shifting it down
+    constexpr uint64_t key() const {
+        return (static_cast<uint64_t>(rank) << 48) | (value >> 8);
+    }
 };
 
 class HandEvaluator {
@@ -39,6 +48,12 @@ public:
     // Evaluate best 5-card hand from up to 7 cards
     static HandResult evaluate(const CardSet& cards);
     static HandResult evaluate(const Card* cards, size_t count);
+    static HandResult evaluate(CardMask cards);
+
+    // Rank several players against one shared board in a single pass
+    // (board plus each player's hole cards must total at least 5 cards)
+    static void evaluateShowdown(CardMask board, const CardMask* holeCards, size_t count,
+                                 HandResult* results);
 
     // Get string representation of hand rank
     static std::string rankToString(HandRank rank);
@@ -55,14 +70,61 @@ public:
     static bool hasGutshotStraightDraw(const CardSet& holeCards, const CardSet& board);
     static int countOuts(const CardSet& holeCards, const CardSet& board);
 
+    // Same draw checks on masks, for callers that already hold them
+    static bool hasFlushDraw(CardMask holeCards, CardMask board);
+    static int countOuts(CardMask holeCards, CardMask board);
+
     // Calculate equity vs random hand (Monte Carlo)
     static double calculateEquity(const CardSet& holeCards, const CardSet& board,
                                   int iterations = 1000);
 
+    // Preflop equity vs a random hand (table lookup)
+    static double preflopEquity(Card c1, Card c2);
+
+    // Same estimate on masks, drawing from a caller-owned generator so runs
+    // are reproducible and nothing is allocated or seeded per call
+    static double calculateEquity(CardMask holeCards, CardMask board, int iterations, Rng& rng);
+};
+
+// Monte Carlo equity vs one random hand that can be refined a batch at a
+// time, so callers on a clock can stop whenever they run out of budget.
+// Preflop it answers exactly from the table and never needs sampling.
+// Given a range, villain's hand is drawn by its weights instead.
+class EquitySampler {
+public:
+    EquitySampler(CardMask holeCards, CardMask board);
+    EquitySampler(CardMask holeCards, CardMask board, const Range& villain);
+
+    void sample(int iterations, Rng& rng);
+
+    bool exact() const { return exact_; }
+    int samples() const { return samples_; }
+    double equity() const;
+    double standardError() const;   // 0 once exact
+
 private:
-    static bool isFlush(const Card* cards, size_t count, Suit& flushSuit);
-    static bool isStraight(const Card* cards, size_t count, uint64_t& straightValue);
-    static uint64_t scoreHand(const Card* cards, size_t count, HandRank& rank);
+    void sampleRange(int iterations, Rng& rng);
+    void swapLive(uint32_t a, uint32_t b);
+
+    CardMask holeCards_;
+    CardMask board_;
+    std::array<uint8_t, 52> live_;  // Cards left to deal, reshuffled in place
+    std::array<uint8_t, 52> livePos_;   // Where each card sits in live_
+    uint32_t liveCount_;
+    int boardNeeded_;
+    HandResult heroFixed_;          // Hero's hand when the board is complete
+
+    bool exact_;
+    double exactEquity_;
+    int samples_;
+    int wins_;
+    int ties_;
+
+    // Cumulative weights of the villain combos not blocked by hero or board
+    std::array<float, kNumCombos> cdf_;
+    std::array<uint16_t, kNumCombos> cdfCombo_;
+    std::array<uint16_t, kNumCombos> guide_;    // Where each slice of the cdf starts its search
+    int cdfCount_;
 };
 
 } // namespace sharkwave
@@ -0,0 +1,422 @@
+#include "hand_history.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+namespace sharkwave {
+
+namespace {
+    // Parsed as one task; big enough that splitting is noise, small enough
+    // that a single file still spreads over every worker
+    constexpr size_t kPieceBytes = size_t{1} << 20;
+
+    constexpr size_t kMaxSeats = 10;
+
+    constexpr std::string_view kHandStart = "PokerStars ";
+    constexpr std::string_view kHandBoundary = "\nPokerStars ";
+    constexpr std::string_view kNoLimitHoldem = "Hold'em No Limit";
+    constexpr std::string_view kByteOrderMark = "\xEF\xBB\xBF";
+
+    // Up to the last eight bytes of a name as a word
+    uint64_t nameTail(const char* end, size_t length) {
+        uint64_t word = 0;
+        size_t n = std::min<size_t>(length, 8);
+        std::memcpy(&word, end - n, n);
+        return word;
+    }
+
+    struct Seat {
+        std::string_view name;
+        uint64_t tail = 0;          // nameTail() of the name, to rule seats out in one compare
+        int number = 0;
+        int64_t stack = 0;
+        int8_t position = -1;       // -1 when sitting out
+    };
+
+    // Offset of the first hand header at or after `from` at the start of a
+    // line, or text.size() if there's none
+    size_t handStart(std::string_view text, size_t from) {
+        if (from == 0 && text.starts_with(kHandStart)) return 0;
+        size_t at = text.find(kHandBoundary, from == 0 ? 0 : from - 1);
+        return at == std::string_view::npos ? text.size() : at + 1;
+    }
+
+    // Line by line, without the line ending
+    struct Lines {
+        std::string_view text;
+
+        bool next(std::string_view& line) {
+            if (text.empty()) return false;
+            const void* newline = std::memchr(text.data(), '\n', text.size());
+            size_t end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - text.data()) : text.size();
+            line = text.substr(0, end);
+            text.remove_prefix(std::min(end + 1, text.size()));
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            return true;
+        }
+    };
+
+    bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    uint64_t readNumber(std::string_view text) {
+        uint64_t value = 0;
+        for (char c : text) {
+            if (!isDigit(c)) break;
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return value;
+    }
+
+    // The first amount in `text`, in hundredths, past any currency sign;
+    // consumes through it. -1 if there's no number.
+    int64_t readChips(std::string_view& text) {
+        size_t i = 0;
+        while (i < text.size() && !isDigit(text[i])) ++i;
+        if (i == text.size()) return -1;
+        int64_t whole = 0;
+        for (; i < text.size() && (isDigit(text[i]) || text[i] == ','); ++i) {
+            if (text[i] != ',') whole = whole * 10 + (text[i] - '0');
+        }
+        int64_t cents = 0;
+        if (i < text.size() && text[i] == '.') {
+            ++i;
+            for (int place = 10; place > 0; place /= 10) {
+                if (i < text.size() && isDigit(text[i])) cents += (text[i++] - '0') * place;
+            }
+            while (i < text.size() && isDigit(text[i])) ++i;
+        }
+        text.remove_prefix(i);
+        return whole * 100 + cents;
+    }
+
+    bool readAmount(std::string_view text, int64_t& out) {
+        out = readChips(text);
+        return out >= 0;
+    }
+
+    int cardFromText(char rank, char suit) {
+        int r;
+        switch (rank) {
+            case 'T': r = 8; break;
+            case 'J': r = 9; break;
+            case 'Q': r = 10; break;
+            case 'K': r = 11; break;
+            case 'A': r = 12; break;
+            default:
+                if (rank < '2' || rank > '9') return -1;
+                r = rank - '2';
+        }
+        switch (suit) {
+            case 'c': return r;
+            case 'd': return 13 + r;
+            case 'h': return 26 + r;
+            case 's': return 39 + r;
+        }
+        return -1;
+    }
+
+    // The cards in the last [...] of `text`, at most `max` of them; how many
+    // were read
+    int readCards(std::string_view text, uint8_t* out, int max) {
+        size_t open = text.rfind('[');
+        if (open == std::string_view::npos) return 0;
+        int count = 0;
+        for (size_t i = open + 1; i + 1 < text.size() && text[i] != ']' && count < max;) {
+            if (text[i] == ' ') {
+                ++i;
+                continue;
+            }
+            int card = cardFromText(text[i], text[i + 1]);
+            if (card < 0) return count;
+            out[count++] = static_cast<uint8_t>(card);
+            i += 2;
+        }
+        return count;
+    }
+
+    // The seat whose player's name starts `line` followed by `suffix`;
+    // nullptr if none. The longest name wins, in case one is a prefix of
+    // another.
+    const Seat* speaker(std::string_view line, const Seat* seats, size_t count, std::string_view suffix) {
+        const Seat* found = nullptr;
+        for (size_t i = 0; i < count; ++i) {
+            // Players' names mostly differ at the end, so the tail rules
+            // out all but the speaker before any string compare
+            std::string_view name = seats[i].name;
+            if (seats[i].position < 0 || line.size() < name.size() + suffix.size() ||
+                nameTail(line.data() + name.size(), name.size()) != seats[i].tail) {
+                continue;
+            }
+            if (!line.starts_with(name) || !line.substr(name.size()).starts_with(suffix)) continue;
+            if (!found || name.size() > found->name.size()) found = &seats[i];
+        }
+        return found;
+    }
+
+    // Counting round from the button: small blind, big blind, then the
+    // early positions the table has room for, the button last. Heads-up,
+    // the button posts the small blind.
+    Position positionAfterButton(int offset, int players) {
+        if (players == 2) return offset == 2 ? Position::SB : Position::BB;
+        if (offset == 1) return Position::SB;
+        if (offset == 2) return Position::BB;
+        return static_cast<Position>(3 - (players - offset));
+    }
+}
+
+bool HandHistory::parseHand(std::string_view text, HandRecord& hand, std::vector<ActionRecord>& actions) {
+    hand = HandRecord{};
+    const size_t firstAction = actions.size();
+    auto fail = [&] {
+        actions.erase(actions.begin() + static_cast<std::ptrdiff_t>(firstAction), actions.end());
+        return false;
+    };
+
+    // PokerStars Hand #254019227581:  Hold'em No Limit ($0.05/$0.10 USD) - 2024/11/02 ...
+    Lines lines{text};
+    std::string_view line;
+    if (!lines.next(line) || !line.starts_with(kHandStart)) return false;
+    size_t number = line.find('#');
+    size_t game = line.find(kNoLimitHoldem);
+    if (number == std::string_view::npos || game == std::string_view::npos) return false;
+    hand.id = readNumber(line.substr(number + 1));
+    std::string_view stakes = line.substr(game + kNoLimitHoldem.size());
+    size_t paren = stakes.find('(');
+    if (paren == std::string_view::npos) return false;
+    stakes.remove_prefix(paren + 1);
+    hand.sb = readChips(stakes);
+    hand.bb = readChips(stakes);
+    if (hand.sb <= 0 || hand.bb <= 0) return false;
+
+    // Table 'Alcyone' 6-max Seat #3 is the button
+    if (!lines.next(line)) return false;
+    size_t buttonAt = line.rfind("Seat #");
+    if (buttonAt == std::string_view::npos) return false;
+    int buttonSeat = static_cast<int>(readNumber(line.substr(buttonAt + 6)));
+
+    // Seat 1: alice ($10.00 in chips)
+    std::array<Seat, kMaxSeats> seats;
+    size_t numSeats = 0;
+    bool more;
+    while ((more = lines.next(line)) && line.starts_with("Seat ")) {
+        size_t colon = line.find(": ");
+        size_t chips = line.rfind(" in chips");
+        if (colon == std::string_view::npos || chips == std::string_view::npos || numSeats == kMaxSeats) return false;
+        size_t open = line.rfind(" (", chips);
+        if (open == std::string_view::npos || open < colon) return false;
+        Seat& seat = seats[numSeats++];
+        seat.number = static_cast<int>(readNumber(line.substr(5)));
+        seat.name = line.substr(colon + 2, open - colon - 2);
+        seat.tail = nameTail(seat.name.data() + seat.name.size(), seat.name.size());
+        std::string_view rest = line.substr(open + 2);
+        seat.stack = readChips(rest);
+        bool out = line.find("sitting out", chips) != std::string_view::npos ||
+                   line.find("out of hand", chips) != std::string_view::npos;
+        seat.position = out || seat.stack <= 0 ? -1 : 0;
+    }
+
+    int players = 0;
+    std::array<size_t, kMaxSeats> dealt;
+    for (size_t i = 0; i < numSeats; ++i) {
+        if (seats[i].position == 0) dealt[players++] = i;
+    }
+    if (players < 2 || players > TableState::kSeats) return false;
+    int button = players - 1;   // At the button, or if its seat is empty the last player before it
+    for (int i = 0; i < players; ++i) {
+        if (seats[dealt[i]].number <= buttonSeat) button = i;
+    }
+    for (int offset = 1; offset <= players; ++offset) {
+        Seat& seat = seats[dealt[(button + offset) % players]];
+        Position pos = positionAfterButton(offset, players);
+        seat.position = static_cast<int8_t>(pos);
+        hand.stack[static_cast<int>(pos)] = seat.stack;
+    }
+    hand.players = static_cast<uint8_t>(players);
+
+    Street street = Street::Preflop;
+    for (; more; more = lines.next(line)) {
+        if (line.starts_with("*** ")) {
+            if (line.starts_with("*** SUMMARY")) break;
+            if (line.find("FIRST") != std::string_view::npos) return fail();     // Run twice
+            Street next = line.starts_with("*** FLOP") ? Street::Flop
+                        : line.starts_with("*** TURN") ? Street::Turn
+                        : line.starts_with("*** RIVER") ? Street::River
+                        : line.starts_with("*** SHOW") ? Street::Showdown : street;
+            if (next != street && next != Street::Showdown) {
+                hand.boardCount += static_cast<uint8_t>(
+                    readCards(line, hand.board.data() + hand.boardCount, 5 - hand.boardCount));
+            }
+            street = next;
+            continue;
+        }
+
+        // Dealt to hero [Ah Kd]
+        if (line.starts_with("Dealt to ")) {
+            std::string_view rest = line.substr(9);
+            if (const Seat* seat = speaker(rest, seats.data(), numSeats, " [")) {
+                if (readCards(rest, hand.hole[seat->position].data(), 2) == 2) hand.hero = seat->position;
+            }
+            continue;
+        }
+
+        if (const Seat* seat = speaker(line, seats.data(), numSeats, ": ")) {
+            std::string_view verb = line.substr(seat->name.size() + 2);
+            Position pos = static_cast<Position>(seat->position);
+            int64_t amount = 0;
+            if (verb.starts_with("folds")) {
+                actions.push_back({pos, Action::Fold, street, 0});
+            } else if (verb.starts_with("checks")) {
+                actions.push_back({pos, Action::Check, street, 0});
+            } else if (verb.starts_with("calls ") && readAmount(verb.substr(6), amount)) {
+                actions.push_back({pos, Action::Call, street, amount});
+            } else if (verb.starts_with("bets ") && readAmount(verb.substr(5), amount)) {
+                actions.push_back({pos, Action::Bet, street, amount});
+            } else if (verb.starts_with("raises ") && readAmount(verb.substr(7), amount)) {
+                // "raises $0.20 to $0.30": the first amount is the raise itself
+                actions.push_back({pos, Action::Raise, street, amount});
+            } else if (verb.starts_with("posts ") && readAmount(verb.substr(6), amount)) {
+                // The blinds the engine posts itself; anything else is dead money
+                bool blind = (pos == Position::SB && verb.starts_with("posts small blind") && amount == hand.sb) ||
+                             (pos == Position::BB && verb.starts_with("posts big blind") && amount == hand.bb);
+                if (!blind) hand.dead += amount;
+            } else if (verb.starts_with("shows [")) {
+                readCards(verb, hand.hole[seat->position].data(), 2);
+            }
+            continue;
+        }
+
+        // alice collected $1.85 from pot
+        if (const Seat* seat = speaker(line, seats.data(), numSeats, " collected ")) {
+            int64_t amount = 0;
+            if (readAmount(line.substr(seat->name.size() + 11), amount)) hand.collected[seat->position] += amount;
+        }
+    }
+
+    size_t numActions = actions.size() - firstAction;
+    if (numActions > UINT16_MAX) return fail();
+    hand.numActions = static_cast<uint16_t>(numActions);
+    hand.firstAction = static_cast<uint32_t>(firstAction);
+    return true;
+}
+
+HandHistory HandHistory::parse(std::string_view text) {
+    HandHistory history;
+    history.bytes_ = text.size();
+    HandRecord hand;
+    for (size_t start = handStart(text, 0); start < text.size();) {
+        size_t end = handStart(text, start + 1);
+        if (parseHand(text.substr(start, end - start), hand, history.actions_)) {
+            history.hands_.push_back(hand);
+        } else {
+            history.skipped_++;
+        }
+        start = end;
+    }
+    return history;
+}
+
+std::optional<HandHistory> HandHistory::import(const std::vector<std::string>& paths, std::string& error,
+                                               ThreadPool* pool) {
+    std::vector<MappedFile> files;
+    std::vector<std::string_view> pieces;
+    size_t bytes = 0;
+    for (const std::string& path : paths) {
+        std::optional<MappedFile> file = MappedFile::open(path);
+        if (!file) {
+            error = std::format("cannot read {}", path);
+            return std::nullopt;
+        }
+        std::string_view text = file->view();
+        bytes += text.size();
+        if (text.starts_with(kByteOrderMark)) text.remove_prefix(kByteOrderMark.size());
+        for (size_t start = handStart(text, 0); start < text.size();) {
+            size_t end = handStart(text, std::min(start + kPieceBytes, text.size()));
+            pieces.push_back(text.substr(start, end - start));
+            start = end;
+        }
+        files.push_back(std::move(*file));
+    }
+
+    std::vector<HandHistory> parts(pieces.size());
+    auto parsePiece = [&](size_t i) { parts[i] = parse(pieces[i]); };
+    if (pool) {
+        pool->parallelFor(0, pieces.size(), parsePiece);
+    } else {
+        for (size_t i = 0; i < pieces.size(); ++i) parsePiece(i);
+    }
+
+    HandHistory history;
+    size_t hands = 0, actions = 0;
+    for (const HandHistory& part : parts) {
+        hands += part.hands_.size();
+        actions += part.actions_.size();
+    }
+    history.hands_.reserve(hands);
+    history.actions_.reserve(actions);
+    for (HandHistory& part : parts) history.append(std::move(part));
+    history.bytes_ = bytes;
+    return history;
+}
+
+void HandHistory::append(HandHistory&& other) {
+    uint32_t base = static_cast<uint32_t>(actions_.size());
+    for (HandRecord& hand : other.hands_) {
+        hand.firstAction += base;
+        hands_.push_back(hand);
+    }
+    actions_.insert(actions_.end(), other.actions_.begin(), other.actions_.end());
+    skipped_ += other.skipped_;
+    bytes_ += other.bytes_;
+}
+
+void HandHistory::replay(const HandRecord& hand, std::span<const ActionRecord> actions, GameSession& session,
+                         const std::function<void(const ActionRecord&)>& beforeHero) {
+    const bool heroKnown = hand.hero >= 0;
+    const Position hero = heroKnown ? static_cast<Position>(hand.hero) : Position::BTN;
+    session.setBlinds(static_cast<int>(hand.sb), static_cast<int>(hand.bb));
+    session.setHeroPosition(hero);
+    for (int p = 0; p < TableState::kSeats; ++p) {
+        if (p == static_cast<int>(hero)) {
+            session.setHeroStack(hand.stack[p]);
+        } else {
+            session.setOpponentStack(static_cast<Position>(p), hand.stack[p]);
+        }
+    }
+    session.newHand();
+    if (heroKnown && hand.knownHole(hero)) {
+        const auto& cards = hand.hole[static_cast<int>(hero)];
+        session.setHeroCards(cardFromIndex(cards[0]), cardFromIndex(cards[1]));
+    }
+
+    auto boardCard = [&](int i) { return cardFromIndex(hand.board[i]); };
+    auto dealTo = [&](Street street) {
+        while (session.street() < street) {
+            Street next = static_cast<Street>(static_cast<int>(session.street()) + 1);
+            if (next == Street::Flop && hand.boardCount >= 3) {
+                session.setFlop(boardCard(0), boardCard(1), boardCard(2));
+            } else if (next == Street::Turn && hand.boardCount >= 4) {
+                session.setTurn(boardCard(3));
+            } else if (next == Street::River && hand.boardCount >= 5) {
+                session.setRiver(boardCard(4));
+            } else {
+                session.advanceTo(next);
+            }
+        }
+    };
+
+    for (const ActionRecord& action : actions) {
+        dealTo(action.street());
+        if (heroKnown && beforeHero && action.position() == hero) beforeHero(action);
+        session.recordAction(action.position(), action.action(), action.amount());
+    }
+
+    // Whatever board was dealt after the betting ended, as on an all-in,
+    // then the last bets swept in and any uncalled one returned
+    dealTo(hand.boardCount >= 5 ? Street::River : hand.boardCount == 4 ? Street::Turn
+           : hand.boardCount == 3 ? Street::Flop : Street::Preflop);
+    session.advanceTo(Street::Showdown);
+}
+
+} // namespace sharkwave
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "game_session.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sharkwave {
+
+class ThreadPool;
+
+// One no-limit hold'em hand from a hand history, seats by Position. Chips
+// are in hundredths of the stake's unit (cents, or hundredths of a
+// tournament chip), so cash and tournament hands both stay integral.
+struct HandRecord {
+    static constexpr uint8_t kNoCard = 0xFF;
+
+    uint64_t id = 0;
+    int64_t sb = 0;
+    int64_t bb = 0;
+    int64_t dead = 0;                               // Antes and posts outside the blinds
+    std::array<int64_t, 6> stack{};                 // At the start of the hand; 0 for an empty seat
+    std::array<int64_t, 6> collected{};             // Won from the pots
+    std::array<std::array<uint8_t, 2>, 6> hole;     // cardIndex() of cards dealt or shown, else kNoCard
+    std::array<uint8_t, 5> board;
+    uint8_t boardCount = 0;
+    int8_t hero = -1;                               // The "Dealt to" player's Position, -1 if none
+    uint8_t players = 0;
+    uint16_t numActions = 0;
+    uint32_t firstAction = 0;                       // Into HandHistory::actions()
+
+    HandRecord() {
+        for (auto& cards : hole) cards.fill(kNoCard);
+        board.fill(kNoCard);
+    }
+
+    bool knownHole(Position pos) const { return hole[static_cast<int>(pos)][0] != kNoCard; }
+};
+
+// Hands imported from PokerStars hand-history files. Each file is mapped,
+// cut into pieces of about a megabyte at hand boundaries, and the pieces
+// are parsed on the pool: every line is a string_view into the mapping and
+// every hand lands in a fixed-size HandRecord, its actions in one shared
+// array, so parsing allocates nothing per hand or field. Hands that aren't
+// no-limit hold'em at six seats or fewer are counted and skipped.
+class HandHistory {
+public:
+    // On error, std::nullopt with the file that couldn't be read in `error`
+    static std::optional<HandHistory> import(const std::vector<std::string>& paths, std::string& error,
+                                             ThreadPool* pool = nullptr);
+
+    // Every hand in `text`, which starts at a hand
+    static HandHistory parse(std::string_view text);
+
+    // One hand's text into `hand`, its actions appended to `actions`; false
+    // (and `actions` as it was) for a hand this can't take
+    static bool parseHand(std::string_view text, HandRecord& hand, std::vector<ActionRecord>& actions);
+
+    // Plays `hand` through `session`: the seats and blinds, hero's cards,
+    // then every action in order, dealing the board as each street begins,
+    // and on to the showdown, where the pots hold what the winners
+    // collected before rake and `dead`. Heads-up, the button is the small
+    // blind.
+    // `beforeHero`, if given, runs ahead of each of hero's actions with the
+    // session as hero saw it.
+    static void replay(const HandRecord& hand, std::span<const ActionRecord> actions, GameSession& session,
+                       const std::function<void(const ActionRecord&)>& beforeHero = {});
+
+    const std::vector<HandRecord>& hands() const { return hands_; }
+    std::span<const ActionRecord> actions(const HandRecord& hand) const {
+        return std::span<const ActionRecord>(actions_).subspan(hand.firstAction, hand.numActions);
+    }
+
+    size_t skipped() const { return skipped_; }
+    size_t bytes() const { return bytes_; }
+
+private:
+    void append(HandHistory&& other);
+
+    std::vector<HandRecord> hands_;
+    std::vector<ActionRecord> actions_;
+    size_t skipped_ = 0;
+    size_t bytes_ = 0;
+};
+
+} // namespace sharkwave
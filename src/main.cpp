@@ -1,8 +1,12 @@
 #include "card.h"
 #include "game_session.h"
 #include "decision_engine.h"
+#include "gto_charts.h"
 #include "hand_evaluator.h"
+#include "push_fold.h"
 
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <format>
 #include <string>
@@ -11,6 +15,16 @@
 
 using namespace sharkwave;
 
+// Time the engine may spend on one recommendation
+constexpr std::chrono::microseconds kDecisionBudget{1000};
+
+// Push/fold charts from `sharkwave_sim --solve-push-fold`, used if present
+constexpr const char* kPushFoldPath = "sharkwave_pushfold.bin";
+
+// Preflop charts from `sharkwave_sim --compile-charts`, used if present and
+// picked up again whenever they're recompiled
+constexpr const char* kChartsPath = "sharkwave_charts.bin";
+
 // CLI helpers
 void printHeader() {
     std::cout << "\n=== SHARKWAVE ===\n";
@@ -51,7 +65,12 @@ void printDecision(const Decision& decision) {
             break;
     }
     if (!decision.reason.empty()) {
-        std::cout << "\n> WHY: " << decision.reason;
+        std::cout << "\n> WHY: " << decision.reason.text();
+    }
+    if (decision.equity.samples > 0) {
+        std::cout << std::format("\n> EQUITY: {:.1f}% +/- {:.1f}% ({} samples)",
+                                 decision.equity.value * 100.0, decision.equity.ci95 * 100.0,
+                                 decision.equity.samples);
     }
     std::cout << "\n";
 }
@@ -174,6 +193,9 @@ void runSession() {
     while (true) {
         // New hand
         session.newHand();
+        if (GtoCharts::reloadChartsIfChanged()) {
+            std::cout << "(Preflop charts reloaded from " << kChartsPath << ")\n";
+        }
 
         std::cout << "\n========================================\n";
         std::cout << "NEW HAND\n";
@@ -214,7 +236,7 @@ void runSession() {
             }
         }
 
-        Decision decision = engine.makeDecision();
+        Decision decision = engine.makeDecision(kDecisionBudget);
         printDecision(decision);
 
         std::cout << "\nYour action? (fold/check/call/bet/raise or \"done\" to continue) ";
@@ -274,7 +296,7 @@ void runSession() {
 
                 printYourTurn();
         printGameInfo(session);
-                decision = engine.makeDecision();
+                decision = engine.makeDecision(kDecisionBudget);
                 printDecision(decision);
 
                 std::cout << "\nYour action? (fold/check/call/bet/raise or \"done\") ";
@@ -304,7 +326,7 @@ void runSession() {
 
                 printYourTurn();
         printGameInfo(session);
-                decision = engine.makeDecision();
+                decision = engine.makeDecision(kDecisionBudget);
                 printDecision(decision);
 
                 std::cout << "\nYour action? (fold/check/call/bet/raise or \"done\") ";
@@ -334,7 +356,7 @@ void runSession() {
 
                 printYourTurn();
         printGameInfo(session);
-                decision = engine.makeDecision();
+                decision = engine.makeDecision(kDecisionBudget);
                 printDecision(decision);
 
                 std::cout << "\nYour action? (fold/check/call/bet/raise or \"done\") ";
@@ -397,6 +419,16 @@ void runSession() {
 }
 
 int main() {
+    if (auto tables = PushFoldTables::load(kPushFoldPath)) {
+        GtoCharts::setPushFoldTables(std::make_shared<const PushFoldTables>(std::move(*tables)));
+    }
+    // Built-in charts if there's no file, but say why one that's there
+    // didn't load
+    std::string chartsError;
+    if (!GtoCharts::loadCharts(kChartsPath, chartsError) && std::filesystem::exists(kChartsPath)) {
+        std::cerr << "Ignoring preflop charts: " << chartsError << "\n";
+    }
+
     try {
         runSession();
     } catch (const std::exception& e) {
@@ -1,38 +1,740 @@
+#include "batch.h"
+#include "checkpoint.h"
+#include "decision_engine.h"
+#include "gto_charts.h"
+#include "hand_db.h"
+#include "hand_history.h"
+#include "preflop_strategy.h"
+#include "profiler.h"
+#include "push_fold.h"
+#include "range_equity.h"
 #include "simulation.h"
+#include "sweep.h"
+#include "table_simulation.h"
+#include "thread_pool.h"
+#include "tuner.h"
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <vector>
 
 using namespace sharkwave;
 
+namespace {
+    std::vector<std::string> splitList(const std::string& list) {
+        std::vector<std::string> items;
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t comma = list.find(',', start);
+            if (comma == std::string::npos) comma = list.size();
+            if (comma > start) items.push_back(list.substr(start, comma - start));
+            start = comma + 1;
+        }
+        return items;
+    }
+
+    // "100:200" = rebuy at 100bb, cash out above 200bb; "150" = 150:300
+    StackDepth parseStackDepth(const std::string& item) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) {
+            int bb = std::stoi(item);
+            return {bb, bb * 2};
+        }
+        return {std::stoi(item.substr(0, colon)), std::stoi(item.substr(colon + 1))};
+    }
+
+    // "5/10"
+    BlindLevel parseBlindLevel(const std::string& item) {
+        size_t slash = item.find('/');
+        if (slash == std::string::npos) {
+            int bb = std::stoi(item);
+            return {bb / 2, bb};
+        }
+        return {std::stoi(item.substr(0, slash)), std::stoi(item.substr(slash + 1))};
+    }
+
+    int runSweep(SweepConfig config, const std::string& format, const std::string& outPath) {
+        if (config.opponents.empty()) {
+            config.opponents = {OpponentType::Random, OpponentType::TightPassive,
+                                OpponentType::LooseAggressive, OpponentType::CallingStation};
+        }
+        if (config.stacks.empty()) config.stacks = {{100, 200}};
+        if (config.blinds.empty()) config.blinds = {{5, 10}};
+
+        size_t cellCount = config.opponents.size() * config.stacks.size() * config.blinds.size();
+        std::cerr << "Sweeping " << cellCount << " cells x " << config.handsPerCell << " hands...\n";
+
+        Sweep sweep(config);
+        std::vector<SweepCell> cells = sweep.run();
+
+        std::ofstream file;
+        if (!outPath.empty()) {
+            file.open(outPath);
+            if (!file) {
+                std::cerr << "Cannot open " << outPath << " for writing\n";
+                return 1;
+            }
+        }
+        std::ostream& out = outPath.empty() ? std::cout : file;
+
+        if (format == "json") {
+            Sweep::writeJson(out, cells);
+        } else {
+            Sweep::writeCsv(out, cells);
+        }
+        return 0;
+    }
+
+    int runTune(TuneConfig config, const std::string& outPath) {
+        if (config.opponents.empty()) {
+            config.opponents = {OpponentType::Random, OpponentType::TightPassive,
+                                OpponentType::LooseAggressive, OpponentType::CallingStation};
+        }
+        std::cerr << "Tuning " << Tuner::parameters().size() << " parameters vs "
+                  << config.opponents.size() << " opponent(s), " << config.handsPerEval
+                  << " common hands per candidate...\n";
+
+        Tuner tuner(config);
+        std::vector<TuneResult> results = tuner.run(&std::cerr);
+        Tuner::writeReport(std::cout, results);
+
+        if (!outPath.empty()) {
+            std::ofstream file(outPath);
+            if (!file) {
+                std::cerr << "Cannot open " << outPath << " for writing\n";
+                return 1;
+            }
+            Tuner::writeCsv(file, results);
+        }
+        return 0;
+    }
+
+    int runBatch(const std::string& inPath, BatchConfig config, const std::string& format,
+                 const std::string& outPath) {
+        std::ifstream inFile;
+        if (inPath != "-") {
+            inFile.open(inPath);
+            if (!inFile) {
+                std::cerr << "Cannot open " << inPath << "\n";
+                return 1;
+            }
+        }
+        std::istream& in = inPath == "-" ? std::cin : inFile;
+
+        std::ofstream outFile;
+        if (!outPath.empty()) {
+            outFile.open(outPath);
+            if (!outFile) {
+                std::cerr << "Cannot open " << outPath << " for writing\n";
+                return 1;
+            }
+        }
+        std::ostream& out = outPath.empty() ? std::cout : outFile;
+
+        BatchFormat batchFormat = format == "json" ? BatchFormat::Json : BatchFormat::Csv;
+        BatchRunner::writeHeader(out, batchFormat);
+        BatchSummary summary = BatchRunner(config).run(in, out, batchFormat, &std::cerr);
+        std::cerr << std::format("{} spots in {:.2f}s ({:.0f} spots/sec), {} bad lines\n",
+                                 summary.spots, summary.seconds,
+                                 summary.spots / std::max(summary.seconds, 1e-9), summary.errors);
+        return summary.errors > 0 ? 1 : 0;
+    }
+
+    // Share of all 1326 combos in a set of hand classes
+    double comboShare(const HandClassSet& set) {
+        return static_cast<double>(set.combos()) / kNumCombos;
+    }
+
+    int runPushFold(const std::string& outPath, double ante, size_t threads) {
+        constexpr int kEquitySamples = 2000;
+        constexpr int kIterations = 2000;
+
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&] {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        ThreadPool pool(threads);
+        HandClassEquity equity = HandClassEquity::compute(kEquitySamples, &pool);
+        std::cerr << std::format("Hand class equities: {:.1f}s\n", elapsed());
+        PushFoldTables tables = PushFoldTables::solve(equity, ante, kIterations, &pool);
+        std::cerr << std::format("Push/fold charts, 1-{}bb, ante {}: {:.1f}s\n",
+                                 PushFoldTables::kMaxStack, ante, elapsed());
+
+        std::cout << "Stack  HU SB shove  HU BB call  UTG shove  BTN shove  SB shove  BB call vs SB\n";
+        for (int stack : {5, 10, 15, 20, 25}) {
+            const PushFoldChart& hu = tables.find(2, stack);
+            const PushFoldChart& six = tables.find(6, stack);
+            constexpr int kUtg = static_cast<int>(Position::UTG);
+            constexpr int kBtn = static_cast<int>(Position::BTN);
+            constexpr int kSb = static_cast<int>(Position::SB);
+            constexpr int kBb = static_cast<int>(Position::BB);
+            std::cout << std::format("{:>4}bb  {:>10.1f}%  {:>9.1f}%  {:>8.1f}%  {:>8.1f}%  {:>7.1f}%  {:>12.1f}%\n",
+                                     stack, comboShare(hu.shove[kSb]) * 100, comboShare(hu.call[kSb][kBb]) * 100,
+                                     comboShare(six.shove[kUtg]) * 100, comboShare(six.shove[kBtn]) * 100,
+                                     comboShare(six.shove[kSb]) * 100, comboShare(six.call[kSb][kBb]) * 100);
+        }
+
+        if (!tables.save(outPath)) {
+            std::cerr << "Cannot write " << outPath << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // "open:UTG", "3bet:BTN", "4bet:CO" or "call3bet:BB" for a chart range,
+    // "any" for every hand, anything else as range notation
+    std::optional<Range> parseRangeSpec(const std::string& spec, std::string& error) {
+        if (spec == "any") return Range();
+        size_t colon = spec.find(':');
+        if (colon != std::string::npos) {
+            std::string chart = spec.substr(0, colon);
+            std::optional<Position> pos = GameSession::positionFromString(spec.substr(colon + 1));
+            if (pos && chart == "open") return Range::fromClasses(GtoCharts::openRange(*pos));
+            if (pos && chart == "3bet") return Range::fromClasses(GtoCharts::threeBetRange(*pos));
+            if (pos && chart == "4bet") return Range::fromClasses(GtoCharts::fourBetRange(*pos));
+            if (pos && chart == "call3bet") return Range::fromClasses(GtoCharts::call3betRange(*pos));
+        }
+        std::optional<ClassWeights> weights = parseRange(spec, error);
+        if (!weights) return std::nullopt;
+        return Range::fromClasses(*weights);
+    }
+
+    int runEquity(const std::string& specA, const std::string& specB, const std::string& boardText,
+                  RangeEquityConfig config, size_t threads) {
+        std::string error;
+        std::optional<Range> a = parseRangeSpec(specA, error);
+        std::optional<Range> b = a ? parseRangeSpec(specB, error) : std::nullopt;
+        CardSet board;
+        if (!a || !b) {
+            std::cerr << "Bad range: " << error << "\n";
+            return 1;
+        }
+        if (!parseCards(boardText, board) || board.count > 5 || board.count == 1 || board.count == 2) {
+            std::cerr << "Bad board " << boardText << "\n";
+            return 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ThreadPool pool(threads);
+        RangeEquity equity = rangeVsRange(*a, *b, board.mask(), config, &pool);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::format("{} vs {}{}{}: {:.2f}% ({} {} runouts, {:.2f}s)\n", specA, specB,
+                                 board.count ? " on " : "", board.count ? boardText : "",
+                                 equity.equity * 100, equity.boards, equity.exact ? "exact" : "sampled", seconds);
+
+        // A's equity by hand class, on the usual grid; blank where A has none
+        static constexpr char kRanks[] = "AKQJT98765432";
+        std::cout << "    ";
+        for (int col = 0; col < 13; ++col) std::cout << std::format("{:>5}", kRanks[col]);
+        std::cout << "\n";
+        for (int row = 0; row < 13; ++row) {
+            std::cout << std::format("{:>4}", kRanks[row]);
+            for (int col = 0; col < 13; ++col) {
+                double e = equity.classEquity[row * 13 + col];
+                std::cout << (e < 0.0 ? std::string(5, ' ') : std::format("{:>5.1f}", e * 100));
+            }
+            std::cout << "\n";
+        }
+        return 0;
+    }
+
+    int runCompileCharts(const std::string& dir, const std::string& outPath) {
+        std::string error;
+        std::optional<PreflopStrategy> strategy = PreflopStrategy::compile(dir, error);
+        if (!strategy) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        if (!strategy->save(outPath)) {
+            std::cerr << "Cannot write " << outPath << "\n";
+            return 1;
+        }
+
+        // Check it reads back, and what loading costs
+        auto start = std::chrono::steady_clock::now();
+        std::optional<PreflopStrategy> loaded = PreflopStrategy::load(outPath, error);
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if (!loaded) {
+            std::cerr << "Cannot read back " << outPath << ": " << error << "\n";
+            return 1;
+        }
+
+        // Share of combos each position opens at 40-100bb, counting mixes by frequency
+        std::cout << "Open %:";
+        for (int p = 0; p < 6; ++p) {
+            auto pos = static_cast<Position>(p);
+            double combos = 0.0;
+            for (int cls = 0; cls < kNumHandClasses; ++cls) {
+                const ActionMix& mix = loaded->mix(PreflopSpot::Open, pos, DepthBucket::Medium, cls);
+                combos += handClassCombos(cls) * (255 - mix[GtoAction::Fold]) / 255.0;
+            }
+            std::cout << std::format(" {} {:.1f}", GameSession::positionToString(pos), combos / kNumCombos * 100);
+        }
+        std::cout << std::format("\nWrote {}, maps in {:.1f} us\n", outPath, micros);
+        return 0;
+    }
+
+    // Imports hand histories, adds hero's hands to the database in `dbPath`
+    // if one is given and, if asked, replays up to `replayHands` of them,
+    // deciding each of hero's spots with the engine alongside what hero
+    // really did
+    int runImport(const std::vector<std::string>& paths, size_t threads, const std::string& dbPath,
+                  int replayHands, int equityIterations) {
+        auto start = std::chrono::steady_clock::now();
+        ThreadPool pool(threads);
+        std::string error;
+        std::optional<HandHistory> history = HandHistory::import(paths, error, &pool);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!history) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::cout << std::format("{} hands ({} skipped) from {:.1f} MB in {:.3f}s: {:.0f} hands/sec on {} threads\n",
+                                 history->hands().size(), history->skipped(), history->bytes() / 1e6, seconds,
+                                 history->hands().size() / std::max(seconds, 1e-9), pool.size());
+
+        if (!dbPath.empty()) {
+            std::vector<HandRow> rows;
+            for (const HandRecord& hand : history->hands()) {
+                if (std::optional<HandRow> row = HandDb::row(hand, history->actions(hand))) rows.push_back(*row);
+            }
+            if (!HandDb::append(dbPath, rows, error)) {
+                std::cerr << error << "\n";
+                return 1;
+            }
+            std::cout << std::format("Added {} hands to {} ({} without hero's cards left out)\n", rows.size(),
+                                     dbPath, history->hands().size() - rows.size());
+        }
+        if (replayHands <= 0) return 0;
+
+        GameSession session;
+        DecisionEngine engine(session);
+        engine.setEquityIterations(equityIterations);
+        std::array<int, 4> spots{}, agreed{};
+        int replayed = 0;
+        for (const HandRecord& hand : history->hands()) {
+            if (replayed == replayHands) break;
+            if (hand.hero < 0) continue;
+            ++replayed;
+            HandHistory::replay(hand, history->actions(hand), session, [&](const ActionRecord& actual) {
+                int street = static_cast<int>(actual.street());
+                Decision decision = engine.makeDecision();
+                spots[street]++;
+                agreed[street] += decision.action == actual.action();
+            });
+        }
+
+        std::cout << std::format("Replayed {} hands; engine agrees with hero:\n", replayed);
+        for (int street = 0; street < 4; ++street) {
+            if (spots[street] == 0) continue;
+            std::cout << std::format("  {:8} {:6.1f}% of {}\n", GameSession::streetToString(static_cast<Street>(street)),
+                                     100.0 * agreed[street] / spots[street], spots[street]);
+        }
+        return 0;
+    }
+
+    // BB/100 of the hands in a database that match `where`, per group
+    int runQuery(const std::string& dbPath, const std::string& where, const std::string& by, size_t threads) {
+        std::string error;
+        std::optional<HandQuery> query = HandDb::parseQuery(where, by, error);
+        if (!query) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::optional<HandDb> db = HandDb::open(dbPath, error);
+        if (!db) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+
+        ThreadPool pool(threads);
+        HandQueryResult result = db->query(*query, &pool);
+        std::cout << std::format("{} of {} hands match; scanned in {:.3f}s ({:.0f}M hands/sec on {} threads)\n",
+                                 result.total.hands, result.scanned, result.seconds,
+                                 result.scanned / std::max(result.seconds, 1e-9) / 1e6, pool.size());
+        std::cout << std::format("{:<10} {:>10} {:>9} {:>8}\n", query->groupBy ? by : "", "hands", "BB/100", "+/-95%");
+        for (size_t key = 0; key < result.groups.size(); ++key) {
+            const HandGroup& group = result.groups[key];
+            if (group.hands == 0) continue;
+            RunningStats bb100 = group.bbPer100();
+            std::cout << std::format("{:<10} {:>10} {:>9.2f} {:>8.2f}\n",
+                                     query->groupBy ? HandDb::groupName(*query->groupBy, static_cast<int>(key)) : "all",
+                                     group.hands, bb100.mean(), bb100.ci95());
+        }
+        return 0;
+    }
+}
+
 int main(int argc, char* argv[]) {
     int numHands = 1000;
+    bool handsGiven = false;
+    double targetCi = 0.0;
     OpponentType opponent = OpponentType::Random;
+    int seats = 0;
+    bool profile = false;
+    std::string checkpointPath;
+    std::string resumePath;
+    int checkpointEvery = 1000000;
+    uint64_t seed = 0;
+    int equityIterations = SimConfig{}.equityIterations;
+    int riverSolveIterations = 0;
+    bool rangeTracking = false;
+
+    bool sweepMode = false;
+    bool tuneMode = false;
+    int rounds = TuneConfig{}.rounds;
+    SweepConfig sweepConfig;
+    std::string format = "csv";
+    std::string outPath;
+    std::string solvePushFoldPath;
+    std::string batchPath;
+    std::string pushFoldPath;
+    std::string compileChartsDir;
+    std::string chartsPath;
+    std::string equityA;
+    std::string equityB;
+    std::string boardText = "-";
+    int64_t equitySamples = RangeEquityConfig{}.samples;
+    double ante = 0.0;
+    std::vector<std::string> importPaths;
+    bool replay = false;
+    std::string dbPath;
+    std::string queryPath;
+    std::string where;
+    std::string groupBy;
 
     // Parse command line args
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--hands" && i + 1 < argc) {
             numHands = std::stoi(argv[++i]);
+            handsGiven = true;
+        } else if (arg == "--target-ci" && i + 1 < argc) {
+            targetCi = std::stod(argv[++i]);
         } else if (arg == "--opponent" && i + 1 < argc) {
-            std::string opp = argv[++i];
-            if (opp == "random") opponent = OpponentType::Random;
-            else if (opp == "tight") opponent = OpponentType::TightPassive;
-            else if (opp == "lag") opponent = OpponentType::LooseAggressive;
-            else if (opp == "station") opponent = OpponentType::CallingStation;
+            if (auto opp = Simulation::parseOpponent(argv[++i])) opponent = *opp;
+        } else if (arg == "--seats" && i + 1 < argc) {
+            seats = std::stoi(argv[++i]);
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            checkpointEvery = std::stoi(argv[++i]);
+        } else if (arg == "--resume" && i + 1 < argc) {
+            resumePath = argv[++i];
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg == "--sweep") {
+            sweepMode = true;
+        } else if (arg == "--tune") {
+            tuneMode = true;
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::stoi(argv[++i]);
+        } else if (arg == "--opponents" && i + 1 < argc) {
+            std::string list = argv[++i];
+            if (list != "all") {
+                for (const std::string& name : splitList(list)) {
+                    if (auto opp = Simulation::parseOpponent(name)) {
+                        sweepConfig.opponents.push_back(*opp);
+                    } else {
+                        std::cerr << "Unknown opponent type: " << name << "\n";
+                        return 1;
+                    }
+                }
+            }
+        } else if (arg == "--stacks" && i + 1 < argc) {
+            for (const std::string& item : splitList(argv[++i])) {
+                sweepConfig.stacks.push_back(parseStackDepth(item));
+            }
+        } else if (arg == "--blinds" && i + 1 < argc) {
+            for (const std::string& item : splitList(argv[++i])) {
+                sweepConfig.blinds.push_back(parseBlindLevel(item));
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            sweepConfig.threads = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        } else if (arg == "--equity-iters" && i + 1 < argc) {
+            equityIterations = std::stoi(argv[++i]);
+        } else if (arg == "--river-solver" && i + 1 < argc) {
+            riverSolveIterations = std::stoi(argv[++i]);
+        } else if (arg == "--ranges") {
+            rangeTracking = true;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchPath = argv[++i];
+        } else if (arg == "--solve-push-fold" && i + 1 < argc) {
+            solvePushFoldPath = argv[++i];
+        } else if (arg == "--ante" && i + 1 < argc) {
+            ante = std::stod(argv[++i]);
+        } else if (arg == "--push-fold" && i + 1 < argc) {
+            pushFoldPath = argv[++i];
+        } else if (arg == "--compile-charts" && i + 1 < argc) {
+            compileChartsDir = argv[++i];
+        } else if (arg == "--charts" && i + 1 < argc) {
+            chartsPath = argv[++i];
+        } else if (arg == "--equity" && i + 1 < argc) {
+            equityA = argv[++i];
+        } else if (arg == "--vs" && i + 1 < argc) {
+            equityB = argv[++i];
+        } else if (arg == "--board" && i + 1 < argc) {
+            boardText = argv[++i];
+        } else if (arg == "--samples" && i + 1 < argc) {
+            equitySamples = std::stoll(argv[++i]);
+        } else if (arg == "--import" && i + 1 < argc) {
+            importPaths = splitList(argv[++i]);
+        } else if (arg == "--replay") {
+            replay = true;
+        } else if (arg == "--db" && i + 1 < argc) {
+            dbPath = argv[++i];
+        } else if (arg == "--query" && i + 1 < argc) {
+            queryPath = argv[++i];
+        } else if (arg == "--where" && i + 1 < argc) {
+            where = argv[++i];
+        } else if (arg == "--by" && i + 1 < argc) {
+            groupBy = argv[++i];
+        } else if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            outPath = argv[++i];
         } else if (arg == "--help") {
             std::cout << "SharkWave Simulation\n\n";
             std::cout << "Usage: sharkwave_sim [options]\n\n";
             std::cout << "Options:\n";
             std::cout << "  --hands N     Number of hands to simulate (default: 1000)\n";
             std::cout << "  --opponent T  Opponent type: random, tight, lag, station (default: random)\n";
+            std::cout << "  --target-ci X Stop once the 95% CI of BB/100 is within +/-X\n";
+            std::cout << "                (--hands becomes the upper limit, default 10000000)\n";
+            std::cout << "  --seats N     Play an N-handed table (2-9) with a rotating button\n";
+            std::cout << "                instead of the heads-up simulation\n";
+            std::cout << "  --seed N      Seed for reproducible deals\n";
+            std::cout << "  --db DIR      Add hero's hands to the hand database in DIR (heads-up)\n";
+            std::cout << "  --equity-iters N  Monte Carlo samples per heads-up equity estimate\n";
+            std::cout << "                (default: " << SimConfig{}.equityIterations << ")\n";
+            std::cout << "  --river-solver N  Play hero's river spots from an N-iteration CFR+\n";
+            std::cout << "                solve (about 100 is enough; default: off)\n";
+            std::cout << "  --ranges      Narrow villain's range by their actions and weigh\n";
+            std::cout << "                hero's equity by it (half the hands/sec; default: off)\n";
+            std::cout << "  --push-fold FILE  Play stacks under 25bb from push/fold charts in FILE\n";
+            std::cout << "  --charts FILE     Play preflop from charts compiled into FILE\n";
+            std::cout << "  --checkpoint FILE       Save run state to FILE periodically\n";
+            std::cout << "  --checkpoint-every N    Hands between checkpoints (default: 1000000)\n";
+            std::cout << "  --resume FILE           Continue the run saved in FILE; its settings\n";
+            std::cout << "                          replace the other options\n";
+            std::cout << "  --profile     Print hands/sec and a per-phase time breakdown\n";
+            std::cout << "                (phase timers need a -DSHARKWAVE_PROFILE=ON build)\n";
             std::cout << "  --help        Show this help\n";
+            std::cout << "\nSweep mode (opponent x stack depth x blinds matrix):\n";
+            std::cout << "  --sweep             Run every cell of the grid on a shared worker pool\n";
+            std::cout << "  --opponents LIST    e.g. random,lag or all (default: all)\n";
+            std::cout << "  --stacks LIST       min:max stack in BB, e.g. 100:200,40:80 (default: 100:200)\n";
+            std::cout << "  --blinds LIST       e.g. 5/10,25/50 (default: 5/10)\n";
+            std::cout << "  --hands N           Hands per cell (default: 10000)\n";
+            std::cout << "  --threads N         Worker threads (default: all cores)\n";
+            std::cout << "  --format csv|json   Output format (default: csv)\n";
+            std::cout << "  --out FILE          Write the matrix to FILE instead of stdout\n";
+            std::cout << "\nTuning mode (coordinate descent over the engine's thresholds):\n";
+            std::cout << "  --tune              Maximize BB/100 separately for each opponent type\n";
+            std::cout << "  --opponents LIST    Opponents to tune against (default: all)\n";
+            std::cout << "  --hands N           Common hands per candidate (default: 20000)\n";
+            std::cout << "  --rounds N          Coordinate-descent passes (default: 3)\n";
+            std::cout << "  --threads N         Worker threads (default: all cores)\n";
+            std::cout << "  --out FILE          Also write tuned parameters as CSV\n";
+            std::cout << "\nBatch mode (decide spots offline, one result line per spot):\n";
+            std::cout << "  --batch FILE        Spots from FILE (- for stdin), one per line as JSON,\n";
+            std::cout << "                      e.g. {\"position\": \"BTN\", \"hand\": \"AhKd\", \"board\": \"Qs7c2d\",\n";
+            std::cout << "                      \"pot\": 30, \"to_call\": 10, \"stack\": 990}, or as text:\n";
+            std::cout << "                      BTN AhKd Qs7c2d 30 10 990 [villain_stack] (- = no board)\n";
+            std::cout << "  --threads N         Worker threads (default: all cores)\n";
+            std::cout << "  --equity-iters N    Monte Carlo samples per decision\n";
+            std::cout << "  --seed N            Base seed for the equity samplers (default: 1)\n";
+            std::cout << "  --format csv|json   Output format (default: csv)\n";
+            std::cout << "  --out FILE          Write results to FILE instead of stdout\n";
+            std::cout << "\nPush/fold charts (Nash shove/call ranges for 1-25bb, heads-up and 6-max):\n";
+            std::cout << "  --solve-push-fold FILE  Solve and write the charts to FILE\n";
+            std::cout << "  --ante A            Ante per player in big blinds (default: 0)\n";
+            std::cout << "  --threads N         Worker threads (default: all cores)\n";
+            std::cout << "\nPreflop charts (open.txt, vs_raise.txt, vs_3bet.txt in range notation):\n";
+            std::cout << "  --compile-charts DIR  Compile the charts in DIR into one binary file\n";
+            std::cout << "  --out FILE          Where to write it (default: sharkwave_charts.bin)\n";
+            std::cout << "\nRange vs range equity (overall and per hand class of the first range):\n";
+            std::cout << "  --equity A --vs B   Ranges in notation (\"22+, A2s+, T9s:0.5\") or charts:\n";
+            std::cout << "                      open:POS, 3bet:POS, 4bet:POS, call3bet:POS, or any\n";
+            std::cout << "                      (the default for --vs)\n";
+            std::cout << "  --board CARDS       e.g. Qs7c2d (default: preflop)\n";
+            std::cout << "  --samples N         Runouts to sample when there are too many to\n";
+            std::cout << "                      enumerate (default: " << RangeEquityConfig{}.samples << ")\n";
+            std::cout << "  --seed N            Seed for sampled runouts (default: 1)\n";
+            std::cout << "  --threads N         Worker threads (default: all cores)\n";
+            std::cout << "\nHand histories (PokerStars text format, no-limit hold'em):\n";
+            std::cout << "  --import LIST       Import files, e.g. a.txt,b.txt, and report the rate\n";
+            std::cout << "  --replay            Replay hero's decisions through the engine and\n";
+            std::cout << "                      report how often it agrees (--hands caps the hands)\n";
+            std::cout << "  --db DIR            Add hero's hands to the hand database in DIR\n";
+            std::cout << "  --equity-iters N    Monte Carlo samples per decision\n";
+            std::cout << "  --threads N         Worker threads (default: all cores)\n";
+            std::cout << "\nHand database queries:\n";
+            std::cout << "  --query DIR         BB/100 of the hands in the database in DIR\n";
+            std::cout << "  --where CONDS       Only hands matching every condition, e.g.\n";
+            std::cout << "                      \"cbet texture>=wet\" or \"position=BTN !vpip\"; flags\n";
+            std::cout << "                      vpip pfr 3bet aggressor saw-flop cbet-chance cbet\n";
+            std::cout << "                      faced-cbet fold-to-cbet showdown won, street:action\n";
+            std::cout << "                      (flop:raise), position, street, texture, class\n";
+            std::cout << "  --by FIELD          Group by position, class, street or texture\n";
+            std::cout << "  --threads N         Worker threads (default: all cores)\n";
             return 0;
         }
     }
 
-    Simulation sim(numHands, opponent);
-    sim.run();
-    sim.printResults();
+    if (!batchPath.empty()) {
+        BatchConfig batchConfig;
+        batchConfig.threads = sweepConfig.threads;
+        batchConfig.equityIterations = equityIterations;
+        if (seed != 0) batchConfig.seed = seed;
+        return runBatch(batchPath, batchConfig, format, outPath);
+    }
+
+    if (!solvePushFoldPath.empty()) {
+        return runPushFold(solvePushFoldPath, ante, sweepConfig.threads);
+    }
+
+    if (!equityA.empty()) {
+        RangeEquityConfig equityConfig;
+        equityConfig.samples = equitySamples;
+        if (seed != 0) equityConfig.seed = seed;
+        return runEquity(equityA, equityB.empty() ? "any" : equityB, boardText, equityConfig, sweepConfig.threads);
+    }
+
+    if (!importPaths.empty()) {
+        return runImport(importPaths, sweepConfig.threads, dbPath, replay ? (handsGiven ? numHands : 1000) : 0,
+                         equityIterations);
+    }
+
+    if (!queryPath.empty()) {
+        return runQuery(queryPath, where, groupBy, sweepConfig.threads);
+    }
+
+    if (!compileChartsDir.empty()) {
+        return runCompileCharts(compileChartsDir, outPath.empty() ? "sharkwave_charts.bin" : outPath);
+    }
+
+    if (!chartsPath.empty()) {
+        std::string error;
+        if (!GtoCharts::loadCharts(chartsPath, error)) {
+            std::cerr << "Cannot read preflop charts: " << error << "\n";
+            return 1;
+        }
+    }
+
+    if (!pushFoldPath.empty()) {
+        std::optional<PushFoldTables> tables = PushFoldTables::load(pushFoldPath);
+        if (!tables) {
+            std::cerr << "Cannot read push/fold charts " << pushFoldPath << "\n";
+            return 1;
+        }
+        GtoCharts::setPushFoldTables(std::make_shared<const PushFoldTables>(std::move(*tables)));
+    }
+
+    if (sweepMode) {
+        sweepConfig.handsPerCell = handsGiven ? numHands : 10000;
+        sweepConfig.targetCi = targetCi;
+        sweepConfig.seed = seed;
+        sweepConfig.equityIterations = equityIterations;
+        return runSweep(sweepConfig, format, outPath);
+    }
+
+    if (tuneMode) {
+        TuneConfig tuneConfig;
+        tuneConfig.opponents = sweepConfig.opponents;
+        if (handsGiven) tuneConfig.handsPerEval = numHands;
+        tuneConfig.rounds = rounds;
+        tuneConfig.seed = seed;
+        tuneConfig.threads = sweepConfig.threads;
+        tuneConfig.equityIterations = equityIterations;
+        return runTune(tuneConfig, outPath);
+    }
+
+    // With a CI target the hand count is only a safety cap
+    if (targetCi > 0.0 && !handsGiven) {
+        numHands = 10000000;
+    }
+
+    std::optional<Checkpoint> resumeFrom;
+    if (!resumePath.empty()) {
+        resumeFrom = Checkpoint::load(resumePath);
+        if (!resumeFrom) {
+            std::cerr << "Cannot read checkpoint " << resumePath << "\n";
+            return 1;
+        }
+        if (checkpointPath.empty()) checkpointPath = resumePath;
+    }
+
+    Profiler::reset();
+    auto start = std::chrono::steady_clock::now();
+    int handsPlayed = 0;
+
+    if (resumeFrom ? resumeFrom->getInt("config.seats") > 0 : seats > 0) {
+        if (!dbPath.empty()) {
+            std::cerr << "--db records heads-up simulations only\n";
+            return 1;
+        }
+        TableConfig tableConfig;
+        if (resumeFrom) {
+            tableConfig = TableSimulation::configFrom(*resumeFrom);
+        } else {
+            tableConfig.seats = seats;
+            tableConfig.numHands = numHands;
+            tableConfig.opponent = opponent;
+            tableConfig.seed = seed;
+        }
+
+        TableSimulation table(tableConfig);
+        table.setTargetCi(targetCi);
+        if (resumeFrom) table.restoreState(*resumeFrom);
+        if (!checkpointPath.empty()) table.setCheckpoint(checkpointPath, checkpointEvery);
+        int resumedHands = table.handsPlayed();
+        table.run();
+        table.printResults();
+        handsPlayed = table.handsPlayed() - resumedHands;
+    } else {
+        SimConfig config;
+        if (resumeFrom) {
+            config = Simulation::configFrom(*resumeFrom);
+        } else {
+            config.numHands = numHands;
+            config.opponent = opponent;
+            config.seed = seed;
+            config.equityIterations = equityIterations;
+            config.riverSolveIterations = riverSolveIterations;
+            config.rangeTracking = rangeTracking;
+        }
+
+        Simulation sim(config);
+        sim.setTargetCi(targetCi);
+        if (resumeFrom) sim.restoreState(*resumeFrom);
+        if (!checkpointPath.empty()) sim.setCheckpoint(checkpointPath, checkpointEvery);
+        std::vector<HandRow> rows;
+        if (!dbPath.empty()) sim.setHandRows(&rows);
+        int resumedHands = sim.handsPlayed();
+        sim.run();
+        sim.printResults();
+        handsPlayed = sim.handsPlayed() - resumedHands;
+
+        std::string error;
+        if (!dbPath.empty() && !HandDb::append(dbPath, rows, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+
+    if (profile) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        Profiler::printReport(std::cout, handsPlayed, seconds);
+    }
 
     return 0;
 }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sharkwave {
+
+// A whole file mapped read-only into memory. Reading it costs page faults
+// on first touch and nothing else; the mapping stays valid even if the file
+// is replaced or deleted, until this object goes away.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    // std::nullopt if the file can't be opened or mapped. An empty file maps
+    // to an empty view.
+    static std::optional<MappedFile> open(const std::string& path);
+
+    const std::byte* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return {reinterpret_cast<const char*>(data_), size_}; }
+
+private:
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace sharkwave
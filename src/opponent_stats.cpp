@@ -0,0 +1,90 @@
+#include "opponent_stats.h"
+
+namespace sharkwave {
+
+OpponentStats::OpponentStats() {
+    beginHand();
+}
+
+OpponentStats::PlayerId OpponentStats::add() {
+    players_.emplace_back();
+    return static_cast<PlayerId>(players_.size() - 1);
+}
+
+void OpponentStats::beginHand() {
+    seats_.fill(0);
+    street_ = Street::Preflop;
+    preflopRaises_ = 0;
+    preflopAggressor_ = -1;
+    bettor_ = -1;
+    cbetPending_ = false;
+}
+
+void OpponentStats::record(Position pos, PlayerId player, Street street, Action action) {
+    // Untracked seats still update the hand state, just into a scratch record
+    PlayerStats scratch;
+    PlayerStats& stats = player == kNoPlayer ? scratch : players_[player];
+
+    const int seat = static_cast<int>(pos);
+    uint8_t& flags = seats_[seat];
+    const bool aggressive = action == Action::Bet || action == Action::Raise;
+
+    if (street != street_) {
+        street_ = street;
+        bettor_ = -1;
+        cbetPending_ = false;
+        for (uint8_t& f : seats_) f &= ~Responded;
+    }
+
+    if (!(flags & Counted)) {
+        flags |= Counted;
+        stats[Stat::Hands]++;
+    }
+
+    if (street == Street::Preflop) {
+        if (action == Action::Call || aggressive) {
+            if (!(flags & Entered)) stats[Stat::Vpip]++;
+            flags |= Entered;
+        }
+        if (aggressive && !(flags & Raised)) {
+            flags |= Raised;
+            stats[Stat::Pfr]++;
+        }
+        if (preflopRaises_ == 1 && preflopAggressor_ != seat) {
+            stats[Stat::ThreeBetChances]++;
+            if (aggressive) stats[Stat::ThreeBets]++;
+        }
+        if (aggressive) {
+            preflopRaises_++;
+            preflopAggressor_ = static_cast<int8_t>(seat);
+        }
+        return;
+    }
+
+    // Answering the street's latest bet
+    if (bettor_ >= 0 && bettor_ != seat && !(flags & Responded)) {
+        flags |= Responded;
+        stats[Stat::FacedBets]++;
+        if (action == Action::Fold) stats[Stat::FoldsToBet]++;
+        if (cbetPending_) {
+            stats[Stat::FacedCbets]++;
+            if (action == Action::Fold) stats[Stat::FoldsToCbet]++;
+        }
+    }
+
+    if (street == Street::Flop && bettor_ < 0 && seat == preflopAggressor_) {
+        stats[Stat::CbetChances]++;
+        if (aggressive) stats[Stat::Cbets]++;
+    }
+
+    if (aggressive) {
+        stats[Stat::PostflopAggression]++;
+        cbetPending_ = street == Street::Flop && bettor_ < 0 && seat == preflopAggressor_;
+        bettor_ = static_cast<int8_t>(seat);
+        for (uint8_t& f : seats_) f &= ~Responded;
+    } else if (action == Action::Call) {
+        stats[Stat::PostflopCalls]++;
+    }
+}
+
+} // namespace sharkwave
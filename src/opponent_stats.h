@@ -0,0 +1,101 @@
+#pragma once
+
+#include "game_session.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace sharkwave {
+
+// Raw counts behind the usual HUD numbers. Every stat is a count of times
+// the player did something over a count of chances to, so two players'
+// records (or two sessions') merge by adding.
+enum class Stat : uint8_t {
+    Hands,              // Hands the player acted in
+    Vpip,               // Put money in voluntarily preflop
+    Pfr,                // Raised preflop
+    ThreeBetChances,    // Acted facing exactly one preflop raise
+    ThreeBets,
+    CbetChances,        // Preflop aggressor, first to bet on the flop
+    Cbets,
+    FacedCbets,
+    FoldsToCbet,
+    FacedBets,          // Postflop, any bet or raise
+    FoldsToBet,
+    PostflopAggression, // Bets and raises
+    PostflopCalls,
+    Count
+};
+
+constexpr int kNumStats = static_cast<int>(Stat::Count);
+
+struct PlayerStats {
+    std::array<uint32_t, kNumStats> counts{};
+
+    uint32_t operator[](Stat stat) const { return counts[static_cast<int>(stat)]; }
+    uint32_t& operator[](Stat stat) { return counts[static_cast<int>(stat)]; }
+
+    double vpip() const { return rate(Stat::Vpip, Stat::Hands); }
+    double pfr() const { return rate(Stat::Pfr, Stat::Hands); }
+    double threeBet() const { return rate(Stat::ThreeBets, Stat::ThreeBetChances); }
+    double cbet() const { return rate(Stat::Cbets, Stat::CbetChances); }
+    double foldToCbet() const { return rate(Stat::FoldsToCbet, Stat::FacedCbets); }
+    double foldToBet() const { return rate(Stat::FoldsToBet, Stat::FacedBets); }
+
+    // (bets + raises) / calls, postflop; 0 until the player has called once
+    double aggressionFactor() const { return rate(Stat::PostflopAggression, Stat::PostflopCalls); }
+
+private:
+    double rate(Stat made, Stat chances) const {
+        uint32_t n = (*this)[chances];
+        return n == 0 ? 0.0 : static_cast<double>((*this)[made]) / n;
+    }
+};
+
+static_assert(sizeof(PlayerStats) <= 64, "one player's stats should fit a cache line");
+
+// Stats for every player seen, kept across hands and sessions. Players are
+// numbered densely by add() and their records stored contiguously, so the
+// store scales to thousands of opponents and record() is O(1) with no
+// allocation: it touches one PlayerStats and a few bytes of hand state.
+class OpponentStats {
+public:
+    using PlayerId = uint32_t;
+    static constexpr PlayerId kNoPlayer = UINT32_MAX;
+
+    OpponentStats();
+
+    PlayerId add();
+    size_t size() const { return players_.size(); }
+
+    const PlayerStats& operator[](PlayerId player) const { return players_[player]; }
+    PlayerStats& operator[](PlayerId player) { return players_[player]; }
+
+    // Clear the per-hand state (who raised preflop, who bet the flop...)
+    void beginHand();
+
+    // Count one action. `player` may be kNoPlayer for seats that aren't
+    // tracked (usually hero); their actions still shape everyone else's
+    // chances, e.g. a hero open gives the villain a 3-bet chance.
+    void record(Position pos, PlayerId player, Street street, Action action);
+
+private:
+    enum SeatFlags : uint8_t {
+        Counted = 1 << 0,   // Hands already counted
+        Entered = 1 << 1,   // VPIP already counted
+        Raised = 1 << 2,    // PFR already counted
+        Responded = 1 << 3, // Already answered the street's latest bet
+    };
+
+    std::vector<PlayerStats> players_;
+
+    // Current hand
+    std::array<uint8_t, 6> seats_;
+    Street street_;
+    int preflopRaises_;
+    int8_t preflopAggressor_;   // Seat, or -1
+    int8_t bettor_;             // Seat that made the street's latest bet, or -1
+    bool cbetPending_;          // The latest flop bet is a c-bet nobody has raised
+};
+
+} // namespace sharkwave
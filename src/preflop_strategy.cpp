@@ -0,0 +1,378 @@
+#include "preflop_strategy.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
+namespace sharkwave {
+
+namespace {
+    // File header, padded so the table after it is aligned
+    constexpr std::string_view kMagic = "sharkwave-charts 1\n";
+
+    struct FileHeader {
+        char magic[24];
+        uint32_t entries;
+        uint32_t entrySize;
+    };
+
+    constexpr std::string_view kSpotFiles[kNumPreflopSpots] = {"open.txt", "vs_raise.txt", "vs_3bet.txt"};
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+        return s;
+    }
+
+    std::string lower(std::string_view s) {
+        std::string out(s);
+        for (char& c : out) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return out;
+    }
+
+    // Classes next to one in `range` on the 13x13 grid: one rank step away,
+    // same shape. Range edges sit between these and the rest.
+    HandClassSet neighbors(const HandClassSet& range) {
+        HandClassSet out;
+        for (int cls = 0; cls < kNumHandClasses; ++cls) {
+            int row = cls / 13;
+            int col = cls % 13;
+            bool near = (row > 0 && range.test(cls - 13)) || (row < 12 && range.test(cls + 13)) ||
+                        (col > 0 && range.test(cls - 1)) || (col < 12 && range.test(cls + 1));
+            if (near) out.set(cls);
+        }
+        return out;
+    }
+
+    // Hands in `range` with a neighbor outside it
+    HandClassSet edge(const HandClassSet& range) {
+        HandClassSet all;
+        for (int cls = 0; cls < kNumHandClasses; ++cls) all.set(cls);
+        return range & neighbors(all.without(range));
+    }
+
+    // Hands outside `range` next to one inside it
+    HandClassSet fringe(const HandClassSet& range) {
+        return neighbors(range).without(range);
+    }
+}
+
+GtoAction ActionMix::mostLikely() const {
+    int best = 0;
+    for (int a = 1; a < 4; ++a) {
+        if (freq[a] > freq[best]) best = a;
+    }
+    return static_cast<GtoAction>(best);
+}
+
+ActionMix ActionMix::pure(GtoAction action) {
+    ActionMix mix;
+    mix.freq = {0, 0, 0, 0};
+    mix.freq[static_cast<int>(action)] = 255;
+    return mix;
+}
+
+ActionMix ActionMix::of(double fold, double call, double raise, double allIn) {
+    double weights[4] = {fold, call, raise, allIn};
+    double total = fold + call + raise + allIn;
+    if (total <= 0.0) return pure(GtoAction::Fold);
+
+    // Round each share, then settle the rounding error on the largest
+    ActionMix mix;
+    int sum = 0;
+    int largest = 0;
+    for (int a = 0; a < 4; ++a) {
+        mix.freq[a] = static_cast<uint8_t>(std::lround(weights[a] / total * 255.0));
+        sum += mix.freq[a];
+        if (weights[a] > weights[largest]) largest = a;
+    }
+    mix.freq[largest] = static_cast<uint8_t>(mix.freq[largest] + 255 - sum);
+    return mix;
+}
+
+ActionSampler::ActionSampler(const ActionMix& mix) {
+    // Each of the four buckets holds 65536 units of probability: its own
+    // action below threshold_, topped up by alias_ above it
+    constexpr int64_t kBucket = 65536;
+    int64_t mass[4];
+    for (int a = 0; a < 4; ++a) mass[a] = mix.freq[a] * 4 * kBucket / 255;
+
+    int small[4], large[4];
+    int numSmall = 0, numLarge = 0;
+    for (int a = 0; a < 4; ++a) {
+        if (mass[a] < kBucket) small[numSmall++] = a;
+        else large[numLarge++] = a;
+    }
+    while (numSmall > 0 && numLarge > 0) {
+        int s = small[--numSmall];
+        int l = large[numLarge - 1];
+        threshold_[s] = static_cast<uint16_t>(mass[s]);
+        alias_[s] = static_cast<uint8_t>(l);
+        mass[l] -= kBucket - mass[s];
+        if (mass[l] < kBucket) {
+            numLarge--;
+            small[numSmall++] = l;
+        }
+    }
+
+    // Whatever is left is full, up to rounding: it always draws itself
+    for (int i = 0; i < numLarge; ++i) {
+        threshold_[large[i]] = UINT16_MAX;
+        alias_[large[i]] = static_cast<uint8_t>(large[i]);
+    }
+    for (int i = 0; i < numSmall; ++i) {
+        threshold_[small[i]] = UINT16_MAX;
+        alias_[small[i]] = static_cast<uint8_t>(small[i]);
+    }
+}
+
+PreflopStrategy::PreflopStrategy()
+    : owned_(kNumEntries)
+{
+    entries_ = owned_.data();
+}
+
+PreflopStrategy::PreflopStrategy(MappedFile file)
+    : entries_(reinterpret_cast<const Entry*>(file.data() + sizeof(FileHeader)))
+    , file_(std::move(file))
+{
+}
+
+void PreflopStrategy::set(PreflopSpot spot, Position pos, DepthBucket depth, int cls, const ActionMix& mix) {
+    if (owned_.empty()) {
+        owned_.assign(entries_, entries_ + kNumEntries);
+        entries_ = owned_.data();
+        file_ = MappedFile();
+    }
+    Entry& entry = owned_[index(spot, pos, depth, cls)];
+    entry.mix = mix;
+    entry.sampler = ActionSampler(mix);
+}
+
+PreflopStrategy PreflopStrategy::builtIn() {
+    // Share of value re-raises flatted instead, so calling ranges aren't weak
+    constexpr double kTrap = 0.25;
+
+    PreflopStrategy strategy;
+    for (int p = 0; p < 6; ++p) {
+        auto pos = static_cast<Position>(p);
+        const HandClassSet open = GtoCharts::openRange(pos);
+        const HandClassSet threeBet = GtoCharts::threeBetRange(pos);
+        const HandClassSet fourBet = GtoCharts::fourBetRange(pos);
+        const HandClassSet callRaise = GtoCharts::call3betRange(pos).without(threeBet);
+        const HandClassSet call3bet = (GtoCharts::call3betRange(pos) | threeBet).without(fourBet);
+
+        const HandClassSet openEdge = edge(open), openFringe = fringe(open);
+        const HandClassSet callEdge = edge(callRaise), callFringe = fringe(callRaise | threeBet);
+
+        for (int d = 0; d < kNumDepthBuckets; ++d) {
+            auto depth = static_cast<DepthBucket>(d);
+            bool shallow = depth == DepthBucket::Short;
+
+            for (int cls = 0; cls < kNumHandClasses; ++cls) {
+                ActionMix mix;
+                if (open.test(cls)) mix = openEdge.test(cls) ? ActionMix::of(0.25, 0, 0.75, 0) : ActionMix::pure(GtoAction::Raise);
+                else if (openFringe.test(cls)) mix = ActionMix::of(0.75, 0, 0.25, 0);
+                strategy.set(PreflopSpot::Open, pos, depth, cls, mix);
+
+                mix = ActionMix::pure(GtoAction::Fold);
+                if (threeBet.test(cls)) {
+                    mix = shallow ? ActionMix::pure(GtoAction::AllIn) : ActionMix::of(0, kTrap, 1 - kTrap, 0);
+                } else if (callRaise.test(cls)) {
+                    if (shallow) mix = ActionMix::of(0.4, 0.6, 0, 0);
+                    else if (depth == DepthBucket::Medium && callEdge.test(cls)) mix = ActionMix::of(0.3, 0.7, 0, 0);
+                    else mix = ActionMix::pure(GtoAction::Call);
+                } else if (depth == DepthBucket::Deep && callFringe.test(cls)) {
+                    mix = ActionMix::of(0.7, 0.3, 0, 0);    // Implied odds
+                }
+                strategy.set(PreflopSpot::VsRaise, pos, depth, cls, mix);
+
+                mix = ActionMix::pure(GtoAction::Fold);
+                if (fourBet.test(cls)) {
+                    mix = shallow ? ActionMix::pure(GtoAction::AllIn) : ActionMix::of(0, kTrap, 1 - kTrap, 0);
+                } else if (call3bet.test(cls)) {
+                    mix = shallow ? ActionMix::of(0.6, 0, 0, 0.4) : ActionMix::pure(GtoAction::Call);
+                }
+                strategy.set(PreflopSpot::Vs3bet, pos, depth, cls, mix);
+            }
+        }
+    }
+    return strategy;
+}
+
+std::optional<PreflopStrategy> PreflopStrategy::compile(const std::string& dir, std::string& error) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (!fs::is_directory(dir, ec)) {
+        error = dir + ": not a directory";
+        return std::nullopt;
+    }
+    for (const fs::directory_entry& file : fs::directory_iterator(dir, ec)) {
+        std::string name = file.path().filename().string();
+        bool known = false;
+        for (std::string_view spotFile : kSpotFiles) known |= name == spotFile;
+        if (file.path().extension() == ".txt" && !known) {
+            error = file.path().string() + ": not a chart (expected open.txt, vs_raise.txt or vs_3bet.txt)";
+            return std::nullopt;
+        }
+    }
+
+    PreflopStrategy strategy = builtIn();
+    for (int s = 0; s < kNumPreflopSpots; ++s) {
+        auto spot = static_cast<PreflopSpot>(s);
+        fs::path path = fs::path(dir) / kSpotFiles[s];
+        std::ifstream in(path);
+        if (!in) continue;
+
+        // A file replaces its spot whole
+        for (int p = 0; p < 6; ++p) {
+            for (int d = 0; d < kNumDepthBuckets; ++d) {
+                for (int cls = 0; cls < kNumHandClasses; ++cls) {
+                    strategy.set(spot, static_cast<Position>(p), static_cast<DepthBucket>(d), cls, ActionMix{});
+                }
+            }
+        }
+
+        // The open section: its cells, and each non-fold action's weights
+        std::optional<Position> pos;
+        int depthFrom = 0, depthTo = kNumDepthBuckets - 1;
+        std::array<ClassWeights, 4> weights{};
+        int sectionLine = 0;
+
+        auto fail = [&](int line, const std::string& why) {
+            error = std::format("{}:{}: {}", path.string(), line, why);
+            return std::nullopt;
+        };
+        auto flush = [&]() -> bool {
+            if (!pos) return true;
+            for (int cls = 0; cls < kNumHandClasses; ++cls) {
+                float play = weights[1][cls] + weights[2][cls] + weights[3][cls];
+                if (play > 1.001f) {
+                    error = std::format("{}:{}: {} is played more than all the time", path.string(),
+                                        sectionLine, handClassName(cls));
+                    return false;
+                }
+                ActionMix mix = ActionMix::of(std::max(0.0f, 1.0f - play), weights[1][cls],
+                                              weights[2][cls], weights[3][cls]);
+                for (int d = depthFrom; d <= depthTo; ++d) {
+                    strategy.set(spot, *pos, static_cast<DepthBucket>(d), cls, mix);
+                }
+            }
+            return true;
+        };
+
+        std::string raw;
+        int lineNo = 0;
+        while (std::getline(in, raw)) {
+            ++lineNo;
+            std::string_view line = raw;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) continue;
+
+            if (line.front() == '[') {
+                if (line.back() != ']') return fail(lineNo, "unclosed section header");
+                if (!flush()) return std::nullopt;
+
+                std::istringstream header{std::string(line.substr(1, line.size() - 2))};
+                std::string posName, depthName, extra;
+                header >> posName >> depthName >> extra;
+                pos = GameSession::positionFromString(posName);
+                if (!pos) return fail(lineNo, "unknown position \"" + posName + "\"");
+                depthFrom = 0;
+                depthTo = kNumDepthBuckets - 1;
+                if (!depthName.empty()) {
+                    std::string depth = lower(depthName);
+                    if (depth == "short") depthFrom = depthTo = static_cast<int>(DepthBucket::Short);
+                    else if (depth == "medium") depthFrom = depthTo = static_cast<int>(DepthBucket::Medium);
+                    else if (depth == "deep") depthFrom = depthTo = static_cast<int>(DepthBucket::Deep);
+                    else return fail(lineNo, "unknown depth \"" + depthName + "\" (short, medium or deep)");
+                }
+                if (!extra.empty()) return fail(lineNo, "unexpected \"" + extra + "\" in section header");
+                weights = {};
+                sectionLine = lineNo;
+                continue;
+            }
+
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos) return fail(lineNo, "expected \"action: range\"");
+            if (!pos) return fail(lineNo, "action before any [position] section");
+            std::string action = lower(trim(line.substr(0, colon)));
+            int a = action == "call" ? 1 : action == "raise" ? 2 : action == "allin" ? 3 : 0;
+            if (a == 0) return fail(lineNo, "unknown action \"" + action + "\" (raise, call or allin)");
+
+            std::string why;
+            std::optional<ClassWeights> range = parseRange(line.substr(colon + 1), why);
+            if (!range) return fail(lineNo, why);
+            for (int cls = 0; cls < kNumHandClasses; ++cls) {
+                if ((*range)[cls] > 0.0f) weights[a][cls] = (*range)[cls];
+            }
+        }
+        if (!flush()) return std::nullopt;
+    }
+    return strategy;
+}
+
+bool PreflopStrategy::save(const std::string& path) const {
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic.data(), kMagic.size());
+    header.entries = static_cast<uint32_t>(kNumEntries);
+    header.entrySize = sizeof(Entry);
+
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries_), static_cast<std::streamsize>(kNumEntries * sizeof(Entry)));
+        out.flush();
+        if (!out) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+std::optional<PreflopStrategy> PreflopStrategy::load(const std::string& path, std::string& error) {
+    static_assert(std::is_trivially_copyable_v<Entry>);
+    static_assert(sizeof(FileHeader) % alignof(Entry) == 0);
+
+    std::optional<MappedFile> file = MappedFile::open(path);
+    if (!file) {
+        error = std::format("cannot read {}", path);
+        return std::nullopt;
+    }
+
+    FileHeader header{};
+    if (file->size() >= sizeof(header)) std::memcpy(&header, file->data(), sizeof(header));
+    if (std::string_view(header.magic, kMagic.size()) != kMagic || header.entries != kNumEntries ||
+        header.entrySize != sizeof(Entry)) {
+        error = std::format("{} isn't a chart file this version can read", path);
+        return std::nullopt;
+    }
+    if (file->size() != sizeof(FileHeader) + kNumEntries * sizeof(Entry)) {
+        error = std::format("{}: {} bytes, expected {}", path, file->size(),
+                            sizeof(FileHeader) + kNumEntries * sizeof(Entry));
+        return std::nullopt;
+    }
+
+    const auto* entries = reinterpret_cast<const Entry*>(file->data() + sizeof(FileHeader));
+    for (size_t i = 0; i < kNumEntries; ++i) {
+        const ActionMix& mix = entries[i].mix;
+        int sum = mix.freq[0] + mix.freq[1] + mix.freq[2] + mix.freq[3];
+        if (sum != 255 || !entries[i].sampler.valid()) {
+            error = std::format("{}: entry {} is corrupt", path, i);
+            return std::nullopt;
+        }
+    }
+
+    return PreflopStrategy(std::move(*file));
+}
+
+} // namespace sharkwave
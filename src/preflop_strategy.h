@@ -0,0 +1,145 @@
+#pragma once
+
+#include "game_session.h"
+#include "gto_charts.h"
+#include "mapped_file.h"
+#include "range.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sharkwave {
+
+// The preflop decisions the charts cover
+enum class PreflopSpot : uint8_t {
+    Open,       // Folded to us: raise first in or fold
+    VsRaise,    // Facing an open: 3-bet, call or fold
+    Vs3bet      // Facing a 3-bet: 4-bet, call or fold
+};
+
+constexpr int kNumPreflopSpots = 3;
+
+// Stack depths with their own charts; under 25bb it's push/fold
+enum class DepthBucket : uint8_t {
+    Short,      // 25-40bb
+    Medium,     // 40-100bb
+    Deep        // Over 100bb
+};
+
+constexpr int kNumDepthBuckets = 3;
+
+constexpr DepthBucket depthBucket(int bigBlinds) {
+    return bigBlinds < 40 ? DepthBucket::Short : bigBlinds <= 100 ? DepthBucket::Medium : DepthBucket::Deep;
+}
+
+// How often a hand takes each action, in 255ths that sum to 255
+struct ActionMix {
+    std::array<uint8_t, 4> freq{255, 0, 0, 0};     // By GtoAction; pure fold by default
+
+    uint8_t operator[](GtoAction action) const { return freq[static_cast<int>(action)]; }
+
+    // Ties go to the more passive action
+    GtoAction mostLikely() const;
+
+    static ActionMix pure(GtoAction action);
+
+    // Any non-negative weights; normalized and rounded so the sum is exact
+    static ActionMix of(double fold, double call, double raise, double allIn);
+};
+
+// Walker's alias method over the four actions: a draw is one 64-bit random
+// number, one table read and one compare, whatever the mix
+class ActionSampler {
+public:
+    ActionSampler() = default;      // Always folds
+    explicit ActionSampler(const ActionMix& mix);
+
+    GtoAction sample(uint64_t random) const {
+        int bucket = static_cast<int>(random >> 62);
+        uint32_t u = static_cast<uint32_t>(random >> 16) & 0xFFFF;
+        return static_cast<GtoAction>(u < threshold_[bucket] ? bucket : alias_[bucket]);
+    }
+
+    // Every alias names one of the four actions; thresholds are all in range
+    bool valid() const { return (alias_[0] | alias_[1] | alias_[2] | alias_[3]) < 4; }
+
+private:
+    std::array<uint16_t, 4> threshold_{};
+    std::array<uint8_t, 4> alias_{};
+};
+
+// Mixed preflop strategy for every spot, position, depth bucket and hand
+// class, each mix with its sampler ready, 16 bytes a hand. The table is
+// either owned or read straight out of a mapped chart file; a file needs
+// no parsing and no copying, so loading one takes microseconds.
+class PreflopStrategy {
+public:
+    PreflopStrategy();
+    PreflopStrategy(PreflopStrategy&&) = default;
+    PreflopStrategy& operator=(PreflopStrategy&&) = default;
+
+    const ActionMix& mix(PreflopSpot spot, Position pos, DepthBucket depth, int cls) const {
+        return entries_[index(spot, pos, depth, cls)].mix;
+    }
+
+    GtoAction sample(PreflopSpot spot, Position pos, DepthBucket depth, int cls, uint64_t random) const {
+        return entries_[index(spot, pos, depth, cls)].sampler.sample(random);
+    }
+
+    // Copies a mapped table into memory first
+    void set(PreflopSpot spot, Position pos, DepthBucket depth, int cls, const ActionMix& mix);
+
+    // Mixes around the fixed GtoCharts ranges: hands deep inside a range
+    // always play it, hands on its edge mostly do, hands just outside it
+    // sometimes do, and strong hands keep some flats back as traps.
+    // Shallower stacks shove instead of re-raising.
+    static PreflopStrategy builtIn();
+
+    // Builds a strategy from a directory of text charts, one file per spot:
+    // open.txt, vs_raise.txt and vs_3bet.txt. Spots without a file keep the
+    // built-in mixes. Each file is sections of action lines in range
+    // notation (see parseRange()):
+    //   [BTN]                  every depth; "[BTN deep]" for one (short, medium, deep)
+    //   raise: 22+, A2s+, KTo+, T9s:0.5
+    //   call: 76s:0.25
+    // with allin as the fourth action and fold taking what's left. A section
+    // starts its cells over as all-fold, so a later "[BTN short]" refines an
+    // earlier "[BTN]". '#' starts a comment. On error, returns std::nullopt
+    // and says which file and line in `error`.
+    static std::optional<PreflopStrategy> compile(const std::string& dir, std::string& error);
+
+    // A flat binary image of the table, written atomically (tmp + rename) so
+    // a running process can reload it at any moment
+    bool save(const std::string& path) const;
+
+    // Maps a file written by save(). The header, the file length and every
+    // entry are checked first, since the samplers index by what they read:
+    // a truncated or corrupt file gives std::nullopt and the reason in
+    // `error`.
+    static std::optional<PreflopStrategy> load(const std::string& path, std::string& error);
+
+private:
+    struct Entry {
+        ActionMix mix;
+        ActionSampler sampler;
+    };
+
+    static constexpr size_t kNumEntries = static_cast<size_t>(kNumPreflopSpots) * 6 * kNumDepthBuckets * kNumHandClasses;
+
+    // Reads the table in a file load() has checked
+    explicit PreflopStrategy(MappedFile file);
+
+    static size_t index(PreflopSpot spot, Position pos, DepthBucket depth, int cls) {
+        return ((static_cast<size_t>(spot) * 6 + static_cast<size_t>(pos)) * kNumDepthBuckets +
+                static_cast<size_t>(depth)) * kNumHandClasses + cls;
+    }
+
+    const Entry* entries_ = nullptr;    // Into owned_ or file_
+    std::vector<Entry> owned_;
+    MappedFile file_;
+};
+
+} // namespace sharkwave
@@ -0,0 +1,131 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <mutex>
+#include <vector>
+
+namespace sharkwave {
+
+namespace {
+    struct ThreadTable;
+
+    // Live per-thread tables plus totals from threads that have exited
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadTable*> live;
+        PhaseTable retired{};
+        uint64_t startTicks = Profiler::now();
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    };
+
+    Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    void accumulate(PhaseTable& into, const PhaseTable& from) {
+        for (size_t i = 0; i < into.size(); ++i) {
+            into[i].ticks += from[i].ticks;
+            into[i].calls += from[i].calls;
+        }
+    }
+
+    struct ThreadTable {
+        PhaseTable table{};
+
+        ThreadTable() {
+            Registry& r = registry();
+            std::lock_guard lock(r.mutex);
+            r.live.push_back(this);
+        }
+
+        ~ThreadTable() {
+            Registry& r = registry();
+            std::lock_guard lock(r.mutex);
+            accumulate(r.retired, table);
+            r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+        }
+    };
+
+    ThreadTable& threadTable() {
+        thread_local ThreadTable instance;
+        return instance;
+    }
+}
+
+void Profiler::record(ProfilePhase phase, uint64_t ticks) {
+    PhaseTotals& totals = threadTable().table[static_cast<size_t>(phase)];
+    totals.ticks += ticks;
+    totals.calls += 1;
+}
+
+PhaseTable Profiler::snapshot() {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    PhaseTable total = r.retired;
+    for (const ThreadTable* t : r.live) {
+        accumulate(total, t->table);
+    }
+    return total;
+}
+
+void Profiler::reset() {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    r.retired = PhaseTable{};
+    for (ThreadTable* t : r.live) {
+        t->table = PhaseTable{};
+    }
+    r.startTicks = now();
+    r.startTime = std::chrono::steady_clock::now();
+}
+
+double Profiler::ticksPerSecond() {
+    Registry& r = registry();
+    std::lock_guard lock(r.mutex);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - r.startTime).count();
+    if (seconds <= 0.0) return 1.0;
+    return static_cast<double>(now() - r.startTicks) / seconds;
+}
+
+const char* Profiler::phaseName(ProfilePhase phase) {
+    switch (phase) {
+        case ProfilePhase::Shuffle:        return "shuffleDeck";
+        case ProfilePhase::Equity:         return "EquitySampler";
+        case ProfilePhase::Evaluate:       return "evaluate";
+        case ProfilePhase::OpponentAction: return "getOpponentAction";
+        case ProfilePhase::HeroDecision:   return "getHeroDecision";
+        case ProfilePhase::Showdown:       return "settleShowdown";
+        case ProfilePhase::Count:          break;
+    }
+    return "?";
+}
+
+void Profiler::printReport(std::ostream& out, int64_t hands, double seconds) {
+    out << "\n=== PROFILE ===\n";
+    if (seconds > 0.0) {
+        out << std::format("Hands/sec:        {:.0f} ({} hands in {:.2f}s)\n", hands / seconds, hands, seconds);
+    }
+
+    if (!enabled()) {
+        out << "Phase timers are compiled out; rebuild with -DSHARKWAVE_PROFILE=ON for a breakdown.\n\n";
+        return;
+    }
+
+    PhaseTable table = snapshot();
+    double tps = ticksPerSecond();
+
+    out << std::format("\n{:<20}{:>14}{:>12}{:>12}{:>10}\n", "Phase", "Calls", "Total ms", "ns/call", "% run");
+    for (size_t i = 0; i < table.size(); ++i) {
+        const PhaseTotals& p = table[i];
+        double ms = p.ticks / tps * 1e3;
+        double nsPerCall = p.calls ? p.ticks / tps * 1e9 / p.calls : 0.0;
+        double share = seconds > 0.0 ? ms / (seconds * 1e3) * 100.0 : 0.0;
+        out << std::format("{:<20}{:>14}{:>12.1f}{:>12.1f}{:>9.1f}%\n",
+                           phaseName(static_cast<ProfilePhase>(i)), p.calls, ms, nsPerCall, share);
+    }
+    out << "(times are inclusive: EquitySampler contains its evaluate calls, and so on)\n\n";
+}
+
+} // namespace sharkwave
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#if defined(SHARKWAVE_PROFILE) && (defined(__x86_64__) || defined(_M_X64))
+#include <x86intrin.h>
+#define SHARKWAVE_PROFILE_RDTSC 1
+#else
+#include <chrono>
+#endif
+
+namespace sharkwave {
+
+// Phases the simulator spends its time in. Timings are inclusive, so nested
+// phases overlap (EquitySampler::sample includes the evaluate calls it makes).
+enum class ProfilePhase : uint8_t {
+    Shuffle,
+    Equity,
+    Evaluate,
+    OpponentAction,
+    HeroDecision,
+    Showdown,
+    Count
+};
+
+struct PhaseTotals {
+    uint64_t ticks = 0;
+    uint64_t calls = 0;
+};
+
+using PhaseTable = std::array<PhaseTotals, static_cast<size_t>(ProfilePhase::Count)>;
+
+// Per-thread cumulative phase timers. Only does work when built with
+// SHARKWAVE_PROFILE defined (cmake -DSHARKWAVE_PROFILE=ON); otherwise the
+// scope macro expands to nothing and the hot paths are untouched.
+class Profiler {
+public:
+    static constexpr bool enabled() {
+#ifdef SHARKWAVE_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static uint64_t now() {
+#if defined(SHARKWAVE_PROFILE_RDTSC)
+        return __rdtsc();
+#elif defined(SHARKWAVE_PROFILE)
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#else
+        return 0;
+#endif
+    }
+
+    static void record(ProfilePhase phase, uint64_t ticks);
+
+    // Totals summed over every thread that has recorded anything
+    static PhaseTable snapshot();
+    static void reset();
+    static double ticksPerSecond();
+
+    static const char* phaseName(ProfilePhase phase);
+    static void printReport(std::ostream& out, int64_t hands, double seconds);
+};
+
+class ScopedPhaseTimer {
+public:
+    explicit ScopedPhaseTimer(ProfilePhase phase) : phase_(phase), start_(Profiler::now()) {}
+    ~ScopedPhaseTimer() { Profiler::record(phase_, Profiler::now() - start_); }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+    ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+private:
+    ProfilePhase phase_;
+    uint64_t start_;
+};
+
+} // namespace sharkwave
+
+#define SHARKWAVE_PROFILE_CONCAT2(a, b) a##b
+#define SHARKWAVE_PROFILE_CONCAT(a, b) SHARKWAVE_PROFILE_CONCAT2(a, b)
+
+#ifdef SHARKWAVE_PROFILE
+#define SHARKWAVE_PROFILE_SCOPE(phase) \
+    ::sharkwave::ScopedPhaseTimer SHARKWAVE_PROFILE_CONCAT(profileScope_, __LINE__)(::sharkwave::ProfilePhase::phase)
+#else
+#define SHARKWAVE_PROFILE_SCOPE(phase) static_cast<void>(0)
+#endif
@@ -0,0 +1,263 @@
+#include "push_fold.h"
+#include "hand_evaluator.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+
+namespace sharkwave {
+
+namespace {
+    constexpr int N = kNumHandClasses;
+    constexpr std::string_view kHeader = "sharkwave-pushfold 1\n";
+
+    // out = M x, given M transposed: the strategy-weighted sums each best
+    // response needs. Summing whole columns keeps the inner loop free of a
+    // floating-point reduction, so the compiler vectorizes it.
+    void matVec(const std::vector<float>& transposed, const float* x, float* out) {
+        std::fill(out, out + N, 0.0f);
+        for (int j = 0; j < N; ++j) {
+            const float xj = x[j];
+            if (xj == 0.0f) continue;
+            const float* column = transposed.data() + j * N;
+            for (int i = 0; i < N; ++i) out[i] += column[i] * xj;
+        }
+    }
+}
+
+HandClassEquity::HandClassEquity()
+    : equity_(N * N, 0.5f)
+    , combos_(N * N, 0.0f)
+{
+}
+
+HandClassEquity HandClassEquity::compute(int samples, ThreadPool* pool, uint64_t seed) {
+    HandClassEquity result;
+
+    const auto& classes = comboClasses();
+    const auto& masks = comboMasks();
+    std::array<std::vector<CardMask>, N> members;
+    for (int c = 0; c < kNumCombos; ++c) members[classes[c]].push_back(masks[c]);
+
+    for (int a = 0; a < kNumCombos; ++a) {
+        float* row = result.combos_.data() + classes[a] * N;
+        float share = 1.0f / handClassCombos(classes[a]);
+        for (int b = 0; b < kNumCombos; ++b) {
+            if (!(masks[a] & masks[b])) row[classes[b]] += share;
+        }
+    }
+
+    // Row i fills (i, j) and (j, i) for every j > i, so rows never overlap
+    auto fillRow = [&](size_t i) {
+        Rng rng(splitmix64(seed + i));
+        const std::vector<CardMask>& heroes = members[i];
+        for (int j = static_cast<int>(i) + 1; j < N; ++j) {
+            const std::vector<CardMask>& villains = members[j];
+            double won = 0.0;
+            for (int s = 0; s < samples; ++s) {
+                CardMask hands[2];
+                hands[0] = heroes[rng.below(static_cast<uint32_t>(heroes.size()))];
+                do {
+                    hands[1] = villains[rng.below(static_cast<uint32_t>(villains.size()))];
+                } while (hands[0] & hands[1]);
+
+                CardMask dead = hands[0] | hands[1];
+                CardMask board = 0;
+                while (std::popcount(board) < 5) {
+                    CardMask card = CardMask{1} << rng.below(52);
+                    if (!(card & dead)) board |= card;
+                }
+
+                HandResult results[2];
+                HandEvaluator::evaluateShowdown(board, hands, 2, results);
+                won += results[0] > results[1] ? 1.0 : results[0] == results[1] ? 0.5 : 0.0;
+            }
+            float equity = static_cast<float>(won / samples);
+            result.equity_[i * N + j] = equity;
+            result.equity_[j * N + i] = 1.0f - equity;
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, N, fillRow);
+    } else {
+        for (int i = 0; i < N; ++i) fillRow(i);
+    }
+    return result;
+}
+
+PushFoldSolver::PushFoldSolver(const HandClassEquity& equity, const PushFoldConfig& config)
+    : equity_(equity)
+    , config_(config)
+    , first_(6 - std::clamp(config.players, 2, 6))
+{
+    config_.players = 6 - first_;
+    int n = config_.players;
+    shove_.assign(n * N, 0.5f);
+    call_.assign(n * n * N, 0.5f);
+}
+
+int PushFoldSolver::seat(Position pos) const {
+    return static_cast<int>(pos) - first_;
+}
+
+void PushFoldSolver::solve() {
+    const int n = config_.players;
+    const float stack = static_cast<float>(config_.stack);
+
+    std::vector<float> post(n);
+    float dead = 0.0f;
+    for (int s = 0; s < n; ++s) {
+        auto pos = static_cast<Position>(first_ + s);
+        double blind = pos == Position::SB ? 0.5 : pos == Position::BB ? 1.0 : 0.0;
+        post[s] = static_cast<float>(std::min(config_.stack, config_.ante + blind));
+        dead += post[s];
+    }
+
+    // Villain combos per class, and the same weighted by hero's equity;
+    // transposed for matVec, so [villain][hero]
+    std::vector<float> weights(N * N);
+    std::vector<float> weightedEquity(N * N);
+    for (int hero = 0; hero < N; ++hero) {
+        for (int villain = 0; villain < N; ++villain) {
+            float combos = equity_.combos(hero, villain);
+            weights[villain * N + hero] = combos;
+            weightedEquity[villain * N + hero] = combos * equity_(hero, villain);
+        }
+    }
+    const float total = 1225.0f;    // Combos left from 50 cards
+
+    std::vector<float> callMass(N), callEquity(N), shoveMass(N), shoveEquity(N), reach(N), ev(N);
+    std::vector<float> bestShove(n * N), bestCall(n * n * N);
+
+    for (int t = 1; t <= config_.iterations; ++t) {
+        for (int a = 0; a + 1 < n; ++a) {
+            // Shover: folded to, facing everyone behind
+            std::fill(reach.begin(), reach.end(), 1.0f);
+            std::fill(ev.begin(), ev.end(), 0.0f);
+            for (int b = a + 1; b < n; ++b) {
+                const float* call = call_.data() + (a * n + b) * N;
+                matVec(weights, call, callMass.data());
+                matVec(weightedEquity, call, callEquity.data());
+                float pot = 2.0f * stack + dead - post[a] - post[b];
+                for (int i = 0; i < N; ++i) {
+                    float calls = callMass[i] / total;
+                    ev[i] += reach[i] * (callEquity[i] / total * pot - calls * stack);
+                    reach[i] *= 1.0f - calls;
+                }
+            }
+            for (int i = 0; i < N; ++i) {
+                ev[i] += reach[i] * (dead - post[a]);
+                bestShove[a * N + i] = ev[i] > -post[a] ? 1.0f : 0.0f;
+            }
+
+            // Each player behind, when everyone between folded
+            const float* shove = shove_.data() + a * N;
+            matVec(weights, shove, shoveMass.data());
+            matVec(weightedEquity, shove, shoveEquity.data());
+            for (int b = a + 1; b < n; ++b) {
+                float pot = 2.0f * stack + dead - post[a] - post[b];
+                float* best = bestCall.data() + (a * n + b) * N;
+                for (int j = 0; j < N; ++j) {
+                    bool call = shoveMass[j] > 0.0f && shoveEquity[j] / shoveMass[j] * pot - stack > -post[b];
+                    best[j] = call ? 1.0f : 0.0f;
+                }
+            }
+        }
+
+        float step = 1.0f / t;
+        for (size_t k = 0; k < shove_.size(); ++k) shove_[k] += (bestShove[k] - shove_[k]) * step;
+        for (size_t k = 0; k < call_.size(); ++k) call_[k] += (bestCall[k] - call_[k]) * step;
+    }
+}
+
+double PushFoldSolver::shoveFrequency(Position pos, int cls) const {
+    int s = seat(pos);
+    if (s < 0 || s + 1 >= config_.players) return 0.0;
+    return shove_[s * N + cls];
+}
+
+double PushFoldSolver::callFrequency(Position shover, Position caller, int cls) const {
+    int a = seat(shover);
+    int b = seat(caller);
+    if (a < 0 || b <= a || b >= config_.players) return 0.0;
+    return call_[(a * config_.players + b) * N + cls];
+}
+
+PushFoldChart PushFoldSolver::chart() const {
+    PushFoldChart chart;
+    for (int a = 0; a < 6; ++a) {
+        auto shover = static_cast<Position>(a);
+        for (int cls = 0; cls < N; ++cls) {
+            if (shoveFrequency(shover, cls) >= 0.5) chart.shove[a].set(cls);
+            for (int b = a + 1; b < 6; ++b) {
+                if (callFrequency(shover, static_cast<Position>(b), cls) >= 0.5) chart.call[a][b].set(cls);
+            }
+        }
+    }
+    return chart;
+}
+
+PushFoldTables PushFoldTables::solve(const HandClassEquity& equity, double ante, int iterations,
+                                     ThreadPool* pool) {
+    PushFoldTables tables;
+    tables.ante_ = ante;
+
+    auto solveOne = [&](size_t job) {
+        PushFoldConfig config;
+        config.players = job < kMaxStack ? 2 : 6;
+        config.stack = static_cast<double>(job % kMaxStack + 1);
+        config.ante = ante;
+        config.iterations = iterations;
+
+        PushFoldSolver solver(equity, config);
+        solver.solve();
+        tables.charts_[job / kMaxStack][job % kMaxStack] = solver.chart();
+    };
+
+    if (pool) {
+        pool->parallelFor(0, 2 * kMaxStack, solveOne);
+    } else {
+        for (size_t job = 0; job < 2 * kMaxStack; ++job) solveOne(job);
+    }
+    return tables;
+}
+
+const PushFoldChart& PushFoldTables::find(int players, int stack) const {
+    return charts_[players <= 2 ? 0 : 1][std::clamp(stack, 1, kMaxStack) - 1];
+}
+
+bool PushFoldTables::save(const std::string& path) const {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(kHeader.data(), static_cast<std::streamsize>(kHeader.size()));
+        out.write(reinterpret_cast<const char*>(&ante_), sizeof(ante_));
+        out.write(reinterpret_cast<const char*>(&charts_), sizeof(charts_));
+        out.flush();
+        if (!out) return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+std::optional<PushFoldTables> PushFoldTables::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string header(kHeader.size(), '\0');
+    if (!in || !in.read(header.data(), static_cast<std::streamsize>(header.size())) || header != kHeader) {
+        return std::nullopt;
+    }
+
+    PushFoldTables tables;
+    in.read(reinterpret_cast<char*>(&tables.ante_), sizeof(tables.ante_));
+    in.read(reinterpret_cast<char*>(&tables.charts_), sizeof(tables.charts_));
+    if (!in || in.peek() != std::ifstream::traits_type::eof()) return std::nullopt;
+    return tables;
+}
+
+} // namespace sharkwave
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "card.h"
+#include "game_session.h"
+#include "range.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sharkwave {
+
+class ThreadPool;
+
+// All-in preflop equity of every hand class against every other, averaged
+// over the combo pairs that don't share a card
+class HandClassEquity {
+public:
+    // Monte Carlo with `samples` deals per pair of classes
+    static HandClassEquity compute(int samples, ThreadPool* pool = nullptr, uint64_t seed = 1);
+
+    float operator()(int hero, int villain) const { return equity_[hero * kNumHandClasses + villain]; }
+
+    // Combos of `villain` still possible once a hand of `hero` is dealt,
+    // averaged over hero's combos (they sum to 1225 over all villains)
+    float combos(int hero, int villain) const { return combos_[hero * kNumHandClasses + villain]; }
+
+private:
+    HandClassEquity();
+
+    std::vector<float> equity_;
+    std::vector<float> combos_;
+};
+
+struct PushFoldConfig {
+    int players = 2;            // 2 (heads-up) to 6
+    double stack = 10.0;        // Effective stack in big blinds, blinds included
+    double ante = 0.0;          // Per player, in big blinds
+    int iterations = 2000;
+};
+
+// Shove and call ranges at one stack depth, one bit per hand class. Seats
+// are named as at a 6-max table; heads-up is SB (the button) against BB.
+struct PushFoldChart {
+    std::array<HandClassSet, 6> shove;                  // By shover, when folded to
+    std::array<std::array<HandClassSet, 6>, 6> call;    // [shover][caller]
+
+    bool shouldShove(Position pos, Card c1, Card c2) const {
+        return shove[static_cast<int>(pos)].test(handClass(c1, c2));
+    }
+    bool shouldCall(Position shover, Position caller, Card c1, Card c2) const {
+        return call[static_cast<int>(shover)][static_cast<int>(caller)].test(handClass(c1, c2));
+    }
+};
+
+// Chip-EV push/fold equilibrium by fictitious play: each round every
+// decision best-responds to the others' average strategies so far, and the
+// averages converge to a Nash equilibrium. The first player to shove is
+// called by at most one player (the first behind who wants to); overcalls
+// are left out of the model.
+class PushFoldSolver {
+public:
+    PushFoldSolver(const HandClassEquity& equity, const PushFoldConfig& config);
+
+    void solve();
+
+    // Average strategies, 0..1
+    double shoveFrequency(Position pos, int cls) const;
+    double callFrequency(Position shover, Position caller, int cls) const;
+
+    // Hands played at least half the time
+    PushFoldChart chart() const;
+
+private:
+    int seat(Position pos) const;
+
+    const HandClassEquity& equity_;
+    PushFoldConfig config_;
+    int first_;                         // Position of the first seat dealt in
+
+    std::vector<float> shove_;          // [seat][class]
+    std::vector<float> call_;           // [shover][caller][class]
+};
+
+// Charts for every whole stack depth from 1 to kMaxStack big blinds,
+// heads-up and 6-max, at one ante. About 50 KB as a flat binary file, and a
+// lookup is an array index plus a bit test.
+class PushFoldTables {
+public:
+    static constexpr int kMaxStack = 25;
+
+    PushFoldTables() = default;
+
+    static PushFoldTables solve(const HandClassEquity& equity, double ante, int iterations,
+                                ThreadPool* pool = nullptr);
+
+    double ante() const { return ante_; }
+
+    // Heads-up for 2 players, 6-max otherwise; stacks are clamped into range
+    const PushFoldChart& find(int players, int stack) const;
+
+    bool save(const std::string& path) const;
+    static std::optional<PushFoldTables> load(const std::string& path);
+
+private:
+    double ante_ = 0.0;
+    std::array<std::array<PushFoldChart, kMaxStack>, 2> charts_{};  // [6-max?][stack - 1]
+};
+
+} // namespace sharkwave
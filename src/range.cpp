@@ -0,0 +1,190 @@
+#include "range.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+
+namespace sharkwave {
+
+namespace {
+    struct ComboTables {
+        std::array<ComboCards, kNumCombos> cards;
+        std::array<CardMask, kNumCombos> masks;
+        std::array<uint8_t, kNumCombos> classes;
+
+        ComboTables() {
+            for (int hi = 1; hi < 52; ++hi) {
+                for (int lo = 0; lo < hi; ++lo) {
+                    int i = comboIndex(hi, lo);
+                    cards[i] = {static_cast<uint8_t>(hi), static_cast<uint8_t>(lo)};
+                    masks[i] = (CardMask{1} << hi) | (CardMask{1} << lo);
+                    classes[i] = static_cast<uint8_t>(handClass(cardFromIndex(hi), cardFromIndex(lo)));
+                }
+            }
+        }
+    };
+
+    const ComboTables& tables() {
+        static const ComboTables instance;
+        return instance;
+    }
+
+    // Grid row/column of a rank character: 0 for aces through 12 for deuces
+    int gridIndex(char c) {
+        static constexpr std::string_view kRanks = "AKQJT98765432";
+        size_t i = kRanks.find(static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+        return i == std::string_view::npos ? -1 : static_cast<int>(i);
+    }
+
+    std::string_view trim(std::string_view s) {
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+        while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+        return s;
+    }
+
+    // One hand without weight or range suffix: "QQ", "AKs", "AK"
+    struct HandToken {
+        int high;           // Grid index of the higher rank
+        int low;
+        bool suited;
+        bool offsuit;
+
+        bool pair() const { return high == low; }
+    };
+
+    std::optional<HandToken> parseHand(std::string_view s) {
+        if (s.size() < 2 || s.size() > 3) return std::nullopt;
+        int a = gridIndex(s[0]);
+        int b = gridIndex(s[1]);
+        if (a < 0 || b < 0) return std::nullopt;
+
+        HandToken hand{std::min(a, b), std::max(a, b), true, true};
+        if (s.size() == 3) {
+            char shape = static_cast<char>(std::tolower(static_cast<unsigned char>(s[2])));
+            if (hand.pair() || (shape != 's' && shape != 'o')) return std::nullopt;
+            hand.suited = shape == 's';
+            hand.offsuit = shape == 'o';
+        }
+        return hand;
+    }
+
+    void setHand(ClassWeights& weights, int high, int low, const HandToken& shape, float weight) {
+        if (high == low) {
+            weights[high * 13 + high] = weight;
+            return;
+        }
+        if (shape.suited) weights[high * 13 + low] = weight;
+        if (shape.offsuit) weights[low * 13 + high] = weight;
+    }
+}
+
+const std::array<ComboCards, kNumCombos>& comboCards() {
+    return tables().cards;
+}
+
+const std::array<CardMask, kNumCombos>& comboMasks() {
+    return tables().masks;
+}
+
+const std::array<uint8_t, kNumCombos>& comboClasses() {
+    return tables().classes;
+}
+
+std::string handClassName(int cls) {
+    static constexpr char kRanks[] = "AKQJT98765432";
+    int row = cls / 13;
+    int col = cls % 13;
+    std::string name;
+    name += kRanks[std::min(row, col)];
+    name += kRanks[std::max(row, col)];
+    if (row != col) name += row < col ? 's' : 'o';
+    return name;
+}
+
+std::optional<ClassWeights> parseRange(std::string_view text, std::string& error) {
+    ClassWeights weights{};
+    while (!text.empty()) {
+        size_t comma = text.find(',');
+        std::string_view item = trim(text.substr(0, comma));
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+        if (item.empty()) continue;
+
+        float weight = 1.0f;
+        std::string_view hands = item;
+        if (size_t colon = item.find(':'); colon != std::string_view::npos) {
+            std::string_view w = trim(item.substr(colon + 1));
+            auto [end, ec] = std::from_chars(w.data(), w.data() + w.size(), weight);
+            if (ec != std::errc{} || end != w.data() + w.size() || weight < 0.0f || weight > 1.0f) {
+                error = "bad weight in \"" + std::string(item) + "\"";
+                return std::nullopt;
+            }
+            hands = trim(item.substr(0, colon));
+        }
+
+        bool plus = !hands.empty() && hands.back() == '+';
+        if (plus) hands.remove_suffix(1);
+        size_t dash = hands.find('-');
+        std::optional<HandToken> first = parseHand(trim(hands.substr(0, dash)));
+        std::optional<HandToken> last = first;
+        if (dash != std::string_view::npos) last = parseHand(trim(hands.substr(dash + 1)));
+
+        bool sameKind = first && last && first->pair() == last->pair() &&
+                        first->suited == last->suited && first->offsuit == last->offsuit &&
+                        (first->pair() || first->high == last->high);
+        if (!sameKind || (plus && dash != std::string_view::npos)) {
+            error = "bad hand \"" + std::string(item) + "\"";
+            return std::nullopt;
+        }
+
+        if (first->pair()) {
+            // Pairs run along the diagonal: up to aces for "+", else between the two
+            int from = plus ? 0 : std::min(first->high, last->high);
+            int to = plus ? first->high : std::max(first->high, last->high);
+            for (int r = from; r <= to; ++r) setHand(weights, r, r, *first, weight);
+        } else {
+            // Kickers under one top card: up to one below it for "+"
+            int from = plus ? first->high + 1 : std::min(first->low, last->low);
+            int to = plus ? first->low : std::max(first->low, last->low);
+            for (int k = from; k <= to; ++k) setHand(weights, first->high, k, *first, weight);
+        }
+    }
+    return weights;
+}
+
+Range Range::fromClasses(const ClassWeights& weights) {
+    const auto& classes = comboClasses();
+    Range range;
+    for (int i = 0; i < kNumCombos; ++i) range.weights_[i] = weights[classes[i]];
+    return range;
+}
+
+Range Range::fromClasses(const HandClassSet& classes) {
+    ClassWeights weights{};
+    for (int cls = 0; cls < kNumHandClasses; ++cls) weights[cls] = classes.test(cls) ? 1.0f : 0.0f;
+    return fromClasses(weights);
+}
+
+void Range::multiply(const std::array<float, kNumCombos>& likelihood) {
+    for (int i = 0; i < kNumCombos; ++i) {
+        weights_[i] *= likelihood[i];
+    }
+}
+
+void Range::removeCards(CardMask dead) {
+    // A card is in 51 combos; zeroing just those beats a pass over all 1326
+    // until a good part of the deck is dead
+    for (CardMask rest = dead; rest; rest &= rest - 1) {
+        int card = std::countr_zero(rest);
+        for (int other = 0; other < 52; ++other) {
+            if (other != card) weights_[comboIndex(card, other)] = 0.0f;
+        }
+    }
+}
+
+float Range::total() const {
+    float sum = 0.0f;
+    for (float w : weights_) sum += w;
+    return sum;
+}
+
+} // namespace sharkwave
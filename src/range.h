@@ -0,0 +1,148 @@
+#pragma once
+
+#include "card.h"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace sharkwave {
+
+// The 1326 two-card combos, numbered by the cardIndex() of their cards:
+// combo(hi, lo) with hi > lo lives at hi * (hi - 1) / 2 + lo.
+constexpr int kNumCombos = 1326;
+
+constexpr int comboIndex(int cardA, int cardB) {
+    int hi = cardA > cardB ? cardA : cardB;
+    int lo = cardA > cardB ? cardB : cardA;
+    return hi * (hi - 1) / 2 + lo;
+}
+
+struct ComboCards {
+    uint8_t hi;
+    uint8_t lo;
+};
+
+// Cards of every combo, and each combo's CardMask, by combo index
+const std::array<ComboCards, kNumCombos>& comboCards();
+const std::array<CardMask, kNumCombos>& comboMasks();
+
+// The 169 starting-hand classes, numbered row * 13 + column on the usual
+// grid with aces first: pairs on the diagonal, suited hands above it (the
+// higher rank picks the row), offsuit below it (the lower rank does)
+constexpr int kNumHandClasses = 169;
+
+constexpr int handClass(Card a, Card b) {
+    int r1 = 14 - static_cast<int>(a.rank());
+    int r2 = 14 - static_cast<int>(b.rank());
+    int high = r1 < r2 ? r1 : r2;
+    int low = r1 < r2 ? r2 : r1;
+    return a.suit() == b.suit() ? high * 13 + low : low * 13 + high;
+}
+
+// 6 combos for a pair, 4 suited, 12 offsuit
+constexpr int handClassCombos(int cls) {
+    int row = cls / 13;
+    int col = cls % 13;
+    return row == col ? 6 : row < col ? 4 : 12;
+}
+
+// Class of every combo, by combo index
+const std::array<uint8_t, kNumCombos>& comboClasses();
+
+// "AA", "AKs", "72o"
+std::string handClassName(int cls);
+
+// A weight from 0 to 1 per hand class
+using ClassWeights = std::array<float, kNumHandClasses>;
+
+// Parses range notation: a comma-separated list of
+//   QQ, AKs, T9o, AK          one class, or both shapes of an unpaired hand
+//   22+, A2s+, KTo+           pairs up to aces, or kickers up to one below the top card
+//   99-66, A5s-A2s            a span of pairs, or of kickers under one top card
+// each with an optional ":weight" ("T9s:0.5"); a weight of 1 otherwise.
+// Classes not listed get 0, and a class listed twice keeps the later
+// weight. On bad input, returns std::nullopt and says why in `error`.
+std::optional<ClassWeights> parseRange(std::string_view text, std::string& error);
+
+// A set of hand classes, one bit each. Set operations and counts work a
+// word at a time.
+struct HandClassSet {
+    std::array<uint64_t, 3> words{};
+
+    constexpr bool test(int cls) const { return (words[cls >> 6] >> (cls & 63)) & 1; }
+    constexpr void set(int cls) { words[cls >> 6] |= uint64_t{1} << (cls & 63); }
+    constexpr bool operator==(const HandClassSet&) const = default;
+
+    constexpr HandClassSet operator|(const HandClassSet& other) const {
+        return {{words[0] | other.words[0], words[1] | other.words[1], words[2] | other.words[2]}};
+    }
+    constexpr HandClassSet operator&(const HandClassSet& other) const {
+        return {{words[0] & other.words[0], words[1] & other.words[1], words[2] & other.words[2]}};
+    }
+    // Classes in this set but not in `other`
+    constexpr HandClassSet without(const HandClassSet& other) const {
+        return {{words[0] & ~other.words[0], words[1] & ~other.words[1], words[2] & ~other.words[2]}};
+    }
+
+    constexpr int count() const {
+        return std::popcount(words[0]) + std::popcount(words[1]) + std::popcount(words[2]);
+    }
+
+    // Combos covered, of the 1326
+    constexpr int combos() const;
+};
+
+// Every class with `combos` combos: pairs (6), suited (4) or offsuit (12)
+constexpr HandClassSet classesOfShape(int combos) {
+    HandClassSet set;
+    for (int cls = 0; cls < kNumHandClasses; ++cls) {
+        if (handClassCombos(cls) == combos) set.set(cls);
+    }
+    return set;
+}
+
+inline constexpr HandClassSet kPairClasses = classesOfShape(6);
+inline constexpr HandClassSet kSuitedClasses = classesOfShape(4);
+inline constexpr HandClassSet kOffsuitClasses = classesOfShape(12);
+
+constexpr int HandClassSet::combos() const {
+    return 6 * (*this & kPairClasses).count() + 4 * (*this & kSuitedClasses).count() +
+           12 * (*this & kOffsuitClasses).count();
+}
+
+// A weight per combo: how likely a player is to hold it, up to a constant.
+// Stored as a flat float array so every update is a straight loop the
+// compiler vectorizes.
+class Range {
+public:
+    Range() { weights_.fill(1.0f); }
+
+    // Every combo of a class at the class's weight
+    static Range fromClasses(const ClassWeights& weights);
+    static Range fromClasses(const HandClassSet& classes);
+
+    float operator[](int combo) const { return weights_[combo]; }
+    float& operator[](int combo) { return weights_[combo]; }
+    const float* data() const { return weights_.data(); }
+
+    void fill(float weight) { weights_.fill(weight); }
+
+    // Bayesian update: weight *= P(observation | combo)
+    void multiply(const std::array<float, kNumCombos>& likelihood);
+
+    // Zero every combo holding one of `dead`
+    void removeCards(CardMask dead);
+
+    float total() const;
+
+    // Share of the 1326 combos' weight still left (1 = untouched, full range)
+    double fraction() const { return total() / kNumCombos; }
+
+private:
+    alignas(64) std::array<float, kNumCombos> weights_;
+};
+
+} // namespace sharkwave
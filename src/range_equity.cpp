@@ -0,0 +1,213 @@
+#include "range_equity.h"
+#include "hand_evaluator.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace sharkwave {
+
+namespace {
+    // Runouts are split into this many chunks whatever the pool size, so
+    // the seeds and the order sums are added in never change
+    constexpr int64_t kChunks = 64;
+
+    // Every combo either range holds, with what a runout needs of each
+    struct Candidates {
+        std::vector<CardMask> masks;
+        std::vector<uint8_t> card1;
+        std::vector<uint8_t> card2;
+        std::vector<float> weightA;
+        std::vector<float> weightB;
+        std::vector<uint8_t> classes;
+    };
+
+    // Per candidate, summed over runouts: B's weight it beats (ties count
+    // half), and B's weight it doesn't conflict with
+    struct Tally {
+        std::vector<double> won;
+        std::vector<double> faced;
+    };
+
+    // Reused from one runout to the next
+    struct Scratch {
+        std::vector<CardMask> masks;
+        std::vector<uint16_t> live;
+        std::vector<HandResult> results;
+        std::vector<uint64_t> order;
+    };
+
+    void scoreRunout(const Candidates& c, CardMask board, Scratch& s, Tally& tally) {
+        s.masks.clear();
+        s.live.clear();
+        double total = 0.0;
+        double totalCard[52] = {};
+        for (size_t i = 0; i < c.masks.size(); ++i) {
+            if (c.masks[i] & board) continue;
+            s.masks.push_back(c.masks[i]);
+            s.live.push_back(static_cast<uint16_t>(i));
+            total += c.weightB[i];
+            totalCard[c.card1[i]] += c.weightB[i];
+            totalCard[c.card2[i]] += c.weightB[i];
+        }
+
+        // Each combo evaluated once, then sorted weakest first
+        const size_t n = s.live.size();
+        s.results.resize(n);
+        s.order.resize(n);
+        HandEvaluator::evaluateShowdown(board, s.masks.data(), n, s.results.data());
+        for (size_t j = 0; j < n; ++j) s.order[j] = (s.results[j].key() << 11) | j;
+        std::sort(s.order.begin(), s.order.end());
+
+        // One pass up the ranking: B's weight below each group, and within it
+        double below = 0.0;
+        double belowCard[52] = {};
+        double tiedCard[52] = {};
+        for (size_t start = 0; start < n;) {
+            size_t end = start + 1;
+            while (end < n && (s.order[end] >> 11) == (s.order[start] >> 11)) ++end;
+
+            double tied = 0.0;
+            for (size_t k = start; k < end; ++k) {
+                int i = s.live[s.order[k] & 0x7ff];
+                tied += c.weightB[i];
+                tiedCard[c.card1[i]] += c.weightB[i];
+                tiedCard[c.card2[i]] += c.weightB[i];
+            }
+            for (size_t k = start; k < end; ++k) {
+                int i = s.live[s.order[k] & 0x7ff];
+                if (c.weightA[i] == 0.0f) continue;
+                int h = c.card1[i], l = c.card2[i];
+                // A combo sharing cards with this one is dropped; this one
+                // itself was taken out twice, once per card
+                double faced = total - totalCard[h] - totalCard[l] + c.weightB[i];
+                double weaker = below - belowCard[h] - belowCard[l];
+                double equal = tied - tiedCard[h] - tiedCard[l] + c.weightB[i];
+                tally.won[i] += weaker + 0.5 * equal;
+                tally.faced[i] += faced;
+            }
+            for (size_t k = start; k < end; ++k) {
+                int i = s.live[s.order[k] & 0x7ff];
+                below += c.weightB[i];
+                belowCard[c.card1[i]] += c.weightB[i];
+                belowCard[c.card2[i]] += c.weightB[i];
+                tiedCard[c.card1[i]] = 0.0;
+                tiedCard[c.card2[i]] = 0.0;
+            }
+            start = end;
+        }
+    }
+
+    // Number of ways to choose k of n, saturating well above any budget
+    int64_t choose(int n, int k) {
+        int64_t ways = 1;
+        for (int i = 0; i < k; ++i) {
+            ways = ways * (n - i) / (i + 1);
+            if (ways > (int64_t{1} << 40)) break;
+        }
+        return ways;
+    }
+
+    // Every way to add `need` of `deck` to `board`
+    void enumerateRunouts(const std::vector<int>& deck, int need, size_t from, CardMask board,
+                          std::vector<CardMask>& out) {
+        if (need == 0) {
+            out.push_back(board);
+            return;
+        }
+        for (size_t i = from; i + need <= deck.size(); ++i) {
+            enumerateRunouts(deck, need - 1, i + 1, board | (CardMask{1} << deck[i]), out);
+        }
+    }
+}
+
+RangeEquity rangeVsRange(const Range& a, const Range& b, CardMask board,
+                         const RangeEquityConfig& config, ThreadPool* pool) {
+    const auto& masks = comboMasks();
+    const auto& cards = comboCards();
+    const auto& classes = comboClasses();
+
+    Candidates candidates;
+    for (int combo = 0; combo < kNumCombos; ++combo) {
+        if ((a[combo] <= 0.0f && b[combo] <= 0.0f) || (masks[combo] & board)) continue;
+        candidates.masks.push_back(masks[combo]);
+        candidates.card1.push_back(cards[combo].hi);
+        candidates.card2.push_back(cards[combo].lo);
+        candidates.weightA.push_back(std::max(a[combo], 0.0f));
+        candidates.weightB.push_back(std::max(b[combo], 0.0f));
+        candidates.classes.push_back(classes[combo]);
+    }
+
+    std::vector<int> deck;
+    for (int card = 0; card < 52; ++card) {
+        if (!(board & (CardMask{1} << card))) deck.push_back(card);
+    }
+    const int need = std::max(0, 5 - std::popcount(board));
+
+    RangeEquity result;
+    result.exact = choose(static_cast<int>(deck.size()), need) <= config.maxExactBoards;
+    std::vector<CardMask> runouts;
+    if (result.exact) enumerateRunouts(deck, need, 0, board, runouts);
+    result.boards = result.exact ? static_cast<int64_t>(runouts.size()) : std::max<int64_t>(config.samples, 1);
+
+    const int64_t chunks = std::min(kChunks, result.boards);
+    std::vector<Tally> tallies(chunks);
+    auto runChunk = [&](size_t chunk) {
+        Tally& tally = tallies[chunk];
+        tally.won.assign(candidates.masks.size(), 0.0);
+        tally.faced.assign(candidates.masks.size(), 0.0);
+        Scratch scratch;
+
+        int64_t begin = result.boards * static_cast<int64_t>(chunk) / chunks;
+        int64_t end = result.boards * static_cast<int64_t>(chunk + 1) / chunks;
+        if (result.exact) {
+            for (int64_t r = begin; r < end; ++r) scoreRunout(candidates, runouts[r], scratch, tally);
+            return;
+        }
+
+        Rng rng(splitmix64(config.seed + chunk));
+        std::vector<int> shuffled = deck;
+        for (int64_t r = begin; r < end; ++r) {
+            CardMask runout = board;
+            for (int k = 0; k < need; ++k) {
+                uint32_t pick = k + rng.below(static_cast<uint32_t>(shuffled.size() - k));
+                std::swap(shuffled[k], shuffled[pick]);
+                runout |= CardMask{1} << shuffled[k];
+            }
+            scoreRunout(candidates, runout, scratch, tally);
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, static_cast<size_t>(chunks), runChunk);
+    } else {
+        for (int64_t chunk = 0; chunk < chunks; ++chunk) runChunk(static_cast<size_t>(chunk));
+    }
+
+    // Chunks in order, then A's weight on each combo
+    std::array<double, kNumHandClasses> won{};
+    std::array<double, kNumHandClasses> faced{};
+    for (size_t i = 0; i < candidates.masks.size(); ++i) {
+        double sumWon = 0.0, sumFaced = 0.0;
+        for (const Tally& tally : tallies) {
+            sumWon += tally.won[i];
+            sumFaced += tally.faced[i];
+        }
+        won[candidates.classes[i]] += candidates.weightA[i] * sumWon;
+        faced[candidates.classes[i]] += candidates.weightA[i] * sumFaced;
+    }
+
+    double totalWon = 0.0, totalFaced = 0.0;
+    for (int cls = 0; cls < kNumHandClasses; ++cls) {
+        totalWon += won[cls];
+        totalFaced += faced[cls];
+        result.classEquity[cls] = faced[cls] > 0.0 ? won[cls] / faced[cls] : -1.0;
+        result.classMatchups[cls] = faced[cls] / result.boards;
+    }
+    result.equity = totalFaced > 0.0 ? totalWon / totalFaced : 0.0;
+    result.matchups = totalFaced / result.boards;
+    return result;
+}
+
+} // namespace sharkwave
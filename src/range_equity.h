@@ -0,0 +1,40 @@
+#pragma once
+
+#include "card.h"
+#include "range.h"
+#include <array>
+#include <cstdint>
+
+namespace sharkwave {
+
+class ThreadPool;
+
+struct RangeEquityConfig {
+    int64_t maxExactBoards = 50000; // Enumerate every runout when there are at most this many
+    int64_t samples = 20000;        // Otherwise deal this many random runouts
+    uint64_t seed = 1;
+};
+
+// How range A does against range B, overall and for each of A's hand
+// classes. Every pair of combos that share no card counts in proportion to
+// the product of their weights.
+struct RangeEquity {
+    double equity = 0.0;        // A's share of the pot
+    double matchups = 0.0;      // Weight of the non-conflicting pairs
+    std::array<double, kNumHandClasses> classEquity{};  // -1 where A has no live combo
+    std::array<double, kNumHandClasses> classMatchups{};
+    int64_t boards = 0;         // Runouts evaluated
+    bool exact = false;
+};
+
+// Equity of A against B on `board` (0 to 5 cards). Works a runout at a
+// time: each live combo of either range is evaluated once on the runout,
+// and one pass over the combos in hand-strength order, with per-card sums
+// for card removal, scores every pair, so a runout costs O(n log n) for n
+// combos instead of O(n^2). Runouts are split across the pool in fixed
+// chunks, each with its own seed, so results don't depend on the thread
+// count. A full preflop range against a full range takes a few seconds.
+RangeEquity rangeVsRange(const Range& a, const Range& b, CardMask board,
+                         const RangeEquityConfig& config = {}, ThreadPool* pool = nullptr);
+
+} // namespace sharkwave
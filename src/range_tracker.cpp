@@ -0,0 +1,313 @@
+#include "range_tracker.h"
+#include "gto_charts.h"
+#include "hand_evaluator.h"
+#include <algorithm>
+#include <bit>
+
+namespace sharkwave {
+
+namespace {
+    // Weight left on hands a chart says never take the action, so a player
+    // who strays from the charts is narrowed but never ruled out
+    constexpr float kOffChart = 0.05f;
+
+    // Share of in-chart hands that flat instead of re-raising
+    constexpr float kTrapFrequency = 0.25f;
+
+    int boardCards(Street street) {
+        switch (street) {
+            case Street::Preflop: return 0;
+            case Street::Flop:    return 3;
+            case Street::Turn:    return 4;
+            default:              return 5;
+        }
+    }
+
+    // What rankCombos needs of a combo besides its cards
+    struct ComboShape {
+        uint8_t rankPair;       // The same for every combo of its two ranks, 0 .. 90
+        bool suited;
+    };
+
+    const std::array<ComboShape, kNumCombos>& comboShapes() {
+        static const auto shapes = [] {
+            std::array<ComboShape, kNumCombos> table{};
+            const auto& cards = comboCards();
+            for (int i = 0; i < kNumCombos; ++i) {
+                int high = std::max(cards[i].hi % 13, cards[i].lo % 13);
+                int low = std::min(cards[i].hi % 13, cards[i].lo % 13);
+                table[i].rankPair = static_cast<uint8_t>(high * (high + 1) / 2 + low);
+                table[i].suited = cards[i].hi / 13 == cards[i].lo / 13;
+            }
+            return table;
+        }();
+        return shapes;
+    }
+
+    // The part of the board that was out when an action on `street` happened
+    CardMask boardAt(const CardSet& board, Street street) {
+        CardMask mask = 0;
+        size_t count = std::min(board.count, static_cast<size_t>(boardCards(street)));
+        for (size_t i = 0; i < count; ++i) mask |= cardBit(board.cards[i]);
+        return mask;
+    }
+}
+
+RangeTracker::RangeTracker()
+    : folded_{}
+    , narrowing_(true)
+    , handId_(0)
+    , applied_(0)
+    , hero_(Position::UTG)
+    , preflopRaises_(0)
+    , removedBoard_(0)
+    , strengthBoard_(0)
+    , strength_{}
+    , likelihood_{}
+{
+}
+
+void RangeTracker::setNarrowing(bool on) {
+    if (on == narrowing_) return;
+    narrowing_ = on;
+    // Start the hand over under the new mode; the next update replays it
+    for (Range& range : ranges_) range.fill(1.0f);
+    reset(handId_);
+}
+
+void RangeTracker::reset(uint32_t handId) {
+    if (narrowing_) {
+        for (Range& range : ranges_) range.fill(1.0f);
+    }
+    folded_.fill(false);
+    handId_ = handId;
+    applied_ = 0;
+    preflopRaises_ = 0;
+    removedBoard_ = 0;
+    lastAggressor_.reset();
+    lastActor_.reset();
+}
+
+void RangeTracker::update(const GameSession& session) {
+    const ActionLog& actions = session.actions();
+    if (session.handId() != handId_ || actions.size() < applied_) reset(session.handId());
+    hero_ = session.heroPosition();
+
+    CardSet board = session.board();
+    for (const ActionRecord& record : actions.since(applied_)) {
+        apply(record, boardAt(board, record.street()));
+    }
+    applied_ = actions.size();
+
+    // Cards on the board can't be in anyone's hand
+    CardMask boardMask = board.mask();
+    if (narrowing_ && boardMask != removedBoard_) {
+        for (Range& range : ranges_) range.removeCards(boardMask & ~removedBoard_);
+        removedBoard_ = boardMask;
+    }
+}
+
+std::optional<Position> RangeTracker::mainOpponent() const {
+    if (lastAggressor_ && !folded(*lastAggressor_)) return lastAggressor_;
+    if (lastActor_ && !folded(*lastActor_)) return lastActor_;
+    return std::nullopt;
+}
+
+void RangeTracker::apply(const ActionRecord& record, CardMask board) {
+    bool aggressive = record.aggressive();
+    bool opponent = record.position() != hero_;
+
+    Range& range = ranges_[static_cast<int>(record.position())];
+    if (record.action() == Action::Fold) {
+        folded_[static_cast<int>(record.position())] = true;
+    } else if (!narrowing_) {
+        // Ranges stay any two cards
+    } else if (record.street() == Street::Preflop) {
+        if (record.action() != Action::Check) {
+            range.multiply(preflopLikelihood(record.position(), record.action(), preflopRaises_));
+        }
+    } else {
+        postflopLikelihood(record.action(), board);
+        range.multiply(likelihood_);
+    }
+
+    if (opponent) {
+        if (aggressive) lastAggressor_ = record.position();
+        lastActor_ = record.position();
+    }
+    if (record.street() == Street::Preflop && aggressive) preflopRaises_++;
+}
+
+const std::array<float, kNumCombos>& RangeTracker::preflopLikelihood(Position pos, Action action, int raises) {
+    // Charts never change, so every (position, raises so far, raise or not)
+    // table is built once and updates are a single multiply
+    struct Tables {
+        std::array<float, kNumCombos> likelihood[6][3][2];
+
+        Tables() {
+            for (int p = 0; p < 6; ++p) {
+                for (int level = 0; level < 3; ++level) {
+                    fill(likelihood[p][level][0], static_cast<Position>(p), false, level);
+                    fill(likelihood[p][level][1], static_cast<Position>(p), true, level);
+                }
+            }
+        }
+
+        static void fill(std::array<float, kNumCombos>& out, Position pos, bool raise, int level) {
+            // The blinds defend roughly the button's opening range
+            Position defendAs = (pos == Position::SB || pos == Position::BB) ? Position::BTN : pos;
+
+            const auto& cards = comboCards();
+            for (int i = 0; i < kNumCombos; ++i) {
+                Card c1 = cardFromIndex(cards[i].hi);
+                Card c2 = cardFromIndex(cards[i].lo);
+                float weight = 1.0f;
+
+                if (raise) {
+                    bool inChart = level == 0 ? GtoCharts::shouldOpen(pos, c1, c2) || GtoCharts::should3bet(pos, c1, c2)
+                                 : level == 1 ? GtoCharts::should3bet(pos, c1, c2)
+                                 : GtoCharts::should4bet(pos, c1, c2);
+                    weight = inChart ? 1.0f : kOffChart;
+                } else if (level == 0) {
+                    // Limping: hands strong enough to open usually would have
+                    weight = GtoCharts::shouldOpen(defendAs, c1, c2) ? 0.5f : 1.0f;
+                } else if (level == 1) {
+                    if (GtoCharts::should3bet(pos, c1, c2)) weight = kTrapFrequency;
+                    else if (GtoCharts::shouldOpen(defendAs, c1, c2) || GtoCharts::shouldCall3bet(pos, c1, c2)) weight = 1.0f;
+                    else weight = kOffChart;
+                } else {
+                    if (GtoCharts::should4bet(pos, c1, c2)) weight = kTrapFrequency;
+                    else if (GtoCharts::shouldCall3bet(pos, c1, c2)) weight = 1.0f;
+                    else weight = kOffChart;
+                }
+                out[i] = weight;
+            }
+        }
+    };
+    static const Tables tables;
+
+    bool raise = action == Action::Bet || action == Action::Raise;
+    return tables.likelihood[static_cast<int>(pos)][std::min(raises, 2)][raise ? 1 : 0];
+}
+
+void RangeTracker::postflopLikelihood(Action action, CardMask board) {
+    rankCombos(board);
+
+    for (int i = 0; i < kNumCombos; ++i) {
+        float s = strength_[i];
+        float weight;
+        switch (action) {
+            case Action::Bet:   weight = 0.15f + 0.85f * s * s; break;       // Value plus some bluffs
+            case Action::Raise: weight = 0.08f + 0.92f * s * s * s; break;
+            case Action::Call:  weight = 0.25f + 0.75f * s; break;
+            default:            weight = 1.0f - 0.6f * s * s; break;         // Check: strong hands slowplay sometimes
+        }
+        likelihood_[i] = weight;
+    }
+}
+
+void RangeTracker::rankCombos(CardMask board) {
+    if (board == strengthBoard_) return;
+    strengthBoard_ = board;
+
+    // Hands aren't made until the flop; before that every combo is average
+    if (std::popcount(board) < 3) {
+        strength_.fill(0.5f);
+        return;
+    }
+
+    // A combo's suits only matter if it holds enough of one to make a flush
+    // with the board: two of a suit with three on board, or one with four.
+    // Every other combo's hand depends on its two ranks, so it shares one
+    // evaluation with the rest of its rank pair. Ranking those shared
+    // hands, each counting as all its combos, gives the same percentiles as
+    // ranking every combo.
+    CardMask suitedFlush = 0;       // Suits where two hole cards can make a flush
+    CardMask anyFlush = 0;          // ... and where one can
+    for (int suit = 0; suit < 4; ++suit) {
+        CardMask suitCards = CardMask{0x1FFF} << (13 * suit);
+        int onBoard = std::popcount(board & suitCards);
+        if (onBoard >= 3) suitedFlush |= suitCards;
+        if (onBoard >= 4) anyFlush |= suitCards;
+    }
+
+    const auto& shapes = comboShapes();
+    const auto& masks = comboMasks();
+
+    // With no flush possible nothing depends on suits at all, so boards with
+    // the same count of each rank rank every rank pair the same
+    uint64_t rankCounts = 0;        // Three bits a rank
+    if (!suitedFlush) {
+        for (CardMask rest = board; rest; rest &= rest - 1) rankCounts += uint64_t{1} << (3 * (std::countr_zero(rest) % 13));
+        auto known = rankPatterns_.find(rankCounts);
+        if (known != rankPatterns_.end()) {
+            for (int i = 0; i < kNumCombos; ++i) strength_[i] = (masks[i] & board) ? 0.0f : known->second[shapes[i].rankPair];
+            return;
+        }
+    }
+
+    constexpr uint16_t kNoHand = 0xFFFF;
+    constexpr uint16_t kDead = kNumCombos;          // handOf a combo the board blocks
+    std::array<uint16_t, kNumRankPairs> pairHand;
+    pairHand.fill(kNoHand);
+    std::array<uint16_t, kNumCombos> handOf;
+    std::array<CardMask, kNumCombos> hands;
+    std::array<uint16_t, kNumCombos> combos;        // Combos sharing each hand
+    int numHands = 0;
+    int live = 0;
+
+    for (int i = 0; i < kNumCombos; ++i) {
+        CardMask mask = masks[i];
+        if (mask & board) {
+            handOf[i] = kDead;
+            continue;
+        }
+        ++live;
+        if ((mask & anyFlush) || ((mask & suitedFlush) && shapes[i].suited)) {
+            hands[numHands] = mask;
+            combos[numHands] = 1;
+            handOf[i] = static_cast<uint16_t>(numHands++);
+            continue;
+        }
+        uint16_t& shared = pairHand[shapes[i].rankPair];
+        if (shared == kNoHand) {
+            hands[numHands] = mask;
+            combos[numHands] = 0;
+            shared = static_cast<uint16_t>(numHands++);
+        }
+        handOf[i] = shared;
+        combos[shared]++;
+    }
+
+    std::array<HandResult, kNumCombos> results;
+    HandEvaluator::evaluateShowdown(board, hands.data(), numHands, results.data());
+
+    // One integer per hand: its key, then its index in the low 11 bits
+    constexpr uint64_t kIndexBits = (1u << 11) - 1;
+    std::array<uint64_t, kNumCombos> order;
+    for (int h = 0; h < numHands; ++h) order[h] = (results[h].key() << 11) | static_cast<uint64_t>(h);
+    std::sort(order.begin(), order.begin() + numHands);
+
+    // Percentile with tied combos sharing the midpoint of their block
+    std::array<float, kNumCombos + 1> percentile;
+    percentile[kDead] = 0.0f;
+    for (int start = 0, below = 0; start < numHands;) {
+        int end = start;
+        int tied = 0;
+        while (end < numHands && (order[end] >> 11) == (order[start] >> 11)) tied += combos[order[end++] & kIndexBits];
+        float p = (2 * below + tied) * 0.5f / live;
+        for (int h = start; h < end; ++h) percentile[order[h] & kIndexBits] = p;
+        below += tied;
+        start = end;
+    }
+    for (int i = 0; i < kNumCombos; ++i) strength_[i] = percentile[handOf[i]];
+
+    if (!suitedFlush) {
+        std::array<float, kNumRankPairs>& byPair = rankPatterns_[rankCounts];
+        for (int pair = 0; pair < kNumRankPairs; ++pair) {
+            byPair[pair] = pairHand[pair] == kNoHand ? 0.0f : percentile[pairHand[pair]];
+        }
+    }
+}
+
+} // namespace sharkwave
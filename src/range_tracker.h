@@ -0,0 +1,72 @@
+#pragma once
+
+#include "card.h"
+#include "game_session.h"
+#include "range.h"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace sharkwave {
+
+// Each player's range for the current hand, narrowed by every action the
+// session records. Preflop the likelihood of an action comes from the
+// GtoCharts range for it; postflop from the combo's showdown strength on
+// the board (strong hands bet and raise, weak ones check and fold). Every
+// player starts the hand holding any two cards. Hero's range is narrowed
+// the same way: it's what the opponents would put hero on, which is what
+// a solver needs.
+class RangeTracker {
+public:
+    RangeTracker();
+
+    // Apply whatever the session recorded since the last call, starting over
+    // when the session has moved on to a new hand
+    void update(const GameSession& session);
+
+    // Off, only who has folded, acted and raised is tracked and every range
+    // stays any two cards: about a third of the cost per update, for callers
+    // that never read the ranges. On by default.
+    void setNarrowing(bool on);
+    bool narrowing() const { return narrowing_; }
+
+    const Range& range(Position pos) const { return ranges_[static_cast<int>(pos)]; }
+    bool folded(Position pos) const { return folded_[static_cast<int>(pos)]; }
+
+    // The opponent hero is most likely up against: the last one to bet or
+    // raise, else the last one to act. Empty until an opponent has acted.
+    std::optional<Position> mainOpponent() const;
+
+private:
+    void reset(uint32_t handId);
+    void apply(const ActionRecord& record, CardMask board);
+    static const std::array<float, kNumCombos>& preflopLikelihood(Position pos, Action action, int raises);
+    void postflopLikelihood(Action action, CardMask board);
+    void rankCombos(CardMask board);
+
+    std::array<Range, 6> ranges_;
+    std::array<bool, 6> folded_;
+    bool narrowing_;
+
+    uint32_t handId_;
+    size_t applied_;            // Session actions already folded into the ranges
+    Position hero_;
+    int preflopRaises_;
+    CardMask removedBoard_;     // Board cards already zeroed out of every range
+    std::optional<Position> lastAggressor_;
+    std::optional<Position> lastActor_;
+
+    // Showdown strength of every combo on strengthBoard_, as a percentile
+    CardMask strengthBoard_;
+    std::array<float, kNumCombos> strength_;
+    std::array<float, kNumCombos> likelihood_;
+
+    // Percentile of each pair of ranks on boards where no flush is possible,
+    // by the board's count of each rank. There are only a few thousand such
+    // patterns, so a long run soon ranks every board from here.
+    static constexpr int kNumRankPairs = 91;
+    std::unordered_map<uint64_t, std::array<float, kNumRankPairs>> rankPatterns_;
+};
+
+} // namespace sharkwave
@@ -0,0 +1,378 @@
+#include "river_solver.h"
+#include "hand_evaluator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace sharkwave {
+
+RiverSolver::RiverSolver(const RiverSpot& spot, const RiverAbstraction& abstraction)
+    : abstraction_(abstraction)
+    , pot_(spot.pot)
+    , stack_(spot.stack)
+    , iterations_(0)
+    , n_(0)
+    , comboSlot_(kNumCombos, -1)
+{
+    const auto& masks = comboMasks();
+    const auto& cards = comboCards();
+    std::vector<CardMask> hands;
+    std::vector<uint16_t> live;
+    for (int combo = 0; combo < kNumCombos; ++combo) {
+        if (masks[combo] & spot.board) continue;
+        hands.push_back(masks[combo]);
+        live.push_back(static_cast<uint16_t>(combo));
+    }
+    n_ = static_cast<int>(live.size());
+
+    // Rank every combo on the board once, and lay everything out in that order
+    std::vector<HandResult> results(n_);
+    HandEvaluator::evaluateShowdown(spot.board, hands.data(), n_, results.data());
+    std::vector<uint64_t> keys(n_);
+    for (int i = 0; i < n_; ++i) keys[i] = (results[i].key() << 11) | live[i];
+    std::sort(keys.begin(), keys.end());
+
+    for (int slot = 0; slot < n_; ++slot) {
+        int combo = static_cast<int>(keys[slot] & 0x7ff);
+        comboSlot_[combo] = static_cast<int16_t>(slot);
+        combos_.push_back(static_cast<uint16_t>(combo));
+        card1_.push_back(cards[combo].hi);
+        card2_.push_back(cards[combo].lo);
+        range_[kOop].push_back(spot.oop[combo]);
+        range_[kIp].push_back(spot.ip[combo]);
+        if (slot == 0 || (keys[slot] >> 11) != (keys[slot - 1] >> 11)) {
+            groupStart_.push_back(static_cast<uint16_t>(slot));
+        }
+    }
+    groupStart_.push_back(static_cast<uint16_t>(n_));
+
+    build(kOop, 0.0, 0.0, false);
+
+    for (Node& node : nodes_) {
+        node.ownSelf.resize(n_);
+        node.ownOpp.resize(n_);
+        node.values.resize(n_);
+        if (node.actor >= 0) {
+            node.regrets.assign(static_cast<size_t>(node.numEdges) * n_, 0.0f);
+            node.strategySum.assign(static_cast<size_t>(node.numEdges) * n_, 0.0f);
+            node.current.resize(static_cast<size_t>(node.numEdges) * n_);
+        }
+    }
+}
+
+int RiverSolver::build(int actor, double oopIn, double ipIn, bool raised) {
+    const int index = static_cast<int>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_[index].actor = static_cast<int8_t>(actor);
+    nodes_[index].contrib[kOop] = oopIn;
+    nodes_[index].contrib[kIp] = ipIn;
+
+    auto terminal = [this](int folder, double oop, double ip) {
+        nodes_.emplace_back();
+        Node& node = nodes_.back();
+        node.folder = static_cast<int8_t>(folder);
+        node.contrib[kOop] = oop;
+        node.contrib[kIp] = ip;
+        return static_cast<int>(nodes_.size() - 1);
+    };
+
+    // Children first: they append their own edges as they're built
+    std::vector<Edge> edges;
+    const int opponent = 1 - actor;
+    double in[2] = {oopIn, ipIn};
+    const double facing = in[opponent] - in[actor];
+
+    if (facing > 0) {
+        edges.push_back({Action::Fold, in[actor], terminal(actor, oopIn, ipIn)});
+        edges.push_back({Action::Call, in[opponent], terminal(-1, in[opponent], in[opponent])});
+
+        if (!raised && in[opponent] < stack_) {
+            double raiseTo = std::min(in[opponent] + abstraction_.raiseFraction * (pot_ + 2 * in[opponent]), stack_);
+            double next[2] = {in[0], in[1]};
+            next[actor] = raiseTo;
+            edges.push_back({Action::Raise, raiseTo, build(opponent, next[0], next[1], true)});
+        }
+    } else {
+        // Checking behind ends the betting; OOP's check passes the action
+        int afterCheck = actor == kIp ? terminal(-1, 0.0, 0.0) : build(kIp, 0.0, 0.0, false);
+        edges.push_back({Action::Check, 0.0, afterCheck});
+
+        double previous = 0.0;
+        for (double size : abstraction_.betSizes) {
+            double amount = std::min(size * pot_, stack_);
+            if (amount <= previous) continue;   // Sizes that all cap at all-in collapse into one
+            previous = amount;
+
+            double next[2] = {0.0, 0.0};
+            next[actor] = amount;
+            edges.push_back({Action::Bet, amount, build(opponent, next[0], next[1], false)});
+        }
+    }
+
+    nodes_[index].firstEdge = static_cast<int>(edges_.size());
+    nodes_[index].numEdges = static_cast<int>(edges.size());
+    edges_.insert(edges_.end(), edges.begin(), edges.end());
+    return index;
+}
+
+std::span<const RiverSolver::Edge> RiverSolver::edges(int node) const {
+    return {edges_.data() + nodes_[node].firstEdge, static_cast<size_t>(nodes_[node].numEdges)};
+}
+
+int RiverSolver::follow(int node, Action action, double amount) const {
+    if (node < 0 || nodes_[node].actor < 0) return -1;
+
+    auto aggressive = [](Action a) { return a == Action::Bet || a == Action::Raise; };
+    int best = -1;
+    double bestDistance = 0.0;
+    for (const Edge& edge : edges(node)) {
+        if (aggressive(action) ? !aggressive(edge.action) : edge.action != action) continue;
+        double distance = std::abs(edge.amount - amount);
+        if (best < 0 || distance < bestDistance) {
+            best = edge.child;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+void RiverSolver::solve(int iterations, ThreadPool* pool) {
+    Node& root = nodes_[kRoot];
+    for (int i = 0; i < iterations; ++i) {
+        iterations_++;
+        for (int player : {kOop, kIp}) {
+            root.reachSelf = range_[player].data();
+            root.reachOpp = range_[1 - player].data();
+            traverse(kRoot, player, pool);
+        }
+    }
+}
+
+void RiverSolver::traverse(int index, int player, ThreadPool* pool) {
+    Node& node = nodes_[index];
+    const int n = n_;
+    if (node.actor < 0) {
+        terminalValues(node, player, node.values.data());
+        return;
+    }
+
+    // Regret matching
+    const int numEdges = node.numEdges;
+    const float uniform = 1.0f / numEdges;
+    float* current = node.current.data();
+    const float* regrets = node.regrets.data();
+    for (int i = 0; i < n; ++i) {
+        float sum = 0.0f;
+        for (int e = 0; e < numEdges; ++e) sum += regrets[e * n + i];
+        for (int e = 0; e < numEdges; ++e) {
+            current[e * n + i] = sum > 0.0f ? regrets[e * n + i] / sum : uniform;
+        }
+    }
+
+    const bool acting = node.actor == player;
+    const Edge* edge = edges_.data() + node.firstEdge;
+    for (int e = 0; e < numEdges; ++e) {
+        Node& child = nodes_[edge[e].child];
+        const float* strategy = current + e * n;
+        if (acting) {
+            for (int i = 0; i < n; ++i) child.ownSelf[i] = node.reachSelf[i] * strategy[i];
+            child.reachSelf = child.ownSelf.data();
+            child.reachOpp = node.reachOpp;
+        } else {
+            for (int i = 0; i < n; ++i) child.ownOpp[i] = node.reachOpp[i] * strategy[i];
+            child.reachSelf = node.reachSelf;
+            child.reachOpp = child.ownOpp.data();
+        }
+    }
+
+    // The subtrees share nothing, so they can be solved side by side
+    if (pool && numEdges > 1) {
+        pool->parallelFor(0, numEdges, [&](size_t e) { traverse(edge[e].child, player, nullptr); });
+    } else {
+        for (int e = 0; e < numEdges; ++e) traverse(edge[e].child, player, nullptr);
+    }
+
+    float* values = node.values.data();
+    std::fill(values, values + n, 0.0f);
+    if (!acting) {
+        for (int e = 0; e < numEdges; ++e) {
+            const float* childValues = nodes_[edge[e].child].values.data();
+            for (int i = 0; i < n; ++i) values[i] += childValues[i];
+        }
+        return;
+    }
+
+    for (int e = 0; e < numEdges; ++e) {
+        const float* childValues = nodes_[edge[e].child].values.data();
+        const float* strategy = current + e * n;
+        for (int i = 0; i < n; ++i) values[i] += strategy[i] * childValues[i];
+    }
+
+    // CFR+: regrets never go below zero, and later iterations count more
+    // toward the average strategy
+    const float weight = static_cast<float>(iterations_);
+    for (int e = 0; e < numEdges; ++e) {
+        const float* childValues = nodes_[edge[e].child].values.data();
+        const float* strategy = current + e * n;
+        float* regret = node.regrets.data() + e * n;
+        float* strategySum = node.strategySum.data() + e * n;
+        for (int i = 0; i < n; ++i) {
+            regret[i] = std::max(regret[i] + childValues[i] - values[i], 0.0f);
+            strategySum[i] += weight * node.reachSelf[i] * strategy[i];
+        }
+    }
+}
+
+void RiverSolver::terminalValues(const Node& node, int player, float* out) const {
+    const int n = n_;
+    const float* reach = node.reachOpp;
+
+    // Opponent reach in total and per card, so each combo can drop the
+    // opponent hands that share one of its cards
+    double total = 0.0;
+    double perCard[52] = {};
+    for (int i = 0; i < n; ++i) {
+        total += reach[i];
+        perCard[card1_[i]] += reach[i];
+        perCard[card2_[i]] += reach[i];
+    }
+    auto compatible = [&](int i) {
+        return total - perCard[card1_[i]] - perCard[card2_[i]] + reach[i];
+    };
+
+    if (node.folder >= 0) {
+        double payoff = node.folder == player ? -node.contrib[player] : pot_ + node.contrib[node.folder];
+        for (int i = 0; i < n; ++i) out[i] = static_cast<float>(payoff * compatible(i));
+        return;
+    }
+
+    // Showdown: one pass up the ranking sums the reach of weaker hands, one
+    // pass down the reach of stronger ones; ties are what's left
+    const double invested = node.contrib[player];
+    const double win = pot_ + invested;
+    const double tie = pot_ * 0.5;
+    const int groups = static_cast<int>(groupStart_.size()) - 1;
+
+    double below = 0.0;
+    double belowCard[52] = {};
+    for (int g = 0; g < groups; ++g) {
+        for (int i = groupStart_[g]; i < groupStart_[g + 1]; ++i) {
+            out[i] = static_cast<float>(below - belowCard[card1_[i]] - belowCard[card2_[i]]);
+        }
+        for (int i = groupStart_[g]; i < groupStart_[g + 1]; ++i) {
+            below += reach[i];
+            belowCard[card1_[i]] += reach[i];
+            belowCard[card2_[i]] += reach[i];
+        }
+    }
+
+    double above = 0.0;
+    double aboveCard[52] = {};
+    for (int g = groups - 1; g >= 0; --g) {
+        for (int i = groupStart_[g]; i < groupStart_[g + 1]; ++i) {
+            double weaker = out[i];
+            double stronger = above - aboveCard[card1_[i]] - aboveCard[card2_[i]];
+            double tied = compatible(i) - weaker - stronger;
+            out[i] = static_cast<float>(win * weaker - invested * stronger + tie * tied);
+        }
+        for (int i = groupStart_[g]; i < groupStart_[g + 1]; ++i) {
+            above += reach[i];
+            aboveCard[card1_[i]] += reach[i];
+            aboveCard[card2_[i]] += reach[i];
+        }
+    }
+}
+
+void RiverSolver::averageStrategy(const Node& node, int edge, float* out) const {
+    const int n = n_;
+    const float uniform = 1.0f / node.numEdges;
+    for (int i = 0; i < n; ++i) {
+        float sum = 0.0f;
+        for (int e = 0; e < node.numEdges; ++e) sum += node.strategySum[e * n + i];
+        out[i] = sum > 0.0f ? node.strategySum[edge * n + i] / sum : uniform;
+    }
+}
+
+std::vector<double> RiverSolver::strategy(int node, int combo) const {
+    const Node& decision = nodes_[node];
+    std::vector<double> frequencies(decision.numEdges, 1.0 / decision.numEdges);
+    int slot = comboSlot_[combo];
+    if (slot < 0) return frequencies;
+
+    double sum = 0.0;
+    for (int e = 0; e < decision.numEdges; ++e) sum += decision.strategySum[e * n_ + slot];
+    if (sum <= 0.0) return frequencies;
+    for (int e = 0; e < decision.numEdges; ++e) frequencies[e] = decision.strategySum[e * n_ + slot] / sum;
+    return frequencies;
+}
+
+void RiverSolver::bestResponse(int index, int player) {
+    Node& node = nodes_[index];
+    const int n = n_;
+    if (node.actor < 0) {
+        terminalValues(node, player, node.values.data());
+        return;
+    }
+
+    const bool acting = node.actor == player;
+    const Edge* edge = edges_.data() + node.firstEdge;
+    for (int e = 0; e < node.numEdges; ++e) {
+        Node& child = nodes_[edge[e].child];
+        child.reachSelf = node.reachSelf;
+        if (acting) {
+            child.reachOpp = node.reachOpp;
+        } else {
+            averageStrategy(node, e, child.ownOpp.data());
+            for (int i = 0; i < n; ++i) child.ownOpp[i] *= node.reachOpp[i];
+            child.reachOpp = child.ownOpp.data();
+        }
+        bestResponse(edge[e].child, player);
+    }
+
+    float* values = node.values.data();
+    for (int i = 0; i < n; ++i) {
+        float value = acting ? nodes_[edge[0].child].values[i] : 0.0f;
+        for (int e = acting ? 1 : 0; e < node.numEdges; ++e) {
+            float childValue = nodes_[edge[e].child].values[i];
+            value = acting ? std::max(value, childValue) : value + childValue;
+        }
+        values[i] = value;
+    }
+}
+
+double RiverSolver::rangeValue(int player, const std::vector<float>& values) const {
+    // Average over the deals both ranges allow
+    const std::vector<float>& own = range_[player];
+    const std::vector<float>& opponent = range_[1 - player];
+    double total = 0.0;
+    double perCard[52] = {};
+    for (int i = 0; i < n_; ++i) {
+        total += opponent[i];
+        perCard[card1_[i]] += opponent[i];
+        perCard[card2_[i]] += opponent[i];
+    }
+
+    double value = 0.0;
+    double deals = 0.0;
+    for (int i = 0; i < n_; ++i) {
+        value += own[i] * values[i];
+        deals += own[i] * (total - perCard[card1_[i]] - perCard[card2_[i]] + opponent[i]);
+    }
+    return deals > 0.0 ? value / deals : 0.0;
+}
+
+double RiverSolver::exploitability() {
+    Node& root = nodes_[kRoot];
+    double best = 0.0;
+    for (int player : {kOop, kIp}) {
+        root.reachSelf = range_[player].data();
+        root.reachOpp = range_[1 - player].data();
+        bestResponse(kRoot, player);
+        best += rangeValue(player, root.values);
+    }
+
+    // The two players' values always add up to the pot
+    return (best - pot_) / 2;
+}
+
+} // namespace sharkwave
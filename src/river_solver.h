@@ -0,0 +1,119 @@
+#pragma once
+
+#include "card.h"
+#include "game_session.h"
+#include "range.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace sharkwave {
+
+class ThreadPool;
+
+// A heads-up river spot: the full board, the pot and stacks as the river
+// betting starts, and each player's range
+struct RiverSpot {
+    CardMask board = 0;
+    double pot = 0.0;
+    double stack = 0.0;     // Effective stack behind
+    Range oop;              // Acts first
+    Range ip;
+};
+
+// Bets are fractions of the pot, capped at all-in. There is at most one
+// raise, to `raiseFraction` of the pot after calling (1.0 = a pot raise).
+struct RiverAbstraction {
+    std::vector<double> betSizes = {0.33, 0.75, 1.5};
+    double raiseFraction = 1.0;
+};
+
+// CFR+ on the river betting tree. Every node holds one value per combo for
+// the whole range, so an iteration is a handful of passes over flat float
+// arrays. Combos are ranked on the board once up front; after that a
+// showdown costs O(n) (prefix sums over the ranking, corrected for card
+// removal), so the solve as a whole is O(n log n + iterations * n).
+class RiverSolver {
+public:
+    static constexpr int kOop = 0;
+    static constexpr int kIp = 1;
+    static constexpr int kRoot = 0;
+
+    struct Edge {
+        Action action;
+        double amount;      // Actor's total river investment after acting
+        int child;
+    };
+
+    RiverSolver(const RiverSpot& spot, const RiverAbstraction& abstraction = {});
+
+    // Run more CFR+ iterations. With a pool, the subtrees below the root
+    // are solved in parallel.
+    void solve(int iterations, ThreadPool* pool = nullptr);
+    int iterations() const { return iterations_; }
+
+    // Game tree. actor() is kOop or kIp, or -1 for a terminal node.
+    int actor(int node) const { return nodes_[node].actor; }
+    std::span<const Edge> edges(int node) const;
+
+    // The child reached by the edge closest to `action` (for bets and
+    // raises, the nearest size), or -1 if the node has no such action
+    int follow(int node, Action action, double amount) const;
+
+    // Average strategy of `combo` at a decision node, one frequency per edge
+    std::vector<double> strategy(int node, int combo) const;
+
+    // How much the average strategies lose to best responses, in chips: 0 at
+    // an equilibrium
+    double exploitability();
+
+private:
+    struct Node {
+        int8_t actor = -1;
+        int8_t folder = -1;     // Terminal nodes: the player who folded, or -1 at showdown
+        double contrib[2] = {0.0, 0.0};
+        int firstEdge = 0;
+        int numEdges = 0;
+
+        // Decision nodes: per edge, per combo
+        std::vector<float> regrets;
+        std::vector<float> strategySum;
+        std::vector<float> current;     // This iteration's strategy
+
+        // Traversal buffers: inputs are set by the parent, values returned
+        const float* reachSelf = nullptr;
+        const float* reachOpp = nullptr;
+        std::vector<float> ownSelf;
+        std::vector<float> ownOpp;
+        std::vector<float> values;
+    };
+
+    int build(int actor, double oopIn, double ipIn, bool raised);
+    void traverse(int node, int player, ThreadPool* pool);
+    void bestResponse(int node, int player);
+    void terminalValues(const Node& node, int player, float* out) const;
+    void averageStrategy(const Node& node, int edge, float* out) const;
+    double rangeValue(int player, const std::vector<float>& values) const;
+
+    RiverAbstraction abstraction_;
+    double pot_;
+    double stack_;
+    int iterations_;
+
+    // Combos that don't touch the board, weakest first. Every per-combo
+    // array is in this order, so a showdown is a straight pass.
+    int n_;
+    std::vector<uint16_t> combos_;
+    std::vector<int16_t> comboSlot_;    // Combo -> slot, or -1
+    std::vector<uint8_t> card1_;
+    std::vector<uint8_t> card2_;
+    std::vector<float> range_[2];
+
+    // Where each run of equally strong hands starts, with n_ as a sentinel
+    std::vector<uint16_t> groupStart_;
+
+    std::vector<Node> nodes_;
+    std::vector<Edge> edges_;
+};
+
+} // namespace sharkwave
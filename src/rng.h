@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace sharkwave {
+
+// SplitMix64 finalizer; also used to derive independent seeds from one base seed
+constexpr uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// xoshiro256** - much cheaper to seed and step than std::mt19937, and its
+// 32-byte state is trivial to copy. Satisfies UniformRandomBitGenerator.
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t seed = 0x5EED) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        for (uint64_t& word : state_) {
+            seed = splitmix64(seed);
+            word = seed;
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, n) (multiply-shift; bias is negligible for small n)
+    uint32_t below(uint32_t n) {
+        return static_cast<uint32_t>(((next() >> 32) * n) >> 32);
+    }
+
+    // Uniform double in [0, 1)
+    double uniform() {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53;
+    }
+
+    // Full generator state, for checkpointing
+    std::array<uint64_t, 4> state() const { return {state_[0], state_[1], state_[2], state_[3]}; }
+    void setState(const std::array<uint64_t, 4>& state) {
+        for (size_t i = 0; i < 4; ++i) state_[i] = state[i];
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()() { return next(); }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state_[4];
+};
+
+} // namespace sharkwave
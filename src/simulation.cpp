@@ -1,35 +1,133 @@
 #include "simulation.h"
 #include "hand_evaluator.h"
 #include "gto_charts.h"
+#include "profiler.h"
+#include <algorithm>
 #include <iostream>
 #include <format>
+#include <random>
 
 namespace sharkwave {
 
+void SimStats::add(int64_t handProfit, Position heroPosition, Street endStreet,
+                   bool won, bool reachedShowdown) {
+    double p = static_cast<double>(handProfit);
+    profit.add(p);
+    byPosition[static_cast<int>(heroPosition)].add(p);
+    byStreet[static_cast<int>(endStreet)].add(p);
+    totalProfit += handProfit;
+
+    if (reachedShowdown) showdowns++;
+    if (won) wins++;
+    else losses++;
+}
+
+void SimStats::merge(const SimStats& other) {
+    profit.merge(other.profit);
+    for (size_t i = 0; i < byPosition.size(); ++i) byPosition[i].merge(other.byPosition[i]);
+    for (size_t i = 0; i < byStreet.size(); ++i) byStreet[i].merge(other.byStreet[i]);
+    wins += other.wins;
+    losses += other.losses;
+    showdowns += other.showdowns;
+    totalProfit += other.totalProfit;
+}
+
 namespace {
-    constexpr int rankToInt(Rank r) { return static_cast<int>(r); }
+    void saveRunning(Checkpoint& checkpoint, const std::string& key, const RunningStats& stats) {
+        checkpoint.setInt(key + ".count", stats.count());
+        checkpoint.setDouble(key + ".mean", stats.mean());
+        checkpoint.setDouble(key + ".m2", stats.sumSquaredDeviations());
+    }
+
+    RunningStats loadRunning(const Checkpoint& checkpoint, const std::string& key) {
+        return RunningStats::fromState(checkpoint.getInt(key + ".count"),
+                                       checkpoint.getDouble(key + ".mean"),
+                                       checkpoint.getDouble(key + ".m2"));
+    }
+}
+
+void SimStats::save(Checkpoint& checkpoint) const {
+    saveRunning(checkpoint, "stats.profit", profit);
+    for (size_t i = 0; i < byPosition.size(); ++i) {
+        saveRunning(checkpoint, std::format("stats.position{}", i), byPosition[i]);
+    }
+    for (size_t i = 0; i < byStreet.size(); ++i) {
+        saveRunning(checkpoint, std::format("stats.street{}", i), byStreet[i]);
+    }
+    checkpoint.setInt("stats.wins", wins);
+    checkpoint.setInt("stats.losses", losses);
+    checkpoint.setInt("stats.showdowns", showdowns);
+    checkpoint.setInt("stats.total_profit", totalProfit);
+}
+
+void SimStats::load(const Checkpoint& checkpoint) {
+    profit = loadRunning(checkpoint, "stats.profit");
+    for (size_t i = 0; i < byPosition.size(); ++i) {
+        byPosition[i] = loadRunning(checkpoint, std::format("stats.position{}", i));
+    }
+    for (size_t i = 0; i < byStreet.size(); ++i) {
+        byStreet[i] = loadRunning(checkpoint, std::format("stats.street{}", i));
+    }
+    wins = static_cast<int>(checkpoint.getInt("stats.wins"));
+    losses = static_cast<int>(checkpoint.getInt("stats.losses"));
+    showdowns = static_cast<int>(checkpoint.getInt("stats.showdowns"));
+    totalProfit = checkpoint.getInt("stats.total_profit");
 }
 
 Simulation::Simulation(int numHands, OpponentType oppType)
-    : numHands_(numHands)
-    , opponentType_(oppType)
+    : Simulation(SimConfig{.numHands = numHands, .opponent = oppType})
+{
+}
+
+Simulation::Simulation(const SimConfig& config)
+    : numHands_(config.numHands)
+    , opponentType_(config.opponent)
+    , targetCi_(0.0)
+    , equityIterations_(config.equityIterations)
+    , riverSolveIterations_(config.riverSolveIterations)
+    , rangeTracking_(config.rangeTracking)
+    , checkpointEvery_(0)
     , deckIndex_(0)
-    , heroStack_(1000)
-    , villainStack_(1000)
+    , heroStack_(static_cast<int64_t>(config.minStackBB) * config.bb)
+    , villainStack_(static_cast<int64_t>(config.minStackBB) * config.bb)
     , pot_(0)
-    , sb_(5)
-    , bb_(10)
-    , heroHandsWon_(0)
-    , villainHandsWon_(0)
-    , heroTotalProfit_(0)
-    , showdownCount_(0)
+    , villainEquity_(0.0)
+    , villainEquityBoard_(-1)
+    , sb_(config.sb)
+    , bb_(config.bb)
+    , minStackBB_(config.minStackBB)
+    , maxStackBB_(config.maxStackBB)
     , heroPosition_(Position::BTN)
     , villainPosition_(Position::BB)
-    , rng_(std::random_device{}())
+    , seed_(config.seed != 0 ? config.seed : std::random_device{}())
+    , handIndex_(0)
+    , rng_(seed_)
+    , hero_(config.sb, config.bb, config.equityIterations, seed_)
 {
+    hero_.engine().setRangeTracking(rangeTracking_);
+    hero_.engine().setRiverSolver(riverSolveIterations_);
+}
+
+std::string Simulation::opponentToString(OpponentType type) {
+    switch (type) {
+        case OpponentType::Random:          return "Random";
+        case OpponentType::TightPassive:    return "Tight Passive";
+        case OpponentType::LooseAggressive: return "Loose Aggressive";
+        case OpponentType::CallingStation:  return "Calling Station";
+    }
+    return "Unknown";
+}
+
+std::optional<OpponentType> Simulation::parseOpponent(std::string_view name) {
+    if (name == "random")  return OpponentType::Random;
+    if (name == "tight")   return OpponentType::TightPassive;
+    if (name == "lag")     return OpponentType::LooseAggressive;
+    if (name == "station") return OpponentType::CallingStation;
+    return std::nullopt;
 }
 
 void Simulation::shuffleDeck() {
+    SHARKWAVE_PROFILE_SCOPE(Shuffle);
     deckIndex_ = 0;
 
     // Create deck
@@ -42,8 +140,7 @@ void Simulation::shuffleDeck() {
 
     // Fisher-Yates shuffle
     for (int i = 51; i > 0; --i) {
-        std::uniform_int_distribution<int> dist(0, i);
-        int j = dist(rng_);
+        int j = static_cast<int>(rng_.below(i + 1));
         std::swap(deck_[i], deck_[j]);
     }
 }
@@ -58,6 +155,7 @@ Card Simulation::dealCard() {
 void Simulation::dealHoleCards() {
     heroCards_.clear();
     villainCards_.clear();
+    board_.clear();
 
     // Heads up: BTN (hero) gets first card, BB (villain) gets second, then BTN first, BB second
     heroCards_.add(dealCard());
@@ -85,21 +183,23 @@ void Simulation::dealRiver() {
 }
 
 Action Simulation::getOpponentAction(Position pos, const CardSet& holeCards, int64_t facingBet, bool canCheck) {
+    SHARKWAVE_PROFILE_SCOPE(OpponentAction);
     (void)pos; // Position affects decision but not used in simple implementation
-    // Get hand strength for decision making
-    CardSet combined;
-    for (size_t i = 0; i < holeCards.count; ++i) combined.add(holeCards.cards[i]);
-    for (size_t i = 0; i < board_.count; ++i) combined.add(board_.cards[i]);
-    ::sharkwave::HandResult hand = HandEvaluator::evaluate(combined);
-
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-    double rand = dist(rng_);
+    double rand = rng_.uniform();
 
     // Pot odds calculation
     double potOdds = (facingBet > 0) ? static_cast<double>(facingBet) / (pot_ + facingBet * 2) : 0.0;
 
-    // Get equity approximation
-    double equity = HandEvaluator::calculateEquity(holeCards, board_, 200);
+    // Equity is only computed by the opponent types that look at it, and at
+    // most once per street since it can't change until the board does
+    auto estimateEquity = [&] {
+        if (villainEquityBoard_ != static_cast<int>(board_.count)) {
+            villainEquity_ = HandEvaluator::calculateEquity(holeCards.mask(), board_.mask(),
+                                                            equityIterations_, rng_);
+            villainEquityBoard_ = static_cast<int>(board_.count);
+        }
+        return villainEquity_;
+    };
 
     switch (opponentType_) {
         case OpponentType::Random: {
@@ -115,6 +215,8 @@ Action Simulation::getOpponentAction(Position pos, const CardSet& holeCards, int
         }
 
         case OpponentType::TightPassive: {
+            ::sharkwave::HandResult hand = HandEvaluator::evaluate(holeCards.mask() | board_.mask());
+            double equity = estimateEquity();
             if (facingBet > 0) {
                 // Only calls with good pot odds or strong hands
                 if (equity > potOdds + 0.1) return Action::Call;
@@ -130,6 +232,7 @@ Action Simulation::getOpponentAction(Position pos, const CardSet& holeCards, int
         }
 
         case OpponentType::LooseAggressive: {
+            double equity = estimateEquity();
             if (facingBet > 0) {
                 // Calls wide, raises often
                 if (equity > 0.25) {
@@ -162,212 +265,21 @@ Action Simulation::getOpponentAction(Position pos, const CardSet& holeCards, int
     return canCheck ? Action::Check : Action::Fold;
 }
 
-Decision Simulation::getHeroDecision(bool facingBet, int64_t facingAmt) {
-    // Get hand strength
-    CardSet fullHand;
-    for (size_t i = 0; i < heroCards_.count; ++i) fullHand.add(heroCards_.cards[i]);
-    for (size_t i = 0; i < board_.count; ++i) fullHand.add(board_.cards[i]);
-
-    ::sharkwave::HandResult hand = HandEvaluator::evaluate(fullHand);
-    double equity = HandEvaluator::calculateEquity(heroCards_, board_, 300);
-
-    double potOdds = (facingAmt > 0) ? static_cast<double>(facingAmt) / (pot_ + facingAmt) : 0.0;
-
-    // Preflop - HEADS UP GTO (very different from full ring!)
-    if (board_.count == 0) {
-        if (facingBet) {
-            // Facing a 3-bet as SB opener
-            // 4-bet premiums, call rest
-            int r1 = rankToInt(heroCards_.cards[0].rank());
-            int r2 = rankToInt(heroCards_.cards[1].rank());
-            bool paired = (r1 == r2);
-            (void)paired; // Used in condition
-            int high = std::max(r1, r2);
-
-            // 4-bet: AA, KK, AK
-            if ((paired && r1 >= 13) || (high == 14 && r2 == 13)) {
-                int64_t raiseAmt = heroStack_; // All-in
-                return Decision::raise(raiseAmt, "4-bet all-in with premium");
-            }
-
-            // Call with most hands that raised
-            if (equity > 0.45) {
-                return Decision::call(facingAmt, "Call 3-bet with decent hand");
-            }
-            return Decision::fold("Fold to 3-bet with trash");
-        }
-
-        // Unopened pot in HU - RAISE ALMOST EVERYTHING from SB/BTN
-        // Heads up: SB (button) should raise ~70-80% of hands
-        int r1 = rankToInt(heroCards_.cards[0].rank());
-        int r2 = rankToInt(heroCards_.cards[1].rank());
-        bool paired = (r1 == r2);
-        bool suited = (heroCards_.cards[0].suit() == heroCards_.cards[1].suit());
-        int high = std::max(r1, r2);
-        int low = std::min(r1, r2);
-
-        // In heads up, open almost everything:
-        // - All pairs
-        // - All suited hands (A2s+, K2s+, Q4s+, J6s+, T7s+, 98s+)
-        // - All offsuit A (A2o+)
-        // - High offsuit connectors (KTo+, QTo+, JTo)
-        // - Some Kx offsuit (K6o+)
-
-        bool shouldOpen = paired || suited ||
-            (high == 14) || // All Ax
-            (high >= 12 && low >= 10) || // Broadway offsuit
-            (high == 11 && low >= 10) || // JTo
-            (high == 13 && low >= 7); // K7o+
-
-        if (shouldOpen) {
-            int64_t raiseAmt = static_cast<int64_t>(bb_ * 2.5);
-            if (raiseAmt > heroStack_) raiseAmt = heroStack_;
-            return Decision::raise(raiseAmt, "Heads up min-raise button");
-        }
-
-        return Decision::check("Check with trash in HU");
-    }
-
-    // Postflop decisions - EXPLOITATIVE based on opponent type
-    if (facingBet) {
-        // Adjust play based on opponent
-        bool vsCallingStation = (opponentType_ == OpponentType::CallingStation);
-        bool vsTightPassive = (opponentType_ == OpponentType::TightPassive);
-        bool vsLAG = (opponentType_ == OpponentType::LooseAggressive);
-        (void)vsTightPassive; // Used in threshold calculation
-
-        // EXPLOIT: Value bet thinner vs calling stations
-        double valueThreshold = vsCallingStation ? 0.50 : 0.65;
-        double bluffCatchThreshold = vsCallingStation ? 0.35 : 0.25;
-
-        if (hand.rank >= ::sharkwave::HandRank::TwoPair || equity > valueThreshold) {
-            if (equity > 0.75) {
-                int64_t raiseAmt = facingAmt * 2 + pot_;
-                if (raiseAmt > heroStack_) raiseAmt = heroStack_;
-                return Decision::raise(raiseAmt, "Raise for value with strong hand");
-            }
-            // EXPLOIT: Call more vs calling stations
-            if (vsCallingStation && equity > 0.55) {
-                return Decision::call(facingAmt, "Call for value vs station");
-            }
-            return Decision::call(facingAmt, "Call with good made hand");
-        }
-
-        if (hand.rank >= ::sharkwave::HandRank::OnePair || equity > 0.45) {
-            if (potOdds < 0.40) {
-                return Decision::call(facingAmt, "Call with pair or decent equity");
-            }
-            // EXPLOIT: Call lighter vs LAG but not too light
-            if (vsLAG && equity > 0.32) {
-                return Decision::call(facingAmt, "Call vs LAG with showdown value");
-            }
-            if (equity > 0.35) {
-                return Decision::call(facingAmt, "Call with showdown value");
-            }
-            return Decision::fold("Fold to large bet without odds");
-        }
-
-        // Draw evaluation - semi-bluff raises with strong draws
-        int outs = HandEvaluator::countOuts(heroCards_, board_);
-        if (outs >= 12) {
-            // Monster draw - raise semi-bluff
-            int64_t raiseAmt = facingAmt + pot_;
-            if (raiseAmt > heroStack_) raiseAmt = heroStack_;
-            return Decision::raise(raiseAmt, std::format("Semi-bluff raise with {} outs", outs));
-        }
-        if (outs >= 8) {
-            double approxEquity = outs / 47.0;
-            if (approxEquity > potOdds * 0.7 || equity > 0.35) {
-                return Decision::call(facingAmt, std::format("Call with {} outs and good odds", outs));
-            }
-        }
-
-        // Weak hands - EXPLOIT: bluff catch selectively
-        if (equity < bluffCatchThreshold) {
-            double catchThreshold = vsLAG ? 0.30 : 0.25;
-            if (potOdds < catchThreshold) {
-                return Decision::call(facingAmt, "Bluff catch with good price");
-            }
-            return Decision::fold("Weak hand. Fold to bet");
-        }
-
-        return Decision::call(facingAmt, "Showdown value call");
-    }
-
-    // First to act or checked to - EXPLOITATIVE betting
-    bool vsLAG = (opponentType_ == OpponentType::LooseAggressive);
-    bool vsCallingStation = (opponentType_ == OpponentType::CallingStation);
-    bool vsTightPassive = (opponentType_ == OpponentType::TightPassive);
-
-    // EXPLOIT: Value bet thinner vs stations, normal vs LAG, tighter vs tight
-    double thinValueThreshold = vsCallingStation ? 0.40 : (vsLAG ? 0.55 : 0.60);
-    double bluffFrequency = vsTightPassive ? 0.40 : 0.25;
-
-    // EXPLOIT: Don't bluff vs LAG or stations - they call too much
-    if (vsLAG || vsCallingStation) {
-        bluffFrequency = 0.0;
-    }
-
-    // EXPLOIT: Value bet HARD vs LAG (they call too wide)
-    // Use smaller sizing to keep them calling with worse
-    if (vsLAG && equity > 0.55) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.50);
-        return Decision::bet(betSize, "Value bet vs LAG - they call wide");
-    }
-
-    // Value bets - bet bigger with stronger hands
-    if (equity > 0.80) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.75);
-        return Decision::bet(betSize, "Big value bet with very strong hand");
-    }
-
-    if (equity > thinValueThreshold) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.60);
-        return Decision::bet(betSize, "Value bet with strong hand");
-    }
-
-    // Semi-bluffs with draws
-    int outs = HandEvaluator::countOuts(heroCards_, board_);
-    if (outs >= 12) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.60);
-        return Decision::bet(betSize, std::format("Semi-bluff with {} outs", outs));
-    }
-    if (outs >= 6) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.40);
-        return Decision::bet(betSize, std::format("Probe bet with {} outs", outs));
-    }
-
-    // Continuation bet - but not vs LAGs
-    if (!vsLAG && equity > 0.50) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.50);
-        return Decision::bet(betSize, "Continuation bet with equity advantage");
-    }
-
-    // Thin value vs calling stations
-    if (vsCallingStation && equity > 0.38) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.40);
-        return Decision::bet(betSize, "Thin value bet vs calling station");
-    }
-
-    // Even weak hands should sometimes bet (bluff) in HU
-    // EXPLOIT: Bluff more vs tight players, never vs stations/LAG
-    if (!vsLAG && !vsCallingStation && equity > 0.35) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.33);
-        return Decision::bet(betSize, "Small bet for thin value/protection");
-    }
-
-    // EXPLOITATIVE bluffs based on opponent
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
-    if ((vsTightPassive || opponentType_ == OpponentType::Random) &&
-        dist(rng_) < bluffFrequency) {
-        int64_t betSize = static_cast<int64_t>(pot_ * 0.33);
-        return Decision::bet(betSize, "Exploitative bluff vs tight opponent");
-    }
+Action Simulation::villainActs(Street street, int64_t facingBet, bool canCheck) {
+    Action action = getOpponentAction(villainPosition_, villainCards_, facingBet, canCheck);
+    hero_.recordAction(villainPosition_, street, action, facingBet);
+    return action;
+}
 
-    return Decision::check("Check with garbage");
+Decision Simulation::getHeroDecision(Street street, int64_t currentBet, int64_t toCall) {
+    SHARKWAVE_PROFILE_SCOPE(HeroDecision);
+    Decision decision = hero_.decide(street, board_, pot_, currentBet, toCall, heroStack_, villainStack_);
+    hero_.recordAction(heroPosition_, street, decision.action, decision.amount);
+    return decision;
 }
 
 void Simulation::settleShowdown() {
+    SHARKWAVE_PROFILE_SCOPE(Showdown);
     CardSet heroFull, villainFull;
 
     for (size_t i = 0; i < heroCards_.count; ++i) heroFull.add(heroCards_.cards[i]);
@@ -385,34 +297,35 @@ void Simulation::settleShowdown() {
 
     if (heroWins) {
         heroStack_ += pot_;
-        heroHandsWon_++;
     } else if (tie) {
         heroStack_ += pot_ / 2;
         villainStack_ += pot_ / 2;
     } else {
         villainStack_ += pot_;
-        villainHandsWon_++;
     }
 
     pot_ = 0;
-    showdownCount_++;
 }
 
 Simulation::SimHandResult Simulation::playSingleHand() {
+    uint64_t handSeed = splitmix64(seed_ ^ splitmix64(handIndex_++));
+    rng_.reseed(handSeed);
+    hero_.engine().seed(handSeed + 1);
     shuffleDeck();
 
-    // Track starting stacks for profit calculation
-    int64_t heroStartStack = heroStack_;
-
-    // Cap stacks at 200 BB to simulate real poker (you'd leave table or cash out)
-    const int64_t maxStack = 200 * bb_;
+    // Cap stacks at maxStackBB to simulate real poker (you'd leave table or cash out)
+    const int64_t maxStack = static_cast<int64_t>(maxStackBB_) * bb_;
     if (heroStack_ > maxStack) heroStack_ = maxStack;
     if (villainStack_ > maxStack) villainStack_ = maxStack;
-    // Rebuy if below 20 BB
-    const int64_t minStack = 100 * bb_;
+    // Rebuy if below minStackBB
+    const int64_t minStack = static_cast<int64_t>(minStackBB_) * bb_;
     if (heroStack_ < minStack) heroStack_ = minStack;
     if (villainStack_ < minStack) villainStack_ = minStack;
 
+    // Track starting stack for profit calculation (after rebuy/cash-out, so
+    // those adjustments never count as won or lost chips)
+    int64_t heroStartStack = heroStack_;
+
     // Reset for new hand
     pot_ = 0;
 
@@ -430,10 +343,13 @@ Simulation::SimHandResult Simulation::playSingleHand() {
 
     // Deal hole cards
     dealHoleCards();
+    hero_.beginHand(heroPosition_, heroCards_, villainPosition_);
+    villainEquityBoard_ = -1;
 
     bool handOver = false;
     bool heroWon = false;
     bool reachedShowdown = false;
+    Street street = Street::Preflop;
 
     int64_t currentBet = 0;  // Highest bet in current street
     int64_t heroBetThisStreet = 0;
@@ -445,7 +361,7 @@ Simulation::SimHandResult Simulation::playSingleHand() {
     heroBetThisStreet = sb_;
     villainBetThisStreet = bb_;
 
-    Decision heroDecision = getHeroDecision(false, 0);
+    Decision heroDecision = getHeroDecision(Street::Preflop, currentBet, currentBet - heroBetThisStreet);
 
     if (heroDecision.action == Action::Fold) {
         handOver = true;
@@ -453,7 +369,8 @@ Simulation::SimHandResult Simulation::playSingleHand() {
         villainStack_ += pot_;
         pot_ = 0;
     } else if (heroDecision.action == Action::Raise) {
-        int64_t raiseAmt = heroDecision.amount;
+        // Raise-to amount; an all-in can't exceed what hero has behind
+        int64_t raiseAmt = std::min(heroDecision.amount, heroStack_ + heroBetThisStreet);
         int64_t toCall = raiseAmt - heroBetThisStreet;
 
         heroStack_ -= toCall;
@@ -464,7 +381,7 @@ Simulation::SimHandResult Simulation::playSingleHand() {
 
         // Villain responds
         int64_t villainFacing = currentBet - villainBetThisStreet;
-        Action villainAction = getOpponentAction(villainPosition_, villainCards_, villainFacing, false);
+        Action villainAction = villainActs(Street::Preflop, villainFacing, false);
 
         if (villainAction == Action::Fold) {
             handOver = true;
@@ -504,7 +421,7 @@ Simulation::SimHandResult Simulation::playSingleHand() {
         villainBetThisStreet = 0;
 
         // Villain (OOP in BB) acts first
-        Action villainAction = getOpponentAction(villainPosition_, villainCards_, 0, true);
+        Action villainAction = villainActs(street, 0, true);
 
         if (villainAction == Action::Bet || villainAction == Action::Raise) {
             int64_t betAmt = (pot_ * 2) / 3; // ~66% pot
@@ -517,7 +434,7 @@ Simulation::SimHandResult Simulation::playSingleHand() {
             currentBet = betAmt;
 
             // Hero responds
-            Decision heroDecision = getHeroDecision(true, currentBet - heroBetThisStreet);
+            Decision heroDecision = getHeroDecision(street, currentBet, currentBet - heroBetThisStreet);
 
             if (heroDecision.action == Action::Fold) {
                 handOver = true;
@@ -544,7 +461,7 @@ Simulation::SimHandResult Simulation::playSingleHand() {
 
                 // Villain responds to raise - simplify by calling or folding
                 int64_t villainFacing = currentBet - villainBetThisStreet;
-                Action vResponse = getOpponentAction(villainPosition_, villainCards_, villainFacing, false);
+                Action vResponse = villainActs(street, villainFacing, false);
 
                 if (vResponse == Action::Fold) {
                     handOver = true;
@@ -562,7 +479,7 @@ Simulation::SimHandResult Simulation::playSingleHand() {
         } else {
             // Villain checks
             // Hero acts
-            Decision heroDecision = getHeroDecision(false, 0);
+            Decision heroDecision = getHeroDecision(street, 0, 0);
 
             if (heroDecision.action == Action::Bet) {
                 int64_t betAmt = heroDecision.amount;
@@ -576,7 +493,7 @@ Simulation::SimHandResult Simulation::playSingleHand() {
 
                 // Villain responds
                 int64_t villainFacing = currentBet - villainBetThisStreet;
-                Action vResponse = getOpponentAction(villainPosition_, villainCards_, villainFacing, false);
+                Action vResponse = villainActs(street, villainFacing, false);
 
                 if (vResponse == Action::Fold) {
                     handOver = true;
@@ -615,24 +532,28 @@ Simulation::SimHandResult Simulation::playSingleHand() {
 
     // === FLOP ===
     if (!handOver) {
+        street = Street::Flop;
         dealFlop();
         handOver = runBettingRound(true, false, false);
     }
 
     // === TURN ===
     if (!handOver) {
+        street = Street::Turn;
         dealTurn();
         handOver = runBettingRound(false, true, false);
     }
 
     // === RIVER ===
     if (!handOver) {
+        street = Street::River;
         dealRiver();
         handOver = runBettingRound(false, false, true);
     }
 
     // === SHOWDOWN ===
     if (!handOver) {
+        street = Street::Showdown;
         reachedShowdown = true;
         settleShowdown();
         heroWon = (heroStack_ > heroStartStack);
@@ -641,73 +562,183 @@ Simulation::SimHandResult Simulation::playSingleHand() {
     // Calculate profit (stack change from start)
     int64_t profit = heroStack_ - heroStartStack;
 
-    return SimHandResult{heroWon, profit, reachedShowdown, heroWon};
+    if (handRows_) {
+        handRows_->push_back(HandDb::row(heroPosition_, heroCards_.cards[0], heroCards_.cards[1], board_,
+                                         hero_.session().actions().since(0), reachedShowdown, profit, bb_));
+    }
+
+    return SimHandResult{heroWon, profit, reachedShowdown, heroWon, street, heroPosition_};
+}
+
+void Simulation::recordResult(const SimHandResult& result) {
+    // At showdown the winner is whoever won the showdown; otherwise whoever didn't fold
+    bool won = result.reachedShowdown ? result.heroWonShowdown : result.won;
+    stats_.add(result.profit, result.heroPosition, result.endStreet, won, result.reachedShowdown);
+}
+
+void Simulation::setCheckpoint(std::string path, int everyHands) {
+    checkpointPath_ = std::move(path);
+    checkpointEvery_ = everyHands;
+}
+
+SimConfig Simulation::configFrom(const Checkpoint& checkpoint) {
+    SimConfig config;
+    config.numHands = static_cast<int>(checkpoint.getInt("config.hands"));
+    config.opponent = static_cast<OpponentType>(checkpoint.getInt("config.opponent"));
+    config.sb = static_cast<int>(checkpoint.getInt("config.sb"));
+    config.bb = static_cast<int>(checkpoint.getInt("config.bb"));
+    config.minStackBB = static_cast<int>(checkpoint.getInt("config.min_stack_bb"));
+    config.maxStackBB = static_cast<int>(checkpoint.getInt("config.max_stack_bb"));
+    config.seed = checkpoint.getUint("config.seed");
+    config.equityIterations = static_cast<int>(checkpoint.getInt("config.equity_iterations"));
+    config.riverSolveIterations = static_cast<int>(checkpoint.getInt("config.river_solve_iterations"));
+    // Runs saved before tracking was optional always had it on
+    config.rangeTracking = checkpoint.getInt("config.range_tracking", 1) != 0;
+    return config;
+}
+
+void Simulation::saveState(Checkpoint& checkpoint) const {
+    checkpoint.setInt("config.seats", 0);   // Heads-up
+    checkpoint.setInt("config.hands", numHands_);
+    checkpoint.setInt("config.opponent", static_cast<int>(opponentType_));
+    checkpoint.setInt("config.sb", sb_);
+    checkpoint.setInt("config.bb", bb_);
+    checkpoint.setInt("config.min_stack_bb", minStackBB_);
+    checkpoint.setInt("config.max_stack_bb", maxStackBB_);
+    checkpoint.setUint("config.seed", seed_);
+    checkpoint.setInt("config.equity_iterations", equityIterations_);
+    checkpoint.setInt("config.river_solve_iterations", riverSolveIterations_);
+    checkpoint.setInt("config.range_tracking", rangeTracking_ ? 1 : 0);
+    checkpoint.setDouble("config.target_ci", targetCi_);
+
+    // Every hand reseeds from (seed, hand index), so the index is the whole RNG state
+    checkpoint.setUint("hand_index", handIndex_);
+    checkpoint.setInt("hero_stack", heroStack_);
+    checkpoint.setInt("villain_stack", villainStack_);
+    stats_.save(checkpoint);
+
+    const PlayerStats& villain = hero_.villainStats();
+    for (int i = 0; i < kNumStats; ++i) {
+        checkpoint.setUint(std::format("villain_stats.{}", i), villain.counts[i]);
+    }
+}
+
+void Simulation::restoreState(const Checkpoint& checkpoint) {
+    targetCi_ = checkpoint.getDouble("config.target_ci");
+    handIndex_ = checkpoint.getUint("hand_index");
+    heroStack_ = checkpoint.getInt("hero_stack");
+    villainStack_ = checkpoint.getInt("villain_stack");
+    stats_.load(checkpoint);
+
+    PlayerStats& villain = hero_.villainStats();
+    for (int i = 0; i < kNumStats; ++i) {
+        villain.counts[i] = static_cast<uint32_t>(checkpoint.getUint(std::format("villain_stats.{}", i)));
+    }
+}
+
+void Simulation::writeCheckpoint() {
+    Checkpoint checkpoint;
+    saveState(checkpoint);
+    if (!checkpoint.save(checkpointPath_)) {
+        std::cerr << "\nWarning: could not write checkpoint " << checkpointPath_ << "\n";
+    }
 }
 
 void Simulation::run() {
     std::cout << "\n=== SHARKWAVE SIMULATION ===\n";
-    std::cout << "Running " << numHands_ << " hands vs ";
-
-    switch (opponentType_) {
-        case OpponentType::Random: std::cout << "Random"; break;
-        case OpponentType::TightPassive: std::cout << "Tight Passive"; break;
-        case OpponentType::LooseAggressive: std::cout << "Loose Aggressive"; break;
-        case OpponentType::CallingStation: std::cout << "Calling Station"; break;
+    std::cout << "Running " << numHands_ << " hands vs " << opponentToString(opponentType_) << " opponent";
+    if (targetCi_ > 0.0) {
+        std::cout << " (stopping at +/-" << targetCi_ << " BB/100)";
     }
-    std::cout << " opponent...\n\n";
-
-    int64_t totalProfit = 0;
-    int wins = 0;
-    int losses = 0;
-    int showdowns = 0;
-
-    for (int i = 0; i < numHands_; ++i) {
-        SimHandResult result = playSingleHand();
-        totalProfit += result.profit;
-
-        if (result.reachedShowdown) {
-            showdowns++;
-            if (result.heroWonShowdown) wins++;
-            else losses++;
-        } else if (result.won) {
-            // Won by opponent folding preflop or postflop
-            wins++;
-        } else {
-            // We folded - lose the chips we put in
-            losses++;
+    std::cout << "...\n\n";
+    if (handsPlayed() > 0) {
+        std::cout << "Resuming after " << handsPlayed() << " hands.\n";
+    }
+
+    // Too few hands give a meaningless variance estimate, so never stop before this
+    constexpr int minHandsForCi = 1000;
+    const bool checkpointing = !checkpointPath_.empty() && checkpointEvery_ > 0;
+
+    for (int i = handsPlayed(); i < numHands_; ++i) {
+        recordResult(playSingleHand());
+
+        if (checkpointing && (i + 1) % checkpointEvery_ == 0) {
+            writeCheckpoint();
         }
 
         // Progress indicator
         if ((i + 1) % 100 == 0) {
             std::cout << "  " << (i + 1) << " hands completed...\r" << std::flush;
         }
-    }
 
-    heroHandsWon_ = wins;
-    villainHandsWon_ = losses;
-    heroTotalProfit_ = totalProfit;
-    showdownCount_ = showdowns;
+        if (targetCi_ > 0.0 && i + 1 >= minHandsForCi && (i + 1) % 100 == 0 &&
+            toBbPer100(stats_.profit.ci95()) <= targetCi_) {
+            std::cout << "\n\nTarget CI reached after " << (i + 1) << " hands.";
+            numHands_ = i + 1;  // A resumed checkpoint of this run has nothing left to play
+            break;
+        }
+    }
 
+    if (checkpointing) writeCheckpoint();
     std::cout << "\n\nSimulation complete!\n";
 }
 
+void Simulation::playHands(int count) {
+    for (int i = 0; i < count; ++i) {
+        recordResult(playSingleHand());
+    }
+}
+
 void Simulation::printResults() {
+    printStats(stats_, bb_);
+}
+
+void Simulation::printStats(const SimStats& stats, int bb) {
+    int64_t hands = stats.profit.count();
+    if (hands == 0) {
+        std::cout << "\nNo hands played.\n";
+        return;
+    }
+
+    auto toBbPer100 = [bb](double chipsPerHand) { return chipsPerHand / bb * 100.0; };
+
     std::cout << "\n=== RESULTS ===\n";
-    std::cout << "Hands played:     " << numHands_ << "\n";
-    std::cout << "Hands won:        " << heroHandsWon_ << " (" << (100.0 * heroHandsWon_ / numHands_) << "%)\n";
-    std::cout << "Hands lost:       " << villainHandsWon_ << " (" << (100.0 * villainHandsWon_ / numHands_) << "%)\n";
-    std::cout << "Showdowns:        " << showdownCount_ << "\n";
+    std::cout << "Hands played:     " << hands << "\n";
+    std::cout << "Hands won:        " << stats.wins << " (" << (100.0 * stats.wins / hands) << "%)\n";
+    std::cout << "Hands lost:       " << stats.losses << " (" << (100.0 * stats.losses / hands) << "%)\n";
+    std::cout << "Showdowns:        " << stats.showdowns << "\n";
 
     std::cout << "\n";
-    std::cout << "Total profit:     " << heroTotalProfit_ << " chips\n";
-    std::cout << "Profit/100 hands: " << (100.0 * heroTotalProfit_ / numHands_) << " chips\n";
-    std::cout << "BB/100:           " << (heroTotalProfit_ / (double)numHands_ / bb_ * 100) << "\n";
-    std::cout << "ROI:              " << (100.0 * heroTotalProfit_ / (numHands_ * 1000.0)) << "%\n";
+    std::cout << "Total profit:     " << stats.totalProfit << " chips\n";
+    std::cout << "Profit/100 hands: " << (100.0 * stats.totalProfit / hands) << " chips\n";
+    std::cout << std::format("BB/100:           {:.2f} +/- {:.2f} (95% CI)\n",
+                             toBbPer100(stats.profit.mean()), toBbPer100(stats.profit.ci95()));
+    std::cout << std::format("Std dev:          {:.1f} BB/100\n",
+                             toBbPer100(stats.profit.stddev()) / 10.0);
+    std::cout << "ROI:              " << (100.0 * stats.totalProfit / (hands * 1000.0)) << "%\n";
+
+    std::cout << "\nBy position:\n";
+    for (Position pos : positions) {
+        const RunningStats& s = stats.byPosition[static_cast<int>(pos)];
+        if (s.count() == 0) continue;
+        std::cout << std::format("  {:<9} {:>9} hands  {:>9.2f} +/- {:.2f} BB/100\n",
+                                 GameSession::positionToString(pos), s.count(),
+                                 toBbPer100(s.mean()), toBbPer100(s.ci95()));
+    }
+
+    std::cout << "\nBy final street:\n";
+    for (int st = 0; st < static_cast<int>(stats.byStreet.size()); ++st) {
+        const RunningStats& s = stats.byStreet[st];
+        if (s.count() == 0) continue;
+        std::cout << std::format("  {:<9} {:>9} hands  {:>9.2f} +/- {:.2f} BB/100\n",
+                                 GameSession::streetToString(static_cast<Street>(st)), s.count(),
+                                 toBbPer100(s.mean()), toBbPer100(s.ci95()));
+    }
     std::cout << "\n";
 
-    if (heroTotalProfit_ > 0) {
+    if (stats.totalProfit > 0) {
         std::cout << ">>> SHARKWAVE IS WINNING <<<\n";
-    } else if (heroTotalProfit_ < 0) {
+    } else if (stats.totalProfit < 0) {
         std::cout << ">>> SHARKWAVE IS LOSING <<<\n";
     } else {
         std::cout << ">>> BREAK EVEN <<<\n";
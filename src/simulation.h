@@ -1,9 +1,18 @@
 #pragma once
 
 #include "card.h"
+#include "checkpoint.h"
 #include "game_session.h"
 #include "decision_engine.h"
-#include <random>
+#include "engine_adapter.h"
+#include "hand_db.h"
+#include "rng.h"
+#include "stats.h"
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace sharkwave {
 
@@ -15,20 +24,88 @@ enum class OpponentType {
     CallingStation // Calls too much, rarely folds
 };
 
+// Per-hand profit statistics accumulated over a run (chips per hand)
+struct SimStats {
+    RunningStats profit;
+    std::array<RunningStats, 6> byPosition{};   // indexed by hero Position
+    std::array<RunningStats, 5> byStreet{};     // indexed by the Street the hand ended on
+    int wins = 0;
+    int losses = 0;
+    int showdowns = 0;
+    int64_t totalProfit = 0;
+
+    void add(int64_t handProfit, Position heroPosition, Street endStreet,
+             bool won, bool reachedShowdown);
+    void merge(const SimStats& other);
+
+    void save(Checkpoint& checkpoint) const;
+    void load(const Checkpoint& checkpoint);
+};
+
+struct SimConfig {
+    int numHands = 1000;
+    OpponentType opponent = OpponentType::Random;
+    int sb = 5;
+    int bb = 10;
+    int minStackBB = 100;   // Rebuy to this when below
+    int maxStackBB = 200;   // Leave the table with anything above
+    uint64_t seed = 0;      // 0 = seed from std::random_device
+    int equityIterations = 100;     // Monte Carlo samples per equity estimate, both players
+    int riverSolveIterations = 0;   // CFR+ iterations for hero's river spots; 0 = rule-based
+    bool rangeTracking = false;     // Hero weighs equity by villain's range; half the hands/sec
+};
+
+// Heads-up simulator: the hero seat is played by the real DecisionEngine
 class Simulation {
 public:
     Simulation(int numHands = 1000, OpponentType oppType = OpponentType::Random);
+    explicit Simulation(const SimConfig& config);
     void run();
     void printResults();
 
+    // Print a results block for any run's stats
+    static void printStats(const SimStats& stats, int bb);
+
+    // Play hands without any console output, accumulating into stats()
+    void playHands(int count);
+
+    static std::string opponentToString(OpponentType type);
+    static std::optional<OpponentType> parseOpponent(std::string_view name);
+
+    // Stop early once the 95% CI half-width of BB/100 is at or below this (0 = off)
+    void setTargetCi(double bbPer100) { targetCi_ = bbPer100; }
+
+    // Thresholds the hero's DecisionEngine plays with
+    void setStrategy(const StrategyParams& params) { hero_.engine().setParams(params); }
+
+    const SimStats& stats() const { return stats_; }
+
+    // Adds hero's HandDb row for every hand played to `rows`; nullptr stops
+    void setHandRows(std::vector<HandRow>* rows) { handRows_ = rows; }
+    int handsPlayed() const { return static_cast<int>(stats_.profit.count()); }
+
+    // Save the full run state to `path` every `everyHands` hands and when
+    // run() finishes. A Simulation built from configFrom() and restored from
+    // that file continues exactly as the uninterrupted run would have.
+    void setCheckpoint(std::string path, int everyHands);
+    void saveState(Checkpoint& checkpoint) const;
+    void restoreState(const Checkpoint& checkpoint);
+    static SimConfig configFrom(const Checkpoint& checkpoint);
+
 private:
     struct SimHandResult {
         bool won;
         int64_t profit;
         bool reachedShowdown;
         bool heroWonShowdown;
+        Street endStreet;
+        Position heroPosition;
     };
 
+    void recordResult(const SimHandResult& result);
+    void writeCheckpoint();
+    double toBbPer100(double chipsPerHand) const { return chipsPerHand / bb_ * 100.0; }
+
     SimHandResult playSingleHand();
     Card dealCard();
     void dealHoleCards();
@@ -38,12 +115,22 @@ private:
     void shuffleDeck();
 
     Action getOpponentAction(Position pos, const CardSet& holeCards, int64_t facingBet, bool canCheck);
-    Decision getHeroDecision(bool facingBet, int64_t facingAmt);
+    // The villain's action, logged with hero's engine so it can narrow the villain's range
+    Action villainActs(Street street, int64_t facingBet, bool canCheck);
+    Decision getHeroDecision(Street street, int64_t currentBet, int64_t toCall);
 
     void settleShowdown();
 
     int numHands_;
     OpponentType opponentType_;
+    double targetCi_;
+    int equityIterations_;
+    int riverSolveIterations_;
+    bool rangeTracking_;
+    SimStats stats_;
+
+    std::string checkpointPath_;
+    int checkpointEvery_;
 
     // Deck state
     std::array<Card, 52> deck_;
@@ -58,16 +145,23 @@ private:
     int64_t villainStack_;
     int64_t pot_;
 
+    // Villain's equity on the current street (board size it was computed for, -1 = none)
+    double villainEquity_;
+    int villainEquityBoard_;
+
     int sb_, bb_;
-    int heroHandsWon_;
-    int villainHandsWon_;
-    int64_t heroTotalProfit_;
-    int showdownCount_;
+    int minStackBB_, maxStackBB_;
 
     Position heroPosition_;
     Position villainPosition_;
 
-    std::mt19937 rng_;
+    // Each hand's cards and villain randomness come from (seed_, hand index)
+    // alone, so runs sharing a seed deal identical hands whatever hero does
+    uint64_t seed_;
+    uint64_t handIndex_;
+    Rng rng_;
+    EngineAdapter hero_;
+    std::vector<HandRow>* handRows_ = nullptr;
 
     static constexpr Position positions[] = {
         Position::UTG, Position::MP, Position::CO,
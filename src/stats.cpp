@@ -0,0 +1,62 @@
+#include "stats.h"
+#include <cmath>
+
+namespace sharkwave {
+
+void RunningStats::add(double x) {
+    ++count_;
+    double delta = x - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (x - mean_);
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count_ == 0) return;
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+
+    // Chan et al. pairwise combination
+    int64_t total = count_ + other.count_;
+    double delta = other.mean_ - mean_;
+    double n1 = static_cast<double>(count_);
+    double n2 = static_cast<double>(other.count_);
+    mean_ += delta * n2 / static_cast<double>(total);
+    m2_ += other.m2_ + delta * delta * n1 * n2 / static_cast<double>(total);
+    count_ = total;
+}
+
+RunningStats RunningStats::fromState(int64_t count, double mean, double m2) {
+    RunningStats stats;
+    stats.count_ = count;
+    stats.mean_ = mean;
+    stats.m2_ = m2;
+    return stats;
+}
+
+void RunningStats::reset() {
+    count_ = 0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+}
+
+double RunningStats::variance() const {
+    if (count_ < 2) return 0.0;
+    return m2_ / static_cast<double>(count_ - 1);
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(variance());
+}
+
+double RunningStats::standardError() const {
+    if (count_ < 2) return 0.0;
+    return stddev() / std::sqrt(static_cast<double>(count_));
+}
+
+double RunningStats::ci95() const {
+    return 1.96 * standardError();
+}
+
+} // namespace sharkwave
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace sharkwave {
+
+// Running mean and variance (Welford). Mergeable, so partial results from
+// separate runs or threads can be combined without keeping samples.
+class RunningStats {
+public:
+    void add(double x);
+    void merge(const RunningStats& other);
+    void reset();
+
+    int64_t count() const { return count_; }
+    double mean() const { return mean_; }
+    double variance() const;        // Sample variance
+    double stddev() const;
+    double standardError() const;   // Standard error of the mean
+    double ci95() const;            // Half-width of the 95% confidence interval
+
+    // Raw accumulator state, for checkpointing
+    double sumSquaredDeviations() const { return m2_; }
+    static RunningStats fromState(int64_t count, double mean, double m2);
+
+private:
+    int64_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+};
+
+} // namespace sharkwave
@@ -0,0 +1,110 @@
+#include "sweep.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <format>
+#include <mutex>
+#include <random>
+
+namespace sharkwave {
+
+namespace {
+    struct CellState {
+        std::mutex mutex;
+        SimStats stats;
+        bool done = false;
+    };
+}
+
+Sweep::Sweep(SweepConfig config)
+    : config_(std::move(config))
+{
+}
+
+std::vector<SweepCell> Sweep::run() {
+    std::vector<SweepCell> cells;
+    for (OpponentType opp : config_.opponents) {
+        for (const StackDepth& stack : config_.stacks) {
+            for (const BlindLevel& blinds : config_.blinds) {
+                cells.push_back({opp, stack, blinds, {}});
+            }
+        }
+    }
+
+    uint64_t baseSeed = config_.seed != 0 ? config_.seed : std::random_device{}();
+    int chunkHands = std::max(1, config_.chunkHands);
+    int chunksPerCell = (config_.handsPerCell + chunkHands - 1) / chunkHands;
+
+    std::vector<CellState> states(cells.size());
+    ThreadPool pool(config_.threads);
+
+    // Interleave cells so every cell makes progress from the start
+    for (int chunk = 0; chunk < chunksPerCell; ++chunk) {
+        for (size_t c = 0; c < cells.size(); ++c) {
+            int hands = std::min(chunkHands, config_.handsPerCell - chunk * chunkHands);
+            pool.submit([this, &cells, &states, c, chunk, hands, baseSeed] {
+                CellState& state = states[c];
+                {
+                    std::lock_guard lock(state.mutex);
+                    if (state.done) return;
+                }
+
+                const SweepCell& cell = cells[c];
+                SimConfig simConfig;
+                simConfig.numHands = hands;
+                simConfig.opponent = cell.opponent;
+                simConfig.sb = cell.blinds.sb;
+                simConfig.bb = cell.blinds.bb;
+                simConfig.minStackBB = cell.stack.minBB;
+                simConfig.maxStackBB = cell.stack.maxBB;
+                simConfig.equityIterations = config_.equityIterations;
+                simConfig.seed = splitmix64(baseSeed ^ splitmix64((c << 32) | static_cast<uint64_t>(chunk)));
+
+                Simulation sim(simConfig);
+                sim.playHands(hands);
+
+                std::lock_guard lock(state.mutex);
+                state.stats.merge(sim.stats());
+                if (config_.targetCi > 0.0 && state.stats.profit.count() >= 1000 &&
+                    state.stats.profit.ci95() / cell.blinds.bb * 100.0 <= config_.targetCi) {
+                    state.done = true;
+                }
+            });
+        }
+    }
+    pool.wait();
+
+    for (size_t c = 0; c < cells.size(); ++c) {
+        cells[c].stats = states[c].stats;
+    }
+    return cells;
+}
+
+void Sweep::writeCsv(std::ostream& out, const std::vector<SweepCell>& cells) {
+    out << "opponent,min_stack_bb,max_stack_bb,sb,bb,hands,bb_per_100,ci95_bb_per_100\n";
+    for (const SweepCell& cell : cells) {
+        out << std::format("{},{},{},{},{},{},{:.3f},{:.3f}\n",
+                           Simulation::opponentToString(cell.opponent),
+                           cell.stack.minBB, cell.stack.maxBB,
+                           cell.blinds.sb, cell.blinds.bb,
+                           cell.stats.profit.count(), cell.bbPer100(), cell.ci95BbPer100());
+    }
+}
+
+void Sweep::writeJson(std::ostream& out, const std::vector<SweepCell>& cells) {
+    out << "[\n";
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const SweepCell& cell = cells[i];
+        out << std::format("  {{\"opponent\": \"{}\", \"min_stack_bb\": {}, \"max_stack_bb\": {}, "
+                           "\"sb\": {}, \"bb\": {}, \"hands\": {}, "
+                           "\"bb_per_100\": {:.3f}, \"ci95_bb_per_100\": {:.3f}}}{}\n",
+                           Simulation::opponentToString(cell.opponent),
+                           cell.stack.minBB, cell.stack.maxBB,
+                           cell.blinds.sb, cell.blinds.bb,
+                           cell.stats.profit.count(), cell.bbPer100(), cell.ci95BbPer100(),
+                           i + 1 < cells.size() ? "," : "");
+    }
+    out << "]\n";
+}
+
+} // namespace sharkwave
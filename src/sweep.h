@@ -0,0 +1,56 @@
+#pragma once
+
+#include "simulation.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace sharkwave {
+
+struct StackDepth {
+    int minBB;  // Rebuy level
+    int maxBB;  // Cash-out level
+};
+
+struct BlindLevel {
+    int sb;
+    int bb;
+};
+
+struct SweepConfig {
+    std::vector<OpponentType> opponents;
+    std::vector<StackDepth> stacks;
+    std::vector<BlindLevel> blinds;
+    int handsPerCell = 10000;
+    int chunkHands = 1000;     // Hands per scheduled task
+    double targetCi = 0.0;     // Skip a cell's remaining chunks once its CI is this tight (BB/100)
+    uint64_t seed = 0;         // 0 = random
+    size_t threads = 0;        // 0 = hardware concurrency
+    int equityIterations = SimConfig{}.equityIterations;
+};
+
+struct SweepCell {
+    OpponentType opponent;
+    StackDepth stack;
+    BlindLevel blinds;
+    SimStats stats;
+
+    double bbPer100() const { return stats.profit.mean() / blinds.bb * 100.0; }
+    double ci95BbPer100() const { return stats.profit.ci95() / blinds.bb * 100.0; }
+};
+
+// Runs every opponent x stack depth x blind level cell on one shared worker
+// pool. Each cell is split into chunks so short cells don't leave threads idle.
+class Sweep {
+public:
+    explicit Sweep(SweepConfig config);
+    std::vector<SweepCell> run();
+
+    static void writeCsv(std::ostream& out, const std::vector<SweepCell>& cells);
+    static void writeJson(std::ostream& out, const std::vector<SweepCell>& cells);
+
+private:
+    SweepConfig config_;
+};
+
+} // namespace sharkwave
@@ -0,0 +1,687 @@
+#include "table_simulation.h"
+#include "gto_charts.h"
+#include "hand_evaluator.h"
+#include "profiler.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+
+namespace sharkwave {
+
+namespace {
+    constexpr int kMaxRaises = 4;          // Per street; further raises become calls
+    constexpr uint32_t kRankBits = 0x1FFF;
+
+    // 13-bit set of ranks present in a card mask, any suit
+    uint32_t rankSet(CardMask cards) {
+        return static_cast<uint32_t>((cards | (cards >> 13) | (cards >> 26) | (cards >> 39)) & kRankBits);
+    }
+
+    bool hasRank(uint32_t ranks, int r) {
+        return (ranks >> (r - 2)) & 1u;
+    }
+}
+
+TableSimulation::TableSimulation(const TableConfig& config)
+    : config_(config)
+    , numSeats_(std::clamp(config.seats, MIN_SEATS, MAX_SEATS))
+    , targetCi_(0.0)
+    , seats_{}
+    , deck_{}
+    , deckIndex_(0)
+    , boardMask_(0)
+    , boardCount_(0)
+    , button_(numSeats_ - 1)    // Advances to seat 0 on the first hand
+    , sbSeat_(0)
+    , bbSeat_(0)
+    , currentBet_(0)
+    , lastRaise_(0)
+    , preflopAggressor_(-1)
+    , heroStartStack_(0)
+    , heroEndStreet_(Street::Preflop)
+    , rng_(config.seed != 0 ? config.seed : std::random_device{}())
+    , elapsedSeconds_(0.0)
+    , elapsedHands_(0)
+    , checkpointEvery_(0)
+{
+    for (int i = 0; i < 52; ++i) {
+        deck_[i] = static_cast<uint8_t>(i);
+    }
+    for (int s = 0; s < numSeats_; ++s) {
+        seats_[s].stack = config_.minStackBB * config_.bb;
+    }
+}
+
+int TableSimulation::countStatus(SeatStatus status) const {
+    int n = 0;
+    for (int s = 0; s < numSeats_; ++s) {
+        if (seats_[s].status == status) ++n;
+    }
+    return n;
+}
+
+int TableSimulation::countInHand() const {
+    return numSeats_ - countStatus(SeatStatus::Folded);
+}
+
+void TableSimulation::assignPositions() {
+    if (numSeats_ == 2) {
+        // Heads up: the button posts the small blind and acts first preflop
+        sbSeat_ = button_;
+        bbSeat_ = nextSeat(button_);
+    } else {
+        sbSeat_ = nextSeat(button_);
+        bbSeat_ = nextSeat(sbSeat_);
+    }
+
+    for (int s = 0; s < numSeats_; ++s) {
+        int seatsBeforeButton = (button_ - s + numSeats_) % numSeats_;
+        Position pos;
+        if (seatsBeforeButton == 0)   pos = Position::BTN;
+        else if (s == sbSeat_)        pos = Position::SB;
+        else if (s == bbSeat_)        pos = Position::BB;
+        else if (seatsBeforeButton == 1) pos = Position::CO;
+        else if (seatsBeforeButton == 2) pos = Position::MP;
+        else                          pos = Position::UTG; // 7-9 handed: every early seat plays UTG ranges
+        seats_[s].position = pos;
+    }
+}
+
+void TableSimulation::commit(int seat, int32_t chips) {
+    SeatState& s = seats_[seat];
+    chips = std::min(chips, s.stack);
+    s.stack -= chips;
+    s.streetBet += chips;
+    s.invested += chips;
+    if (s.stack == 0 && s.status == SeatStatus::Active) {
+        s.status = SeatStatus::AllIn;
+    }
+}
+
+void TableSimulation::startHand() {
+    const int32_t minStack = config_.minStackBB * config_.bb;
+    const int32_t maxStack = config_.maxStackBB * config_.bb;
+
+    for (int s = 0; s < numSeats_; ++s) {
+        SeatState& seat = seats_[s];
+        // Rebuy below the minimum, leave with the excess above the maximum
+        seat.stack = std::clamp(seat.stack, minStack, maxStack);
+        seat.streetBet = 0;
+        seat.invested = 0;
+        seat.status = SeatStatus::Active;
+    }
+
+    button_ = nextSeat(button_);
+    assignPositions();
+
+    // Partial Fisher-Yates: only the cards this hand can use
+    {
+        SHARKWAVE_PROFILE_SCOPE(Shuffle);
+        int needed = numSeats_ * 2 + 5;
+        for (int i = 0; i < needed; ++i) {
+            int j = i + static_cast<int>(rng_.below(52 - i));
+            std::swap(deck_[i], deck_[j]);
+        }
+    }
+    for (int s = 0; s < numSeats_; ++s) {
+        seats_[s].hole[0] = deck_[s];
+        seats_[s].hole[1] = deck_[numSeats_ + s];
+    }
+    deckIndex_ = numSeats_ * 2;
+    boardMask_ = 0;
+    boardCount_ = 0;
+
+    heroStartStack_ = seats_[HERO_SEAT].stack;
+    heroEndStreet_ = Street::Preflop;
+    preflopAggressor_ = -1;
+
+    commit(sbSeat_, config_.sb);
+    commit(bbSeat_, config_.bb);
+    currentBet_ = config_.bb;
+    lastRaise_ = config_.bb;
+}
+
+void TableSimulation::dealBoard(int cards) {
+    for (int i = 0; i < cards; ++i) {
+        boardMask_ |= CardMask{1} << deck_[deckIndex_++];
+        ++boardCount_;
+    }
+}
+
+bool TableSimulation::bettingRound(Street street) {
+    if (street != Street::Preflop) {
+        for (int s = 0; s < numSeats_; ++s) seats_[s].streetBet = 0;
+        currentBet_ = 0;
+        lastRaise_ = config_.bb;
+    }
+
+    int pending = countStatus(SeatStatus::Active);
+    if (pending == 0) return false;     // Everyone left is all-in; just run the board out
+    if (pending == 1) {
+        // A lone active player only acts if they still owe chips
+        for (int s = 0; s < numSeats_; ++s) {
+            if (seats_[s].status == SeatStatus::Active && seats_[s].streetBet >= currentBet_) {
+                return false;
+            }
+        }
+    }
+
+    int seat;
+    if (street == Street::Preflop) {
+        seat = (numSeats_ == 2) ? button_ : nextSeat(bbSeat_);
+    } else {
+        seat = nextSeat(button_);
+    }
+    int raises = (street == Street::Preflop) ? 1 : 0;  // The big blind is the first bet
+
+    while (pending > 0) {
+        SeatState& s = seats_[seat];
+        if (s.status == SeatStatus::Active) {
+            SeatAction act = decide(seat, street, raises);
+            int32_t facing = currentBet_ - s.streetBet;
+
+            if (act.action == Action::Fold && facing > 0) {
+                s.status = SeatStatus::Folded;
+                if (seat == HERO_SEAT) heroEndStreet_ = street;
+                --pending;
+                if (countInHand() == 1) return true;
+            } else if (act.action == Action::Bet || act.action == Action::Raise) {
+                int32_t maxTo = s.streetBet + s.stack;
+                int32_t minTo = currentBet_ + lastRaise_;
+                int32_t to = std::min(std::max(act.amount, minTo), maxTo);
+
+                if (to <= currentBet_ || raises >= kMaxRaises) {
+                    commit(seat, facing);   // Can't raise any more: just call
+                } else {
+                    lastRaise_ = std::max(lastRaise_, to - currentBet_);
+                    currentBet_ = to;
+                    commit(seat, to - s.streetBet);
+                    ++raises;
+                    if (street == Street::Preflop) preflopAggressor_ = seat;
+                    // Everyone else still active must respond
+                    pending = countStatus(SeatStatus::Active) + (s.status == SeatStatus::Active ? 0 : 1);
+                }
+                --pending;
+            } else {
+                commit(seat, facing);       // Check or call
+                --pending;
+            }
+        }
+        seat = nextSeat(seat);
+    }
+    return false;
+}
+
+void TableSimulation::awardPot(int winner) {
+    int32_t pot = 0;
+    for (int s = 0; s < numSeats_; ++s) pot += seats_[s].invested;
+    seats_[winner].stack += pot;
+}
+
+void TableSimulation::showdown() {
+    SHARKWAVE_PROFILE_SCOPE(Showdown);
+    CardMask holes[MAX_SEATS];
+    HandResult results[MAX_SEATS];
+    int contenders[MAX_SEATS];
+    int n = 0;
+
+    // Walk from the left of the button so odd chips go to the first winner in that order
+    for (int k = 1; k <= numSeats_; ++k) {
+        int s = (button_ + k) % numSeats_;
+        if (seats_[s].status == SeatStatus::Folded) continue;
+        holes[n] = (CardMask{1} << seats_[s].hole[0]) | (CardMask{1} << seats_[s].hole[1]);
+        contenders[n++] = s;
+    }
+    HandEvaluator::evaluateShowdown(boardMask_, holes, n, results);
+
+    int32_t totalPot = 0;
+    for (int s = 0; s < numSeats_; ++s) totalPot += seats_[s].invested;
+
+    // Peel off one pot per distinct all-in level, lowest first
+    int32_t distributed = 0;
+    int32_t prevLevel = 0;
+    int lastWinner = contenders[0];
+    while (true) {
+        int32_t level = INT32_MAX;
+        for (int i = 0; i < n; ++i) {
+            int32_t inv = seats_[contenders[i]].invested;
+            if (inv > prevLevel) level = std::min(level, inv);
+        }
+        if (level == INT32_MAX) break;
+
+        int32_t slice = 0;
+        for (int s = 0; s < numSeats_; ++s) {
+            slice += std::clamp(seats_[s].invested - prevLevel, 0, level - prevLevel);
+        }
+
+        HandResult best{HandRank::HighCard, 0};
+        bool any = false;
+        for (int i = 0; i < n; ++i) {
+            if (seats_[contenders[i]].invested < level) continue;
+            if (!any || results[i] > best) best = results[i];
+            any = true;
+        }
+
+        int winners[MAX_SEATS];
+        int w = 0;
+        for (int i = 0; i < n; ++i) {
+            if (seats_[contenders[i]].invested >= level && results[i] == best) {
+                winners[w++] = contenders[i];
+            }
+        }
+
+        int32_t share = slice / w;
+        for (int i = 0; i < w; ++i) seats_[winners[i]].stack += share;
+        seats_[winners[0]].stack += slice - share * w;
+
+        distributed += slice;
+        lastWinner = winners[0];
+        prevLevel = level;
+    }
+
+    // Chips from folded players above every contender's level
+    seats_[lastWinner].stack += totalPot - distributed;
+}
+
+void TableSimulation::playHand() {
+    startHand();
+
+    Street street = Street::Preflop;
+    bool over = bettingRound(street);
+    if (!over) {
+        street = Street::Flop;
+        dealBoard(3);
+        over = bettingRound(street);
+    }
+    if (!over) {
+        street = Street::Turn;
+        dealBoard(1);
+        over = bettingRound(street);
+    }
+    if (!over) {
+        street = Street::River;
+        dealBoard(1);
+        over = bettingRound(street);
+    }
+
+    bool heroInHand = seats_[HERO_SEAT].status != SeatStatus::Folded;
+    bool reachedShowdown = false;
+    if (over) {
+        for (int s = 0; s < numSeats_; ++s) {
+            if (seats_[s].status != SeatStatus::Folded) awardPot(s);
+        }
+        if (heroInHand) heroEndStreet_ = street;
+    } else {
+        showdown();
+        reachedShowdown = heroInHand;
+        if (heroInHand) heroEndStreet_ = Street::Showdown;
+    }
+
+    int64_t profit = seats_[HERO_SEAT].stack - heroStartStack_;
+    stats_.add(profit, seats_[HERO_SEAT].position, heroEndStreet_, profit > 0, reachedShowdown);
+}
+
+TableSimulation::Strength TableSimulation::strength(int seat) const {
+    const SeatState& s = seats_[seat];
+    CardMask hole = (CardMask{1} << s.hole[0]) | (CardMask{1} << s.hole[1]);
+    CardMask all = hole | boardMask_;
+    HandResult hand = HandEvaluator::evaluate(all);
+
+    uint32_t holeRanks = rankSet(hole);
+    uint32_t boardRanks = rankSet(boardMask_);
+    int topBoard = boardRanks ? 31 - std::countl_zero(boardRanks) + 2 : 0;
+    int primary = static_cast<int>(hand.value >> 48);
+    int secondary = static_cast<int>((hand.value >> 32) & 0xF);
+
+    switch (hand.rank) {
+        case HandRank::ThreeOfAKind:
+            if (hasRank(holeRanks, primary)) return Strength::Monster;
+            break;
+        case HandRank::TwoPair: {
+            bool high = hasRank(holeRanks, primary);
+            bool low = hasRank(holeRanks, secondary);
+            if (high && low) return Strength::Monster;
+            if (high) return primary >= topBoard ? Strength::Strong : Strength::Medium;
+            if (low) return Strength::Medium;
+            break;
+        }
+        case HandRank::OnePair:
+            if (hasRank(holeRanks, primary)) {
+                return primary >= topBoard ? Strength::Strong : Strength::Medium;
+            }
+            break;
+        case HandRank::HighCard:
+            break;
+        default:
+            return Strength::Monster;   // Straight or better
+    }
+
+    // Draws only matter with cards to come
+    if (boardCount_ < 5) {
+        for (int suit = 0; suit < 4; ++suit) {
+            CardMask suitBits = CardMask{kRankBits} << (13 * suit);
+            if (std::popcount(all & suitBits) == 4 && (hole & suitBits)) return Strength::Draw;
+        }
+        uint32_t ranks = holeRanks | boardRanks;
+        uint32_t ext = (ranks << 1) | (ranks >> 12);
+        uint32_t run4 = ext & (ext >> 1) & (ext >> 2) & (ext >> 3);
+        uint32_t boardExt = (boardRanks << 1) | (boardRanks >> 12);
+        uint32_t boardRun4 = boardExt & (boardExt >> 1) & (boardExt >> 2) & (boardExt >> 3);
+        if (run4 & ~boardRun4) return Strength::Draw;
+    }
+    return Strength::Weak;
+}
+
+TableSimulation::SeatAction TableSimulation::betAction(int seat, int32_t toAmount) const {
+    (void)seat;
+    return {currentBet_ == 0 ? Action::Bet : Action::Raise, toAmount};
+}
+
+TableSimulation::SeatAction TableSimulation::decide(int seat, Street street, int raises) {
+    if (seat == HERO_SEAT) return decideHero(seat, street, raises);
+    return decideOpponent(seat, street, raises);
+}
+
+TableSimulation::SeatAction TableSimulation::decideHero(int seat, Street street, int raises) {
+    SHARKWAVE_PROFILE_SCOPE(HeroDecision);
+    const SeatState& s = seats_[seat];
+    int32_t facing = currentBet_ - s.streetBet;
+    int32_t bb = config_.bb;
+
+    if (street == Street::Preflop) {
+        Card c1 = cardFromIndex(s.hole[0]);
+        Card c2 = cardFromIndex(s.hole[1]);
+        Position pos = s.position;
+
+        if (raises <= 1) {
+            // Unopened: chart open, otherwise take the free check in the big blind
+            if (GtoCharts::shouldOpen(pos, c1, c2) ||
+                (pos == Position::BB && GtoCharts::should3bet(pos, c1, c2))) {
+                return betAction(seat, pos == Position::SB ? bb * 3 : bb * 5 / 2);
+            }
+            return {facing == 0 ? Action::Check : Action::Fold, 0};
+        }
+        if (raises == 2) {
+            if (GtoCharts::should3bet(pos, c1, c2)) return betAction(seat, currentBet_ * 3);
+            if (GtoCharts::shouldCall3bet(pos, c1, c2)) return {Action::Call, 0};
+            // Defend the big blind against small opens with a reasonable hand
+            if (pos == Position::BB && facing <= bb * 2 && GtoCharts::shouldOpen(Position::CO, c1, c2)) {
+                return {Action::Call, 0};
+            }
+            return {Action::Fold, 0};
+        }
+        if (GtoCharts::should4bet(pos, c1, c2)) return betAction(seat, currentBet_ * 5 / 2);
+        if (GtoCharts::should3bet(pos, c1, c2)) return {Action::Call, 0};
+        return {Action::Fold, 0};
+    }
+
+    Strength st = strength(seat);
+    int32_t pot = 0;
+    for (int i = 0; i < numSeats_; ++i) pot += seats_[i].invested;
+
+    if (facing == 0) {
+        if (st >= Strength::Strong) return betAction(seat, std::max(bb, pot * 2 / 3));
+        if (st == Strength::Draw && rng_.uniform() < 0.5) return betAction(seat, std::max(bb, pot / 2));
+        // Continuation bet the flop as the preflop raiser when few opponents remain
+        if (street == Street::Flop && preflopAggressor_ == seat && countInHand() <= 3 &&
+            rng_.uniform() < 0.5) {
+            return betAction(seat, std::max(bb, pot / 3));
+        }
+        return {Action::Check, 0};
+    }
+
+    double potOdds = static_cast<double>(facing) / static_cast<double>(pot + facing);
+    switch (st) {
+        case Strength::Monster:
+            return raises < 3 ? betAction(seat, currentBet_ * 3) : SeatAction{Action::Call, 0};
+        case Strength::Strong:
+            return {potOdds < 0.4 ? Action::Call : Action::Fold, 0};
+        case Strength::Medium:
+            return {potOdds < 0.3 ? Action::Call : Action::Fold, 0};
+        case Strength::Draw:
+            return {street != Street::River && potOdds < 0.3 ? Action::Call : Action::Fold, 0};
+        case Strength::Weak:
+            break;
+    }
+    return {Action::Fold, 0};
+}
+
+TableSimulation::SeatAction TableSimulation::decideOpponent(int seat, Street street, int raises) {
+    SHARKWAVE_PROFILE_SCOPE(OpponentAction);
+    const SeatState& s = seats_[seat];
+    int32_t facing = currentBet_ - s.streetBet;
+    int32_t bb = config_.bb;
+    Action passive = facing == 0 ? Action::Check : Action::Fold;
+    double r = rng_.uniform();
+
+    if (street == Street::Preflop) {
+        Card c1 = cardFromIndex(s.hole[0]);
+        Card c2 = cardFromIndex(s.hole[1]);
+        bool premium = GtoCharts::isPremium(c1, c2);
+        bool playable = false;
+        switch (config_.opponent) {
+            case OpponentType::Random:          playable = true; break;
+            case OpponentType::TightPassive:    playable = GtoCharts::shouldOpen(Position::UTG, c1, c2); break;
+            case OpponentType::LooseAggressive: playable = GtoCharts::shouldOpen(Position::BTN, c1, c2); break;
+            case OpponentType::CallingStation: {
+                int gap = std::abs(static_cast<int>(c1.rank()) - static_cast<int>(c2.rank()));
+                playable = GtoCharts::shouldOpen(Position::BTN, c1, c2) || c1.suit() == c2.suit() || gap <= 2;
+                break;
+            }
+        }
+
+        int32_t raiseTo = (raises <= 1) ? bb * 3 : currentBet_ * 3;
+        bool unopened = raises <= 1;
+
+        switch (config_.opponent) {
+            case OpponentType::Random:
+                if (r < 0.35) return {passive, 0};
+                if (r < 0.75) return {facing == 0 ? Action::Check : Action::Call, 0};
+                return betAction(seat, raiseTo);
+
+            case OpponentType::TightPassive:
+                if (premium) return betAction(seat, raiseTo);
+                if (playable && unopened && r < 0.6) return betAction(seat, raiseTo);
+                if (playable && facing <= s.stack / 10) return {facing == 0 ? Action::Check : Action::Call, 0};
+                return {passive, 0};
+
+            case OpponentType::LooseAggressive:
+                if (premium || (playable && (unopened ? r < 0.85 : r < 0.25))) return betAction(seat, raiseTo);
+                if (playable) return {facing == 0 ? Action::Check : Action::Call, 0};
+                if (r < 0.08) return betAction(seat, raiseTo);
+                return {passive, 0};
+
+            case OpponentType::CallingStation:
+                if (premium && r < 0.3) return betAction(seat, raiseTo);
+                if (playable || r < 0.3) return {facing == 0 ? Action::Check : Action::Call, 0};
+                return {passive, 0};
+        }
+        return {passive, 0};
+    }
+
+    Strength st = strength(seat);
+    int32_t pot = 0;
+    for (int i = 0; i < numSeats_; ++i) pot += seats_[i].invested;
+    int32_t betTo = std::max(bb, pot * 2 / 3);
+    int32_t raiseTo = currentBet_ * 3;
+
+    if (facing > 0) {
+        double potOdds = static_cast<double>(facing) / static_cast<double>(pot + facing);
+        switch (config_.opponent) {
+            case OpponentType::Random:
+                if (r < 0.35) return {Action::Fold, 0};
+                if (r < 0.75) return {Action::Call, 0};
+                return betAction(seat, raiseTo);
+
+            case OpponentType::TightPassive:
+                if (st == Strength::Monster) return r < 0.3 ? betAction(seat, raiseTo) : SeatAction{Action::Call, 0};
+                if (st == Strength::Strong) return {Action::Call, 0};
+                if (st == Strength::Medium && potOdds < 0.25) return {Action::Call, 0};
+                if (st == Strength::Draw && potOdds < 0.2) return {Action::Call, 0};
+                return {Action::Fold, 0};
+
+            case OpponentType::LooseAggressive:
+                if (st >= Strength::Strong) return r < 0.4 ? betAction(seat, raiseTo) : SeatAction{Action::Call, 0};
+                if (st != Strength::Weak) return {Action::Call, 0};
+                if (r < 0.15) return betAction(seat, raiseTo);
+                if (r < 0.40) return {Action::Call, 0};
+                return {Action::Fold, 0};
+
+            case OpponentType::CallingStation:
+                if (st == Strength::Monster && r < 0.2) return betAction(seat, raiseTo);
+                if (st == Strength::Weak && r < 0.1) return {Action::Fold, 0};
+                return {Action::Call, 0};
+        }
+        return {Action::Fold, 0};
+    }
+
+    switch (config_.opponent) {
+        case OpponentType::Random:
+            return r < 0.40 ? SeatAction{Action::Check, 0} : betAction(seat, betTo);
+        case OpponentType::TightPassive:
+            return (st >= Strength::Strong && r < 0.6) ? betAction(seat, betTo) : SeatAction{Action::Check, 0};
+        case OpponentType::LooseAggressive:
+            if (r < 0.15) return {Action::Check, 0};
+            return (st != Strength::Weak || r < 0.55) ? betAction(seat, betTo) : SeatAction{Action::Check, 0};
+        case OpponentType::CallingStation:
+            return ((st == Strength::Monster && r < 0.5) || r < 0.1) ? betAction(seat, betTo)
+                                                                     : SeatAction{Action::Check, 0};
+    }
+    return {Action::Check, 0};
+}
+
+void TableSimulation::playHands(int count) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        playHand();
+    }
+    elapsedSeconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    elapsedHands_ += count;
+}
+
+double TableSimulation::handsPerSecond() const {
+    return elapsedSeconds_ > 0.0 ? elapsedHands_ / elapsedSeconds_ : 0.0;
+}
+
+void TableSimulation::setCheckpoint(std::string path, int everyHands) {
+    checkpointPath_ = std::move(path);
+    checkpointEvery_ = everyHands;
+}
+
+TableConfig TableSimulation::configFrom(const Checkpoint& checkpoint) {
+    TableConfig config;
+    config.seats = static_cast<int>(checkpoint.getInt("config.seats"));
+    config.numHands = static_cast<int>(checkpoint.getInt("config.hands"));
+    config.opponent = static_cast<OpponentType>(checkpoint.getInt("config.opponent"));
+    config.sb = static_cast<int>(checkpoint.getInt("config.sb"));
+    config.bb = static_cast<int>(checkpoint.getInt("config.bb"));
+    config.minStackBB = static_cast<int>(checkpoint.getInt("config.min_stack_bb"));
+    config.maxStackBB = static_cast<int>(checkpoint.getInt("config.max_stack_bb"));
+    config.seed = checkpoint.getUint("config.seed");
+    return config;
+}
+
+void TableSimulation::saveState(Checkpoint& checkpoint) const {
+    checkpoint.setInt("config.seats", numSeats_);
+    checkpoint.setInt("config.hands", config_.numHands);
+    checkpoint.setInt("config.opponent", static_cast<int>(config_.opponent));
+    checkpoint.setInt("config.sb", config_.sb);
+    checkpoint.setInt("config.bb", config_.bb);
+    checkpoint.setInt("config.min_stack_bb", config_.minStackBB);
+    checkpoint.setInt("config.max_stack_bb", config_.maxStackBB);
+    checkpoint.setUint("config.seed", config_.seed);
+    checkpoint.setDouble("config.target_ci", targetCi_);
+
+    // The deck is reshuffled in place, so its order carries over between hands
+    std::array<uint64_t, 4> rngState = rng_.state();
+    for (size_t i = 0; i < rngState.size(); ++i) {
+        checkpoint.setUint(std::format("rng{}", i), rngState[i]);
+    }
+    for (size_t i = 0; i < deck_.size(); ++i) {
+        checkpoint.setInt(std::format("deck{}", i), deck_[i]);
+    }
+    checkpoint.setInt("button", button_);
+    for (int s = 0; s < numSeats_; ++s) {
+        checkpoint.setInt(std::format("stack{}", s), seats_[s].stack);
+    }
+    stats_.save(checkpoint);
+}
+
+void TableSimulation::restoreState(const Checkpoint& checkpoint) {
+    targetCi_ = checkpoint.getDouble("config.target_ci");
+
+    std::array<uint64_t, 4> rngState;
+    for (size_t i = 0; i < rngState.size(); ++i) {
+        rngState[i] = checkpoint.getUint(std::format("rng{}", i));
+    }
+    rng_.setState(rngState);
+    for (size_t i = 0; i < deck_.size(); ++i) {
+        deck_[i] = static_cast<uint8_t>(checkpoint.getInt(std::format("deck{}", i)));
+    }
+    button_ = static_cast<int>(checkpoint.getInt("button"));
+    for (int s = 0; s < numSeats_; ++s) {
+        seats_[s].stack = static_cast<int32_t>(checkpoint.getInt(std::format("stack{}", s)));
+    }
+    stats_.load(checkpoint);
+}
+
+void TableSimulation::writeCheckpoint() {
+    Checkpoint checkpoint;
+    saveState(checkpoint);
+    if (!checkpoint.save(checkpointPath_)) {
+        std::cerr << "\nWarning: could not write checkpoint " << checkpointPath_ << "\n";
+    }
+}
+
+void TableSimulation::run() {
+    std::cout << "\n=== SHARKWAVE TABLE SIMULATION ===\n";
+    std::cout << "Running " << config_.numHands << " hands, " << numSeats_ << "-handed vs "
+              << Simulation::opponentToString(config_.opponent) << " opponents";
+    if (targetCi_ > 0.0) {
+        std::cout << " (stopping at +/-" << targetCi_ << " BB/100)";
+    }
+    std::cout << "...\n\n";
+
+    elapsedSeconds_ = 0.0;
+    elapsedHands_ = 0;
+
+    // Check progress in blocks so the per-hand loop stays tight
+    constexpr int blockHands = 10000;
+    constexpr int minHandsForCi = 1000;
+    const bool checkpointing = !checkpointPath_.empty() && checkpointEvery_ > 0;
+    int played = handsPlayed();
+    if (played > 0) {
+        std::cout << "Resuming after " << played << " hands.\n";
+    }
+    while (played < config_.numHands) {
+        int block = std::min(blockHands, config_.numHands - played);
+        playHands(block);
+        if (checkpointing && (played + block) / checkpointEvery_ != played / checkpointEvery_) {
+            writeCheckpoint();
+        }
+        played += block;
+
+        std::cout << "  " << played << " hands completed...\r" << std::flush;
+
+        if (targetCi_ > 0.0 && played >= minHandsForCi &&
+            stats_.profit.ci95() / config_.bb * 100.0 <= targetCi_) {
+            std::cout << "\n\nTarget CI reached after " << played << " hands.";
+            config_.numHands = played;  // A resumed checkpoint of this run has nothing left to play
+            break;
+        }
+    }
+
+    if (checkpointing) writeCheckpoint();
+    std::cout << "\n\nSimulation complete!\n";
+}
+
+void TableSimulation::printResults() {
+    Simulation::printStats(stats_, config_.bb);
+    std::cout << std::format("Speed:            {:.0f} hands/sec ({:.2f}s)\n\n",
+                             handsPerSecond(), elapsedSeconds_);
+}
+
+} // namespace sharkwave
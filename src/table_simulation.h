@@ -0,0 +1,132 @@
+#pragma once
+
+#include "card.h"
+#include "checkpoint.h"
+#include "game_session.h"
+#include "simulation.h"
+#include "rng.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace sharkwave {
+
+struct TableConfig {
+    int seats = 6;              // 2-9
+    int numHands = 100000;
+    OpponentType opponent = OpponentType::Random;   // Every seat but hero's
+    int sb = 5;
+    int bb = 10;
+    int minStackBB = 100;
+    int maxStackBB = 200;
+    uint64_t seed = 0;          // 0 = seed from std::random_device
+};
+
+// Everything one seat needs during a hand, packed into 16 bytes so a full
+// 9-seat table is a couple of cache lines
+struct SeatState {
+    int32_t stack;
+    int32_t streetBet;      // Chips committed on the current street
+    int32_t invested;       // Chips committed this hand (drives side pots)
+    uint8_t hole[2];        // cardIndex() of each hole card
+    SeatStatus status;
+    Position position;
+};
+static_assert(sizeof(SeatState) == 16);
+
+// Multi-way ring game: hero in seat 0, button rotating every hand, no-limit
+// betting with all-ins and side pots. Players decide from cheap hand-strength
+// buckets (no Monte Carlo) so the table runs at hundreds of thousands of
+// hands per second.
+class TableSimulation {
+public:
+    static constexpr int MIN_SEATS = 2;
+    static constexpr int MAX_SEATS = 9;
+    static constexpr int HERO_SEAT = 0;
+
+    explicit TableSimulation(const TableConfig& config);
+
+    void run();
+    void printResults();
+    void playHands(int count);
+
+    // Stop early once the 95% CI half-width of BB/100 is at or below this (0 = off)
+    void setTargetCi(double bbPer100) { targetCi_ = bbPer100; }
+
+    const SimStats& stats() const { return stats_; }
+    int handsPlayed() const { return static_cast<int>(stats_.profit.count()); }
+    double handsPerSecond() const;
+
+    // Same checkpoint/resume contract as Simulation; checkpoints land on the
+    // first progress block boundary after every `everyHands` hands
+    void setCheckpoint(std::string path, int everyHands);
+    void saveState(Checkpoint& checkpoint) const;
+    void restoreState(const Checkpoint& checkpoint);
+    static TableConfig configFrom(const Checkpoint& checkpoint);
+
+private:
+    // Postflop hand-strength buckets, weakest first
+    enum class Strength : uint8_t {
+        Weak,
+        Draw,
+        Medium,     // Pair made with a hole card, below top pair
+        Strong,     // Top pair or overpair
+        Monster     // Two pair or better made with hole cards
+    };
+
+    struct SeatAction {
+        Action action;
+        int32_t amount;     // Street total to raise/bet to; ignored otherwise
+    };
+
+    void playHand();
+    void startHand();
+    void assignPositions();
+    void dealBoard(int cards);
+    void commit(int seat, int32_t chips);
+    bool bettingRound(Street street);   // true once only one player is left
+    void showdown();
+    void awardPot(int winner);
+
+    SeatAction decide(int seat, Street street, int raises);
+    SeatAction decideHero(int seat, Street street, int raises);
+    SeatAction decideOpponent(int seat, Street street, int raises);
+    Strength strength(int seat) const;
+    SeatAction betAction(int seat, int32_t toAmount) const;
+
+    int nextSeat(int seat) const { return seat + 1 == numSeats_ ? 0 : seat + 1; }
+    int countStatus(SeatStatus status) const;
+    int countInHand() const;
+    void writeCheckpoint();
+
+    TableConfig config_;
+    int numSeats_;
+    double targetCi_;
+
+    std::array<SeatState, MAX_SEATS> seats_;
+    std::array<uint8_t, 52> deck_;
+    int deckIndex_;
+
+    CardMask boardMask_;
+    int boardCount_;
+
+    int button_;
+    int sbSeat_, bbSeat_;
+    int32_t currentBet_;
+    int32_t lastRaise_;
+    int preflopAggressor_;
+
+    // Hero bookkeeping for the current hand
+    int32_t heroStartStack_;
+    Street heroEndStreet_;
+
+    Rng rng_;
+    SimStats stats_;
+    double elapsedSeconds_;
+    int elapsedHands_;      // Hands behind elapsedSeconds_ (excludes any resumed ones)
+
+    std::string checkpointPath_;
+    int checkpointEvery_;
+};
+
+} // namespace sharkwave
@@ -0,0 +1,172 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace sharkwave {
+
+namespace {
+    // Which pool (if any) the current thread works for, and its queue index
+    thread_local const ThreadPool* tlsPool = nullptr;
+    thread_local size_t tlsIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+    : queued_(0)
+    , unfinished_(0)
+    , nextQueue_(0)
+    , stop_(false)
+{
+    if (threads == 0) {
+        threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    queues_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+
+    threads_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard lock(sleepMutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_) {
+        t.join();
+    }
+}
+
+size_t ThreadPool::currentIndex() const {
+    return tlsPool == this ? tlsIndex : queues_.size();
+}
+
+void ThreadPool::submit(Task task) {
+    size_t index = currentIndex();
+    if (index == queues_.size()) {
+        index = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+
+    // Counted before it's visible: nobody can pop the task, run it and
+    // count it finished before it has been counted at all
+    {
+        std::lock_guard lock(queues_[index]->mutex);
+        unfinished_.fetch_add(1);
+        queued_.fetch_add(1);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    // A worker checks queued_ under sleepMutex_ before it sleeps, so taking
+    // it here means none can miss this wake-up
+    {
+        std::lock_guard lock(sleepMutex_);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::tryPop(size_t index, Task& task) {
+    if (queued_.load() == 0) return false;
+
+    // Own deque first, newest task (cache-warm)
+    if (index < queues_.size()) {
+        WorkQueue& own = *queues_[index];
+        std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Steal the oldest task from someone else
+    size_t n = queues_.size();
+    size_t start = (index < n) ? index + 1 : 0;
+    for (size_t k = 0; k < n; ++k) {
+        WorkQueue& victim = *queues_[(start + k) % n];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(Task& task) {
+    task();
+    task = nullptr;
+    if (unfinished_.fetch_sub(1) == 1) {
+        std::lock_guard lock(sleepMutex_);
+        idle_.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    tlsPool = this;
+    tlsIndex = index;
+
+    Task task;
+    while (true) {
+        if (tryPop(index, task)) {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        if (stop_ && queued_.load() == 0) return;
+    }
+}
+
+void ThreadPool::wait() {
+    size_t index = currentIndex();
+    Task task;
+    while (unfinished_.load() > 0) {
+        if (tryPop(index, task)) {
+            runTask(task);
+            continue;
+        }
+        std::unique_lock lock(sleepMutex_);
+        idle_.wait_for(lock, std::chrono::milliseconds(1),
+                       [this] { return unfinished_.load() == 0; });
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, const std::function<void(size_t)>& fn,
+                             size_t grain) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(1, grain);
+
+    size_t chunks = (end - begin + grain - 1) / grain;
+    std::atomic<size_t> remaining(chunks);
+
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t lo = begin + c * grain;
+        size_t hi = std::min(end, lo + grain);
+        submit([&fn, &remaining, lo, hi] {
+            for (size_t i = lo; i < hi; ++i) fn(i);
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    // Help out until our own chunks are done
+    size_t index = currentIndex();
+    Task task;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (tryPop(index, task)) {
+            runTask(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace sharkwave
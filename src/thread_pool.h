@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sharkwave {
+
+// Fixed-size worker pool with per-worker deques and work stealing.
+// Tasks submitted from a worker go to that worker's own deque (popped LIFO);
+// idle workers steal the oldest task from other deques.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(size_t threads = 0);  // 0 = hardware concurrency
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return threads_.size(); }
+
+    void submit(Task task);
+
+    // Block until every submitted task has finished. The caller runs
+    // queued tasks while it waits.
+    void wait();
+
+    // Run fn(i) for every i in [begin, end) in chunks of `grain` and block
+    // until done. Safe to call from inside a task.
+    void parallelFor(size_t begin, size_t end, const std::function<void(size_t)>& fn,
+                     size_t grain = 1);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool tryPop(size_t index, Task& task);   // index == size() for non-worker threads
+    void runTask(Task& task);
+    size_t currentIndex() const;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::atomic<size_t> queued_;      // Tasks sitting in a deque
+    std::atomic<size_t> unfinished_;  // Queued plus running
+    std::atomic<size_t> nextQueue_;
+    bool stop_;
+};
+
+} // namespace sharkwave
@@ -0,0 +1,178 @@
+#include "tuner.h"
+#include "rng.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <format>
+#include <mutex>
+#include <random>
+
+namespace sharkwave {
+
+namespace {
+    constexpr int kBigBlind = SimConfig{}.bb;
+
+    double toBbPer100(double chipsPerHand) { return chipsPerHand / kBigBlind * 100.0; }
+
+    // Paired per-chunk difference between two candidates that played the same hands
+    RunningStats pairedGain(const std::vector<double>& candidate, const std::vector<double>& incumbent) {
+        RunningStats gain;
+        for (size_t k = 0; k < candidate.size(); ++k) gain.add(candidate[k] - incumbent[k]);
+        return gain;
+    }
+
+    double mean(const std::vector<double>& scores) {
+        RunningStats s;
+        for (double x : scores) s.add(x);
+        return s.mean();
+    }
+
+    const std::array<Tuner::Param, 12> kParams = {{
+        {"flop_value_equity",       &StrategyParams::flopValueEquity,      0.50, 0.95},
+        {"cbet_equity_dry",         &StrategyParams::cbetEquityDry,        0.15, 0.70},
+        {"cbet_equity_wet",         &StrategyParams::cbetEquityWet,        0.20, 0.75},
+        {"cbet_equity_very_wet",    &StrategyParams::cbetEquityVeryWet,    0.25, 0.80},
+        {"flop_fold_equity",        &StrategyParams::flopFoldEquity,       0.05, 0.50},
+        {"turn_value_equity",       &StrategyParams::turnValueEquity,      0.50, 0.95},
+        {"barrel_equity_dry",       &StrategyParams::barrelEquityDry,      0.25, 0.85},
+        {"barrel_equity_wet",       &StrategyParams::barrelEquityWet,      0.30, 0.90},
+        {"barrel_equity_very_wet",  &StrategyParams::barrelEquityVeryWet,  0.30, 0.90},
+        {"turn_fold_equity",        &StrategyParams::turnFoldEquity,       0.05, 0.55},
+        {"river_thin_value_equity", &StrategyParams::riverThinValueEquity, 0.35, 0.85},
+        {"bluff_frequency",         &StrategyParams::bluffFrequency,       0.00, 1.00},
+    }};
+}
+
+std::span<const Tuner::Param> Tuner::parameters() {
+    return kParams;
+}
+
+Tuner::Tuner(TuneConfig config)
+    : config_(std::move(config))
+    , seed_(config_.seed != 0 ? config_.seed : std::random_device{}())
+    , chunks_(std::max(2, config_.handsPerEval / std::max(1, config_.chunkHands)))
+{
+}
+
+std::vector<TuneResult> Tuner::run(std::ostream* progress) {
+    ThreadPool pool(config_.threads);
+    std::vector<TuneResult> results(config_.opponents.size());
+    std::mutex progressMutex;
+
+    // Opponents are independent searches; their candidate batches share the pool
+    pool.parallelFor(0, config_.opponents.size(), [&](size_t i) {
+        results[i] = tune(config_.opponents[i], pool);
+        if (progress) {
+            std::lock_guard lock(progressMutex);
+            *progress << std::format("  {:<17} {:+.2f} BB/100 after {} evaluations\n",
+                                     Simulation::opponentToString(results[i].opponent),
+                                     results[i].tunedBbPer100 - results[i].baselineBbPer100,
+                                     results[i].evaluations);
+        }
+    });
+    return results;
+}
+
+TuneResult Tuner::tune(OpponentType opponent, ThreadPool& pool) const {
+    StrategyParams best;
+    ChunkScores bestScores = evaluate(opponent, {best}, pool).front();
+    const ChunkScores baselineScores = bestScores;
+    int evaluations = 1;
+
+    double step = config_.initialStep;
+    for (int round = 0; round < config_.rounds; ++round) {
+        for (const Param& param : parameters()) {
+            double current = best.*param.field;
+            std::vector<StrategyParams> candidates;
+            for (double value : {current - step, current + step}) {
+                value = std::clamp(value, param.min, param.max);
+                if (value == current) continue;
+                candidates.push_back(best);
+                candidates.back().*param.field = value;
+            }
+            if (candidates.empty()) continue;
+
+            std::vector<ChunkScores> scores = evaluate(opponent, candidates, pool);
+            evaluations += static_cast<int>(candidates.size());
+
+            // Only move when the paired gain clears one standard error, so
+            // noise alone rarely drags a parameter around
+            int winner = -1;
+            double winnerGain = 0.0;
+            for (size_t c = 0; c < candidates.size(); ++c) {
+                RunningStats gain = pairedGain(scores[c], bestScores);
+                if (gain.mean() > gain.standardError() && gain.mean() > winnerGain) {
+                    winner = static_cast<int>(c);
+                    winnerGain = gain.mean();
+                }
+            }
+            if (winner >= 0) {
+                best = candidates[winner];
+                bestScores = std::move(scores[winner]);
+            }
+        }
+        step /= 2.0;
+    }
+
+    RunningStats gain = pairedGain(bestScores, baselineScores);
+    return TuneResult{opponent, best, toBbPer100(mean(baselineScores)), toBbPer100(mean(bestScores)),
+                      toBbPer100(gain.ci95()), evaluations};
+}
+
+std::vector<Tuner::ChunkScores> Tuner::evaluate(OpponentType opponent,
+                                                const std::vector<StrategyParams>& candidates,
+                                                ThreadPool& pool) const {
+    std::vector<ChunkScores> scores(candidates.size(), ChunkScores(chunks_));
+    const size_t chunks = static_cast<size_t>(chunks_);
+
+    pool.parallelFor(0, candidates.size() * chunks, [&](size_t task) {
+        size_t c = task / chunks;
+        size_t k = task % chunks;
+
+        // The chunk index alone picks the seed: that's what makes the hands common
+        SimConfig simConfig;
+        simConfig.numHands = config_.chunkHands;
+        simConfig.opponent = opponent;
+        simConfig.seed = splitmix64(seed_ ^ splitmix64(k));
+        simConfig.equityIterations = config_.equityIterations;
+
+        Simulation sim(simConfig);
+        sim.setStrategy(candidates[c]);
+        sim.playHands(config_.chunkHands);
+        scores[c][k] = sim.stats().profit.mean();
+    });
+    return scores;
+}
+
+void Tuner::writeReport(std::ostream& out, const std::vector<TuneResult>& results) {
+    for (const TuneResult& result : results) {
+        out << std::format("\n=== {} ===\n", Simulation::opponentToString(result.opponent));
+        out << std::format("BB/100:  {:.2f} -> {:.2f}  (gain {:+.2f} +/- {:.2f}, paired 95% CI)\n",
+                           result.baselineBbPer100, result.tunedBbPer100,
+                           result.tunedBbPer100 - result.baselineBbPer100, result.gainCi95);
+        out << std::format("Candidates evaluated: {}\n\n", result.evaluations);
+
+        const StrategyParams defaults;
+        for (const Param& param : parameters()) {
+            double before = defaults.*param.field;
+            double after = result.params.*param.field;
+            out << std::format("  {:<24} {:.3f} -> {:.3f}{}\n", param.name, before, after,
+                               after != before ? "  *" : "");
+        }
+    }
+    out << "\n";
+}
+
+void Tuner::writeCsv(std::ostream& out, const std::vector<TuneResult>& results) {
+    out << "opponent,parameter,default,tuned\n";
+    const StrategyParams defaults;
+    for (const TuneResult& result : results) {
+        for (const Param& param : parameters()) {
+            out << std::format("{},{},{:.4f},{:.4f}\n", Simulation::opponentToString(result.opponent),
+                               param.name, defaults.*param.field, result.params.*param.field);
+        }
+    }
+}
+
+} // namespace sharkwave
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "decision_engine.h"
+#include "simulation.h"
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <vector>
+
+namespace sharkwave {
+
+class ThreadPool;
+
+struct TuneConfig {
+    std::vector<OpponentType> opponents;   // Each one is tuned separately
+    int handsPerEval = 20000;   // Hands behind every candidate's score
+    int chunkHands = 1000;      // Hands per task; chunk k deals the same hands to every candidate
+    int rounds = 3;             // Coordinate-descent passes; the step halves after each
+    double initialStep = 0.05;
+    uint64_t seed = 0;          // 0 = random
+    size_t threads = 0;         // 0 = hardware concurrency
+    int equityIterations = SimConfig{}.equityIterations;
+};
+
+struct TuneResult {
+    OpponentType opponent;
+    StrategyParams params;
+    double baselineBbPer100;
+    double tunedBbPer100;
+    double gainCi95;            // Half-width of the paired tuned-minus-baseline gain (BB/100)
+    int evaluations;
+};
+
+// Coordinate descent over StrategyParams using common random numbers: every
+// candidate replays the same seeded hands, so the difference between two
+// candidates is measured hand-for-hand and is far less noisy than either
+// candidate's BB/100 on its own.
+class Tuner {
+public:
+    struct Param {
+        const char* name;
+        double StrategyParams::* field;
+        double min;
+        double max;
+    };
+
+    static std::span<const Param> parameters();
+
+    explicit Tuner(TuneConfig config);
+    std::vector<TuneResult> run(std::ostream* progress = nullptr);
+
+    static void writeReport(std::ostream& out, const std::vector<TuneResult>& results);
+    static void writeCsv(std::ostream& out, const std::vector<TuneResult>& results);
+
+private:
+    using ChunkScores = std::vector<double>;    // Mean chips/hand of each chunk
+
+    TuneResult tune(OpponentType opponent, ThreadPool& pool) const;
+    std::vector<ChunkScores> evaluate(OpponentType opponent, const std::vector<StrategyParams>& candidates,
+                                      ThreadPool& pool) const;
+
+    TuneConfig config_;
+    uint64_t seed_;
+    int chunks_;
+};
+
+} // namespace sharkwave